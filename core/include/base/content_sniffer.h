@@ -0,0 +1,30 @@
+/**
+ * @file content_sniffer.h
+ * @brief Magic-byte based file type detection
+ */
+#pragma once
+
+#include <cstddef>
+#include "./base/file_properties.h"
+
+namespace content_sniffer {
+
+    /**
+     * @brief Number of leading bytes read once per file for type detection
+     */
+    constexpr std::size_t probe_size = 4096;
+
+    /**
+     * @brief Match the leading bytes of a file against the known signatures
+     *
+     * On a match the category and type enums of the probe are overwritten,
+     * otherwise the probe is left untouched so the extension-based guess stays.
+     *
+     * @param data Leading bytes of the file
+     * @param size Number of bytes available
+     * @param probe Probe to update
+     * @return True if a signature matched
+     */
+    bool sniff(const unsigned char* data, std::size_t size, file_properties::file_type_probe& probe);
+
+}
@@ -1,10 +1,20 @@
 #pragma once
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 #include <filesystem>
 #include <unordered_map>
+#include "./base/file_io.h"
 #include "./base/file_properties.h"
+#include "./base/metadata_policy.h"
+#include "./base/metadata_table.h"
+
+namespace thread_pool {
+    class thread_pool_class;
+}
 
 namespace file_handler {
 
@@ -20,20 +30,63 @@ namespace file_handler {
         std::vector<std::string> selected_properties;
         std::filesystem::path output_directory;
         std::unordered_map<std::string, std::string> overwrite_metadata;
+        file_hasher::hash_algorithm hash_algorithm {file_hasher::hash_algorithm::FAST_128};
+        // Decides which keys CLEAN removes when selected_properties is empty, compiled once and shared
+        std::shared_ptr<const metadata_policy::policy_class> policy;
+        // Workers for parallel work inside one file, such as embedded images, nullptr runs it on the calling thread
+        std::shared_ptr<thread_pool::thread_pool_class> worker_pool;
+        // zlib level for entries a rewrite compresses again, 0 stores, 1 is fastest and 9 smallest, -1 zlib's default
+        int compression_level {-1};
     };
 
+    /**
+     * @brief Immutable options shared by every handler of a call
+     *
+     * Handlers keep a reference instead of a copy, so a batch allocates the
+     * selected properties and the overwrite template once whatever its size.
+     */
+    using shared_options = std::shared_ptr<const operation_options>;
+
+    /**
+     * @brief Validate options and freeze them for sharing
+     *
+     * Empty selected properties are dropped, the output directory is
+     * normalized and the compression level is clamped to what zlib takes,
+     * so handlers can use them without further checks.
+     *
+     * @param options Options to take over
+     * @return Shared immutable options
+     */
+    shared_options make_options(operation_options options);
+
     struct operation_result {
         bool success;
         std::string message;
         std::vector<std::string> warnings;
-        std::unordered_map<std::string, std::string> metadata;
+        // Interned keys and arena-held values, iterates like a map of key to value view
+        metadata_table::metadata_map metadata;
+    };
+
+    /**
+     * @brief In-memory input and output used instead of the file at the handler path
+     *
+     * The input is not copied and must outlive the handler. Rewritten content
+     * is moved into output when the processor commits it.
+     */
+    struct buffer_binding {
+        const unsigned char* data {nullptr};
+        std::size_t size {0};
+        std::vector<unsigned char>* output {nullptr};
     };
 
 
     class file_handler_class : public file_properties::file_properties_class {
     protected:
         operation_type type {operation_type::READ};
-        operation_options options;
+        shared_options options_holder;
+        const operation_options& options;
+        buffer_binding buffers;
+        file_io::commit_batch* output_batch {nullptr};
         virtual operation_result check_prerequisites() {
             return {true, "",{}, {}};
         }
@@ -53,13 +106,115 @@ namespace file_handler {
             return {false, "Operation not supported", {}, {}};
         }
 
+        /**
+         * @brief Check if the handler works on a memory buffer instead of a file
+         */
+        [[nodiscard]] bool in_memory() const { return buffers.data != nullptr; }
+
+        /**
+         * @brief Open the input for reading with pread, or over the bound buffer
+         * @throws std::system_error if the file cannot be opened
+         */
+        [[nodiscard]] std::unique_ptr<file_io::byte_source> open_input() const;
+
+        /**
+         * @brief Map the input into memory, or wrap the bound buffer
+         *
+         * The bytes are available through get_data() for libraries reading from memory.
+         *
+         * @throws std::system_error if the file cannot be mapped
+         */
+        [[nodiscard]] std::unique_ptr<file_io::byte_source> map_input() const;
+
+        /**
+         * @brief Get the path rewritten content is written to
+         *
+         * CLEAN and OVERWRITE write into options.output_directory when it is set
+         * and leave the source untouched, otherwise the file is replaced.
+         *
+         * @return Path of the output file
+         */
+        [[nodiscard]] std::filesystem::path get_output_path() const;
+
+        /**
+         * @brief Open the destination of rewritten content
+         *
+         * Files are written to a temporary file in the directory of the output
+         * path that replaces it on commit, buffers are collected in memory and
+         * moved to the bound output on commit.
+         *
+         * @throws std::system_error if the temporary file cannot be created
+         */
+        [[nodiscard]] std::unique_ptr<file_io::byte_sink> open_output() const;
+
+        /**
+         * @brief Write the input with some byte ranges replaced
+         *
+         * When the output is the input file itself only the patched bytes are
+         * written in place, otherwise the input is copied to the output around
+         * the patches. Mappings of the input must be released first.
+         *
+         * @param patches Ranges to replace
+         * @throws std::system_error if the output cannot be written
+         */
+        void commit_patches(const std::vector<file_io::byte_patch>& patches) const;
+
+        /**
+         * @brief Write the input with everything from an offset on replaced
+         *
+         * When the output is the input file itself the file is truncated at
+         * offset and the tail appended, otherwise the bytes before offset are
+         * copied to the output followed by the tail.
+         *
+         * @param offset Offset in the input where the tail starts
+         * @param tail Replacement for the input from offset on
+         * @throws std::system_error if the output cannot be written
+         */
+        void commit_tail(std::uint64_t offset, const std::vector<unsigned char>& tail) const;
+
+        /**
+         * @brief Check if only selected properties are to be removed
+         *
+         * Properties are selected by options.selected_properties, or by
+         * options.policy when no properties are listed.
+         */
+        [[nodiscard]] bool has_selection() const { return !options.selected_properties.empty() || options.policy != nullptr; }
+
+        /**
+         * @brief Check if a metadata key is selected for removal
+         * @param key Key as reported by read_metadata
+         * @return True if any selected key or pattern matches, or the policy drops the key
+         */
+        [[nodiscard]] bool is_selected(const std::string& key) const;
+
+        void init_file_hash() const override;
+
     public:
-        file_handler_class(const std::string& path, operation_type type, const operation_options& opts);
+        file_handler_class(const std::string& path, operation_type type, shared_options opts,
+                           file_properties::file_type_probe probe = {}, buffer_binding buffers = {});
         ~file_handler_class() override;
         operation_result execute_operation();
 
+        /**
+         * @brief Hand written files to a batch instead of flushing each on commit
+         * @param batch Batch that flushes and renames the output, nullptr to commit directly
+         */
+        void set_commit_batch(file_io::commit_batch* batch) { output_batch = batch; }
+
     };
 
+    /**
+     * @brief Match a metadata key against a key pattern
+     *
+     * '*' matches any run of characters and '?' matches one character, anything
+     * else must be equal, so a pattern without wildcards selects a single key.
+     *
+     * @param pattern Key or key pattern, e.g. "EXIF.Exif.GPSInfo.*"
+     * @param key Key as reported by read_metadata
+     * @return True if the pattern matches the whole key
+     */
+    bool match_key_pattern(const std::string& pattern, const std::string& key);
+
     /**
      * @brief Create appropriate file handler for the given file
      *
@@ -74,4 +229,34 @@ namespace file_handler {
         const operation_options& options
     );
 
+    /**
+     * @brief Create appropriate file handler for the given file without copying the options
+     *
+     * @param file_path Path to the file
+     * @param op_type Operation type
+     * @param options Shared options from make_options
+     * @return Unique pointer to file handler
+     */
+    std::unique_ptr<file_handler_class> create_handler(
+        const std::string& file_path,
+        operation_type op_type,
+        const shared_options& options
+    );
+
+    /**
+     * @brief Create appropriate file handler for content held in memory
+     *
+     * @param name File name or extension used when the content does not identify the type
+     * @param buffers Input buffer and output vector
+     * @param op_type Operation type
+     * @param options Shared options from make_options
+     * @return Unique pointer to file handler, nullptr if the type is not supported
+     */
+    std::unique_ptr<file_handler_class> create_buffer_handler(
+        const std::string& name,
+        const buffer_binding& buffers,
+        operation_type op_type,
+        const shared_options& options
+    );
+
 }
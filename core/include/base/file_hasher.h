@@ -0,0 +1,40 @@
+/**
+ * @file file_hasher.h
+ * @brief Streaming file hashing with constant memory use
+ */
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+namespace file_hasher {
+
+    /**
+     * @brief Hash algorithms supported for file identification
+     */
+    enum class hash_algorithm {
+        FAST_128,   // MurmurHash3 x64 128-bit, non-cryptographic
+        SHA256      // SHA-256, cryptographic
+    };
+
+    /**
+     * @brief Hash a file by streaming it through a fixed-size buffer
+     *
+     * Memory use does not depend on the file size.
+     *
+     * @param path Path to the file
+     * @param algorithm Hash algorithm
+     * @return Lowercase hex digest, "error" if the file could not be read
+     */
+    std::string hash_file(const std::string& path, hash_algorithm algorithm = hash_algorithm::FAST_128);
+
+    /**
+     * @brief Hash a memory buffer
+     * @param data Pointer to the data
+     * @param size Size of the data in bytes
+     * @param algorithm Hash algorithm
+     * @return Lowercase hex digest
+     */
+    std::string hash_buffer(const void* data, std::size_t size, hash_algorithm algorithm = hash_algorithm::FAST_128);
+
+}
@@ -0,0 +1,315 @@
+/**
+ * @file file_io.h
+ * @brief Byte sources and sinks for streaming processors
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace file_io {
+
+    /**
+     * @brief Random-access source of bytes
+     */
+    class byte_source {
+    public:
+        virtual ~byte_source() = default;
+
+        /**
+         * @brief Get the total size of the source
+         * @return Size in bytes
+         */
+        [[nodiscard]] virtual std::uint64_t size() const = 0;
+
+        /**
+         * @brief Read bytes at an absolute offset
+         * @param offset Offset of the first byte
+         * @param buffer Output buffer
+         * @param length Maximum number of bytes to read
+         * @return Number of bytes read, smaller than length only at the end of the source
+         */
+        virtual std::size_t read_at(std::uint64_t offset, void* buffer, std::size_t length) const = 0;
+
+        /**
+         * @brief Get the bytes directly if the source is contiguous in memory
+         * @return Pointer to the first byte, or nullptr if the source must be read through read_at
+         */
+        [[nodiscard]] virtual const unsigned char* get_data() const { return nullptr; }
+
+        /**
+         * @brief Read exactly length bytes at an absolute offset
+         * @throws std::runtime_error if the source ends early
+         */
+        void read_exact(std::uint64_t offset, void* buffer, std::size_t length) const;
+    };
+
+    /**
+     * @brief Sequential sink of bytes
+     */
+    class byte_sink {
+    public:
+        virtual ~byte_sink() = default;
+
+        /**
+         * @brief Append bytes to the sink
+         * @param data Pointer to the data
+         * @param length Number of bytes
+         */
+        virtual void write(const void* data, std::size_t length) = 0;
+
+        /**
+         * @brief Append a range of a source without interpreting it
+         *
+         * The default implementation writes sources in memory directly and copies
+         * others through a fixed-size buffer, file sinks let the kernel copy
+         * between file descriptors where possible.
+         *
+         * @param source Source to copy from
+         * @param offset Offset of the first byte in the source
+         * @param length Number of bytes to copy
+         */
+        virtual void copy_from(const byte_source& source, std::uint64_t offset, std::uint64_t length);
+
+        /**
+         * @brief Publish the written data to its destination
+         *
+         * Output that is never committed is discarded by sinks with a destination.
+         */
+        virtual void commit() {}
+    };
+
+    /**
+     * @brief Read-only file opened for random access
+     */
+    class input_file : public byte_source {
+    public:
+        /**
+         * @brief Open a file for reading
+         * @param path Path to the file
+         * @throws std::system_error if the file cannot be opened
+         */
+        explicit input_file(const std::string& path);
+        ~input_file() override;
+
+        input_file(const input_file&) = delete;
+        input_file& operator=(const input_file&) = delete;
+
+        [[nodiscard]] std::uint64_t size() const override { return file_size; }
+        std::size_t read_at(std::uint64_t offset, void* buffer, std::size_t length) const override;
+
+        /**
+         * @brief Close the file before its destructor runs
+         */
+        void close();
+
+        /**
+         * @brief Get the native handle, a file descriptor or a Windows HANDLE
+         */
+        [[nodiscard]] std::intptr_t native_handle() const { return handle; }
+
+    private:
+        std::intptr_t handle;
+        std::uint64_t file_size {0};
+    };
+
+    /**
+     * @brief Group of written temporary files that are flushed and renamed together
+     *
+     * Each file is closed without a flush when it is added. flush() then
+     * flushes each of them, renames them over their targets and syncs every
+     * target directory once. Files that were never flushed are
+     * removed when the batch is destroyed. Adding is thread-safe.
+     */
+    class commit_batch {
+    public:
+        commit_batch() = default;
+        ~commit_batch();
+
+        commit_batch(const commit_batch&) = delete;
+        commit_batch& operator=(const commit_batch&) = delete;
+
+        /**
+         * @brief Take over a closed temporary file
+         * @param temp_path Path of the written temporary file
+         * @param target_path Path it replaces on flush
+         */
+        void add(std::string temp_path, std::string target_path);
+
+        /**
+         * @brief Flush all added files to disk and rename them over their targets
+         * @return Target paths that could not be replaced, with the reason
+         */
+        std::vector<std::pair<std::string, std::string>> flush();
+
+    private:
+        std::mutex mutex;
+        std::vector<std::pair<std::string, std::string>> pending;
+    };
+
+    /**
+     * @brief Temporary output file that atomically replaces its target on commit
+     *
+     * The temporary file is created in the directory of the target, so the final
+     * rename never crosses a filesystem. If the object is destroyed without a
+     * commit the temporary file is removed and the target stays untouched.
+     */
+    class output_file : public byte_sink {
+    public:
+        /**
+         * @brief Create a temporary file next to the target
+         * @param target_path Path the file will be renamed to on commit
+         * @param batch Batch that flushes and renames the file, nullptr to do it on commit
+         * @throws std::system_error if the temporary file cannot be created
+         */
+        explicit output_file(const std::string& target_path, commit_batch* batch = nullptr);
+        ~output_file() override;
+
+        output_file(const output_file&) = delete;
+        output_file& operator=(const output_file&) = delete;
+
+        void write(const void* data, std::size_t length) override;
+        void copy_from(const byte_source& source, std::uint64_t offset, std::uint64_t length) override;
+
+        /**
+         * @brief Flush the data to disk and rename the file over its target
+         *
+         * With a batch the file is only closed and handed over, the batch
+         * flushes and renames it later.
+         *
+         * @throws std::system_error on failure, the target is left untouched
+         */
+        void commit() override;
+
+        [[nodiscard]] const std::string& get_temp_path() const { return temp_path; }
+        [[nodiscard]] const std::string& get_target_path() const { return target_path; }
+
+    private:
+        void close_handle();
+
+        std::string target_path;
+        std::string temp_path;
+        std::intptr_t handle;
+        commit_batch* batch;
+        bool committed {false};
+    };
+
+    /**
+     * @brief Read-only memory mapping of a file
+     *
+     * Processors hand the mapping to their libraries instead of letting each of
+     * them open and buffer the file, so the data is shared with the page cache
+     * and only the pages that are touched are loaded. The file must not be
+     * truncated while mapped, changes are written through output_file instead.
+     */
+    class mapped_file : public byte_source {
+    public:
+        /**
+         * @brief Map a file into memory
+         * @param path Path to the file
+         * @throws std::system_error if the file cannot be opened or mapped
+         */
+        explicit mapped_file(const std::string& path);
+        ~mapped_file() override;
+
+        mapped_file(const mapped_file&) = delete;
+        mapped_file& operator=(const mapped_file&) = delete;
+
+        [[nodiscard]] std::uint64_t size() const override { return length; }
+        std::size_t read_at(std::uint64_t offset, void* buffer, std::size_t count) const override;
+
+        /**
+         * @brief Get the mapped bytes, nullptr for an empty file
+         */
+        [[nodiscard]] const unsigned char* get_data() const override { return view; }
+
+    private:
+        const unsigned char* view {nullptr};
+        std::uint64_t length {0};
+    };
+
+    /**
+     * @brief Source over a memory buffer, the buffer is not copied
+     */
+    class memory_source : public byte_source {
+    public:
+        memory_source(const void* data, std::size_t length)
+            : data(static_cast<const unsigned char*>(data)), length(length) {}
+
+        [[nodiscard]] std::uint64_t size() const override { return length; }
+        std::size_t read_at(std::uint64_t offset, void* buffer, std::size_t count) const override;
+
+        [[nodiscard]] const unsigned char* get_data() const override { return data; }
+
+    private:
+        const unsigned char* data;
+        std::size_t length;
+    };
+
+    /**
+     * @brief Replacement for a range of bytes of the same length
+     */
+    struct byte_patch {
+        std::uint64_t offset;
+        std::vector<unsigned char> data;
+    };
+
+    /**
+     * @brief Copy a source with some of its ranges replaced
+     *
+     * The ranges between patches are copied with copy_from, so file to file
+     * copies keep using the kernel copy path.
+     *
+     * @param source Source to copy from
+     * @param sink Destination
+     * @param patches Non-overlapping patches, in any order
+     * @throws std::runtime_error if a patch lies outside the source
+     */
+    void write_patched(const byte_source& source, byte_sink& sink, std::vector<byte_patch> patches);
+
+    /**
+     * @brief Overwrite ranges of an existing file without rewriting the rest
+     *
+     * The file keeps its size and the data is flushed before returning. Unlike
+     * output_file this is not atomic, a crash can leave some patches unwritten.
+     *
+     * @param path Path to the file
+     * @param patches Ranges to overwrite, all inside the file
+     * @throws std::system_error if the file cannot be written
+     */
+    void patch_file(const std::string& path, const std::vector<byte_patch>& patches);
+
+    /**
+     * @brief Replace everything from an offset to the end of an existing file
+     *
+     * The bytes before offset are not touched, so moving a trailer of a large
+     * file costs only the size of the trailer. Like patch_file this is not
+     * atomic, a crash can leave the old trailer partly overwritten.
+     *
+     * @param path Path to the file
+     * @param offset Offset where the new tail starts, at most the file size
+     * @param tail New content of the file from offset on, the file ends after it
+     * @throws std::system_error if the file cannot be written or truncated
+     */
+    void replace_tail(const std::string& path, std::uint64_t offset, const std::vector<unsigned char>& tail);
+
+    /**
+     * @brief Sink collecting the output in memory
+     */
+    class memory_sink : public byte_sink {
+    public:
+        void write(const void* data, std::size_t length) override;
+        void copy_from(const byte_source& source, std::uint64_t offset, std::uint64_t length) override;
+
+        [[nodiscard]] const std::vector<unsigned char>& get_data() const { return buffer; }
+        std::vector<unsigned char>& get_data() { return buffer; }
+
+    private:
+        std::vector<unsigned char> buffer;
+    };
+
+}
@@ -1,5 +1,8 @@
 #pragma once
+#include <cstddef>
 #include <string>
+#include <vector>
+#include "./base/file_hasher.h"
 
 namespace file_properties {
 
@@ -36,27 +39,79 @@ namespace file_properties {
         JPEG
     };
 
+    /**
+     * @brief File type information derived from the leading bytes of a file
+     *
+     * The probed bytes are kept so the processor created for the file can
+     * validate its format without opening the file again.
+     */
+    struct file_type_probe {
+        category file_category {category::UNKNOWN};
+        type_major file_type_major {type_major::UNKNOWN};
+        type_minor file_type_minor {type_minor::UNKNOWN};
+        std::vector<unsigned char> header;
+        bool header_loaded {false};
+    };
+
     class file_properties_class {
     protected:
-        std::string file_hash;
+        mutable std::string file_hash;
+        mutable bool file_hash_ready {false};
         std::string file_path;
         std::string file_name;
         std::string file_extension;
         category file_category {category::UNKNOWN};
         type_major file_type_major {type_major::UNKNOWN};
         type_minor file_type_minor {type_minor::UNKNOWN};
+        file_hasher::hash_algorithm file_hash_algorithm {file_hasher::hash_algorithm::FAST_128};
+        std::vector<unsigned char> file_header;
     public:
-        explicit file_properties_class(std::string path);
+        /**
+         * @brief Constructor
+         * @param path Path to the file
+         * @param algorithm Algorithm used by get_file_hash()
+         * @param probe Result of probe_file_type(), the header is read again if it was not loaded
+         */
+        explicit file_properties_class(std::string path,
+                                       file_hasher::hash_algorithm algorithm = file_hasher::hash_algorithm::FAST_128,
+                                       file_type_probe probe = {});
         virtual ~file_properties_class();
-        [[nodiscard]] const std::string& get_file_hash() const { return file_hash; }
+        /**
+         * @brief Get the file hash, computed on the first call
+         * @return Hex digest of the file content
+         */
+        [[nodiscard]] const std::string& get_file_hash() const;
         [[nodiscard]] const std::string& get_file_path() const { return file_path; }
         [[nodiscard]] const std::string& get_file_name() const { return file_name; }
         [[nodiscard]] const std::string& get_file_extension() const { return file_extension; }
         [[nodiscard]] category get_file_category() const { return file_category; }
         [[nodiscard]] type_major get_file_type_major() const { return file_type_major; }
         [[nodiscard]] type_minor get_file_type_minor() const { return file_type_minor; }
+        [[nodiscard]] const std::vector<unsigned char>& get_file_header() const { return file_header; }
+
+        /**
+         * @brief Determine the file type from its leading bytes, falling back to the extension
+         *
+         * Only the first content_sniffer::probe_size bytes are read.
+         *
+         * @param path Path to the file
+         * @return Category and type enums of the file together with the probed bytes
+         */
+        static file_type_probe probe_file_type(const std::string& path);
+
+        /**
+         * @brief Determine the type of content held in memory, falling back to the name
+         *
+         * @param data Pointer to the content
+         * @param size Size of the content in bytes
+         * @param name File name or extension, nothing is read from disk
+         * @return Category and type enums of the content together with its leading bytes
+         */
+        static file_type_probe probe_buffer_type(const unsigned char* data, std::size_t size, const std::string& name);
     protected:
-        void init_file_hash();
+        virtual void init_file_hash() const;
+        void init_file_header();
+        void init_file_signature();
         void init_file_name();
         void init_file_extension();
         void init_file_category();
@@ -0,0 +1,99 @@
+/**
+ * @file metadata_policy.h
+ * @brief Keep/drop rules for metadata keys, compiled once into a DFA
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace metadata_policy {
+
+    enum class action {
+        KEEP,
+        DROP
+    };
+
+    /**
+     * @brief One keep or drop rule
+     */
+    struct rule {
+        action rule_action;
+        std::string pattern;
+    };
+
+    /**
+     * @brief Compiled set of keep/drop rules
+     *
+     * Policies are written one rule per line:
+     *
+     *     # comments and blank lines are ignored
+     *     default keep            # action for keys no rule matches, keep if omitted
+     *     keep Copyright
+     *     drop GPS*
+     *     drop Xmp.xmpMM.*
+     *     drop dc:creator
+     *
+     * Patterns use '*' for any run of characters and '?' for one character.
+     * A pattern matches a key as a whole or any tail of it that starts after
+     * a '.', so "Make" matches "EXIF.Exif.Image.Make" and "dc:creator" matches
+     * "Core.dc:creator". When several rules match, the last one wins.
+     *
+     * All rules are compiled into one deterministic automaton, evaluating a
+     * key takes one table lookup per character whatever the number of rules.
+     * A compiled policy is immutable and can be shared between threads.
+     */
+    class policy_class {
+    public:
+        /**
+         * @brief Compile a list of rules
+         * @param rules Rules in order of increasing precedence
+         * @param default_action Action for keys no rule matches
+         * @throws std::runtime_error if the automaton grows beyond its state limit
+         */
+        explicit policy_class(std::vector<rule> rules, action default_action = action::KEEP);
+
+        /**
+         * @brief Parse and compile a policy
+         * @param text Policy text
+         * @return Compiled policy
+         * @throws std::runtime_error with the line number if the text is malformed
+         */
+        static policy_class parse(const std::string& text);
+
+        /**
+         * @brief Read, parse and compile a policy file
+         * @param path Path to the policy file
+         * @return Compiled policy
+         * @throws std::runtime_error if the file cannot be read or is malformed
+         */
+        static policy_class load(const std::string& path);
+
+        /**
+         * @brief Decide what happens to a metadata key
+         * @param key Key as reported by read_metadata
+         * @return Action of the last matching rule, or the default action
+         */
+        [[nodiscard]] action evaluate(const std::string& key) const;
+
+        [[nodiscard]] const std::vector<rule>& get_rules() const { return rules; }
+        [[nodiscard]] action get_default_action() const { return default_action; }
+
+    private:
+        void compile();
+
+        std::vector<rule> rules;
+        action default_action;
+
+        // Characters that occur in patterns get their own class, all others share class 0
+        unsigned char char_class[256] {};
+        std::size_t class_count {1};
+        // transitions[state * class_count + class] is the next state
+        std::vector<std::uint32_t> transitions;
+        // Index of the winning rule in each state, -1 if none matches
+        std::vector<int> accepting_rule;
+    };
+
+}
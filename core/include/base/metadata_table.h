@@ -0,0 +1,170 @@
+/**
+ * @file metadata_table.h
+ * @brief Interned metadata keys and the compact key/value map of operation results
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace metadata_table {
+
+    /**
+     * @brief Index of a key in the process-wide key table
+     */
+    using key_id = std::uint32_t;
+
+    /**
+     * @brief Most keys the process-wide key table takes
+     *
+     * Processors also report keys taken from file contents, such as PNG text
+     * keywords or custom document properties. Once the table is full, new keys
+     * are kept by the result that reports them, so a long-running process fed
+     * hostile files does not grow the table without limit.
+     */
+    constexpr std::size_t max_interned_keys = 4096;
+
+    /**
+     * @brief Get the id of a key, adding it to the key table on first use
+     *
+     * The table is shared by all threads and never shrinks.
+     *
+     * @param key Metadata key
+     * @param id Set to an id that stays valid for the lifetime of the process
+     * @return False if the key is new and the table is full
+     */
+    bool intern_key(std::string_view key, key_id& id);
+
+    /**
+     * @brief Look up the id of a key without adding it
+     * @param key Metadata key
+     * @param id Set to the id if the key is known
+     * @return True if the key has been interned before
+     */
+    bool find_key(std::string_view key, key_id& id);
+
+    /**
+     * @brief Get the text of an interned key
+     * @param id Key id from intern_key
+     * @return Key text, the reference stays valid for the lifetime of the process
+     */
+    const std::string& key_name(key_id id);
+
+    /**
+     * @brief Key/value pairs of one operation result
+     *
+     * Keys are interned ids and values live back to back in one arena string,
+     * so a result holds two allocations however many entries it has. Keys
+     * the shared table has no room for are held by the map itself. Entries
+     * are kept in a flat vector sorted by key id. Iteration yields pairs of the
+     * key text and a view of the value, like the map this type replaces.
+     */
+    class metadata_map {
+    public:
+        using value_type = std::pair<const std::string&, std::string_view>;
+
+        /**
+         * @brief Key ids with this bit set index the keys held by the map itself
+         */
+        static constexpr key_id local_key_flag = 0x80000000;
+
+        class const_iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = metadata_map::value_type;
+            using difference_type = std::ptrdiff_t;
+            using reference = value_type;
+
+            /**
+             * @brief Holder that lets it->first and it->second work on a pair built on the fly
+             */
+            struct pointer {
+                value_type item;
+                const value_type* operator->() const { return &item; }
+            };
+
+            const_iterator() = default;
+
+            reference operator*() const { return owner->item(index); }
+            pointer operator->() const { return {owner->item(index)}; }
+            const_iterator& operator++() { index++; return *this; }
+            const_iterator operator++(int) { const_iterator old = *this; index++; return old; }
+            bool operator==(const const_iterator& other) const { return index == other.index; }
+            bool operator!=(const const_iterator& other) const { return index != other.index; }
+
+        private:
+            friend class metadata_map;
+            const_iterator(const metadata_map* owner, std::size_t index) : owner(owner), index(index) {}
+
+            const metadata_map* owner {nullptr};
+            std::size_t index {0};
+        };
+        using iterator = const_iterator;
+
+        /**
+         * @brief Add an entry or replace its value
+         *
+         * Keys the shared table has no room for are kept in the map.
+         */
+        void set(std::string_view key, std::string_view value);
+
+        /**
+         * @brief Add an entry whose key is prefix + key, e.g. ("EXIF.", "Exif.Image.Make")
+         */
+        void set(std::string_view prefix, std::string_view key, std::string_view value);
+
+        /**
+         * @brief Find an entry by key text
+         * @return Iterator to the entry, end() if the key is not present
+         */
+        [[nodiscard]] const_iterator find(std::string_view key) const;
+        [[nodiscard]] std::size_t count(std::string_view key) const { return find(key) == end() ? 0 : 1; }
+
+        /**
+         * @brief Get the value of a key
+         * @return View of the value, empty if the key is not present
+         */
+        [[nodiscard]] std::string_view value(std::string_view key) const;
+
+        [[nodiscard]] std::size_t size() const { return entries.size(); }
+        [[nodiscard]] bool empty() const { return entries.empty(); }
+        [[nodiscard]] const_iterator begin() const { return {this, 0}; }
+        [[nodiscard]] const_iterator end() const { return {this, entries.size()}; }
+
+        void clear();
+
+        /**
+         * @brief Release the spare capacity left by growing the entries and arena
+         */
+        void shrink_to_fit();
+
+        /**
+         * @brief Copy the entries into a node-based map for callers that need one
+         */
+        [[nodiscard]] std::unordered_map<std::string, std::string> to_map() const;
+
+    private:
+        struct entry {
+            key_id key;
+            std::uint32_t offset;
+            std::uint32_t length;
+        };
+
+        void set(key_id key, std::string_view value);
+        [[nodiscard]] const_iterator find(key_id key) const;
+        [[nodiscard]] value_type item(std::size_t index) const;
+
+        std::vector<entry> entries;
+        std::string arena;
+        // Keys beyond the shared table, indexed by their id without local_key_flag
+        std::vector<std::string> local_keys;
+        std::unordered_map<std::string, key_id> local_ids;
+    };
+
+}
@@ -7,6 +7,7 @@
 #include <memory>
 #include <unordered_map>
 #include <functional>
+#include <utility>
 #include "./base/file_handler.h"
 #include "./base/file_properties.h"
 
@@ -35,7 +36,9 @@ namespace processor_factory {
         using creator_func = std::function<std::unique_ptr<file_handler::file_handler_class>(
             const std::string&,
             file_handler::operation_type,
-            const file_handler::operation_options&)>;
+            const file_handler::shared_options&,
+            file_properties::file_type_probe,
+            file_handler::buffer_binding)>;
 
         /**
          * @brief Register a processor factory for a specific file type
@@ -52,15 +55,36 @@ namespace processor_factory {
          * @brief Create a processor for the given file type
          * @param file_path Path to the file
          * @param op_type Operation type
-         * @param options Operation options
+         * @param options Shared operation options
          * @return Unique pointer to file handler
          */
         static std::unique_ptr<file_handler::file_handler_class> create_processor(
             const std::string& file_path,
             file_handler::operation_type op_type,
-            const file_handler::operation_options& options);
+            const file_handler::shared_options& options);
+
+        /**
+         * @brief Create a processor for content held in memory
+         * @param name File name or extension used when the content does not identify the type
+         * @param buffers Input buffer and output vector
+         * @param op_type Operation type
+         * @param options Shared operation options
+         * @return Unique pointer to file handler
+         */
+        static std::unique_ptr<file_handler::file_handler_class> create_buffer_processor(
+            const std::string& name,
+            const file_handler::buffer_binding& buffers,
+            file_handler::operation_type op_type,
+            const file_handler::shared_options& options);
 
     private:
+        /**
+         * @brief Find the creator for a probed type, falling back to the UNKNOWN minor type
+         * @param probe Probed file type
+         * @return Creator function, nullptr if no processor is registered
+         */
+        static const creator_func* find_creator(const file_properties::file_type_probe& probe);
+
         /**
          * @brief Map of registered processor factories
          * Key: pair of (major_type, minor_type)
@@ -87,8 +111,9 @@ namespace processor_factory {
         processor_registrar() {
             processor_factory_class::register_processor(
                 Major, Minor,
-                [](const std::string& path, file_handler::operation_type type, const file_handler::operation_options& opts) {
-                    return std::make_unique<ProcessorType>(path, type, opts);
+                [](const std::string& path, file_handler::operation_type type, const file_handler::shared_options& opts,
+                   file_properties::file_type_probe probe, file_handler::buffer_binding buffers) {
+                    return std::make_unique<ProcessorType>(path, type, opts, std::move(probe), buffers);
                 }
             );
         }
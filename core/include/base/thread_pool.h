@@ -0,0 +1,104 @@
+/**
+ * @file thread_pool.h
+ * @brief Work-stealing thread pool used for batch processing
+ */
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace thread_pool {
+
+    /**
+     * @brief Work-stealing thread pool
+     *
+     * Every worker owns a deque of tasks. A worker takes work from the front of
+     * its own deque and, once that is empty, steals from the back of the other
+     * workers' deques, so a few slow files cannot leave the remaining cores idle.
+     * Threads waiting on a batch help execute queued tasks instead of blocking,
+     * which keeps nested batches (a task that itself calls parallel_for) safe.
+     */
+    class thread_pool_class {
+    public:
+        /**
+         * @brief Task type executed by the workers
+         */
+        using task = std::function<void()>;
+
+        /**
+         * @brief Constructor
+         * @param worker_count Number of worker threads, 0 uses the hardware concurrency
+         */
+        explicit thread_pool_class(std::size_t worker_count = 0);
+
+        /**
+         * @brief Destructor, drains the queues and joins all workers
+         */
+        ~thread_pool_class();
+
+        thread_pool_class(const thread_pool_class&) = delete;
+        thread_pool_class& operator=(const thread_pool_class&) = delete;
+
+        /**
+         * @brief Get the number of worker threads
+         * @return Worker count
+         */
+        [[nodiscard]] std::size_t get_worker_count() const { return workers.size(); }
+
+        /**
+         * @brief Queue a single task
+         * @param t Task to execute
+         */
+        void submit(task t);
+
+        /**
+         * @brief Run body(i) for every i in [0, count) and wait for completion
+         *
+         * Indices are handed out to the workers in contiguous blocks, so results
+         * written by index keep the order of the input. Exceptions thrown by the
+         * body are caught and the first one is rethrown to the caller.
+         *
+         * @param count Number of iterations
+         * @param body Function invoked with each index
+         */
+        void parallel_for(std::size_t count, const std::function<void(std::size_t)>& body);
+
+        /**
+         * @brief Get the default worker count for this machine
+         * @return Hardware concurrency, at least 1
+         */
+        static std::size_t default_worker_count();
+
+    private:
+        /**
+         * @brief Per-worker task deque
+         */
+        struct work_queue {
+            std::mutex mutex;
+            std::deque<task> tasks;
+        };
+
+        void worker_loop(std::size_t index);
+        bool pop_task(std::size_t index, task& out);
+        bool steal_task(std::size_t thief, task& out);
+        bool run_pending_task();
+        void push_task(std::size_t index, task t);
+
+        std::vector<std::unique_ptr<work_queue>> queues;
+        std::vector<std::thread> workers;
+
+        std::mutex sleep_mutex;
+        std::condition_variable sleep_cv;
+        std::atomic<std::size_t> pending {0};
+        std::atomic<std::size_t> next_queue {0};
+        bool stopping {false};
+    };
+
+}
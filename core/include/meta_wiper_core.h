@@ -1,11 +1,19 @@
 #pragma once
 
+#include <cstddef>
+#include <functional>
 #include <string>
 #include <vector>
 #include <memory>
+#include <mutex>
 #include "./base/file_handler.h"
+#include "./base/metadata_policy.h"
 #include "meta_wipe_core_export.h"
 
+namespace thread_pool {
+    class thread_pool_class;
+}
+
 namespace meta_wiper_core {
 
     enum class error_code {
@@ -30,22 +38,141 @@ namespace meta_wiper_core {
         std::vector<meta_item> metadata;
     };
 
+    struct buffer_result {
+        file_handler::operation_result result;
+        // Rewritten content for CLEAN and OVERWRITE, empty for the other operations
+        std::vector<unsigned char> data;
+    };
+
+    /**
+     * @brief Receives the result of one file of a streamed batch
+     *
+     * Called with the index of the file in the batch and its result, return
+     * false to skip the files that have not been started yet.
+     */
+    using result_callback = std::function<bool(std::size_t, file_handler::operation_result&&)>;
+
     class META_WIPER_CORE_EXPORT_FLAG meta_wiper_core_class {
     public:
-        meta_wiper_core_class();
+        /**
+         * @brief Constructor
+         * @param worker_count Number of workers used by process_files, 0 uses the hardware concurrency
+         */
+        explicit meta_wiper_core_class(std::size_t worker_count = 0);
         ~meta_wiper_core_class();
         file_handler::operation_result process_file(
             const std::string& file_path,
             file_handler::operation_type op_type,
             const file_handler::operation_options& options = {}
         );
+
+        /**
+         * @brief Process content held in memory without touching the filesystem
+         *
+         * The content is read in place and never copied to a file, EXPORT still
+         * writes its report and needs options.output_directory.
+         *
+         * @param data Pointer to the content
+         * @param size Size of the content in bytes
+         * @param type_hint File name or extension used when the content does not identify the type
+         * @param op_type Operation type
+         * @param options Operation options
+         * @return Operation result and the rewritten content
+         */
+        buffer_result process_buffer(
+            const void* data,
+            std::size_t size,
+            const std::string& type_hint,
+            file_handler::operation_type op_type,
+            const file_handler::operation_options& options = {}
+        );
         std::vector<file_handler::operation_result> process_files(
             const std::vector<std::string>& file_paths,
             file_handler::operation_type op_type,
             const file_handler::operation_options& options = {}
         );
+
+        /**
+         * @brief Process files and hand each result over as soon as it is ready
+         *
+         * Results arrive in completion order on the calling thread, one at a
+         * time, so the callback needs no locking. At most max_pending finished
+         * results wait for the callback, workers pause while the queue is full,
+         * so memory stays bounded whatever the batch size. Unlike the vector
+         * overload every file is committed on its own, a delivered CLEAN result
+         * is final. The callback must not start another batch on this instance.
+         *
+         * @param file_paths Files to process
+         * @param op_type Operation type
+         * @param on_result Callback receiving (index, result)
+         * @param options Operation options
+         * @param max_pending Results allowed to wait for the callback, 0 uses twice the worker count
+         * @return Number of results delivered
+         * @throws Any exception thrown by on_result, after the workers have stopped
+         */
+        std::size_t process_files(
+            const std::vector<std::string>& file_paths,
+            file_handler::operation_type op_type,
+            const result_callback& on_result,
+            const file_handler::operation_options& options = {},
+            std::size_t max_pending = 0
+        );
         static std::vector<std::string> get_supported_file_types() ;
         bool type_supported(const std::string& file_type) const;
+
+        /**
+         * @brief Set the number of workers used by process_files
+         * @param count Worker count, 0 uses the hardware concurrency
+         */
+        void set_worker_count(std::size_t count);
+
+        /**
+         * @brief Get the number of workers used by process_files
+         * @return Worker count
+         */
+        [[nodiscard]] std::size_t get_worker_count() const;
+
+        /**
+         * @brief Set the policy that decides which keys CLEAN removes
+         *
+         * The policy applies to every later call whose options carry neither
+         * selected properties nor a policy of their own.
+         *
+         * @param policy Compiled policy, nullptr to remove all metadata again
+         */
+        void set_policy(std::shared_ptr<const metadata_policy::policy_class> policy);
+
+        /**
+         * @brief Compile a policy file and set it as with set_policy
+         * @param policy_path Path to the policy file
+         * @throws std::runtime_error if the file cannot be read or is malformed
+         */
+        void load_policy(const std::string& policy_path);
+
+        /**
+         * @brief Get the policy set on this instance
+         * @return Compiled policy, nullptr if none is set
+         */
+        [[nodiscard]] std::shared_ptr<const metadata_policy::policy_class> get_policy() const;
+
+    private:
+        /**
+         * @brief Freeze the options of one call, adding the policy and worker pool of this instance
+         */
+        file_handler::shared_options share_options(const file_handler::operation_options& options);
+        file_handler::operation_result run_file(
+            const std::string& file_path,
+            file_handler::operation_type op_type,
+            const file_handler::shared_options& options,
+            file_io::commit_batch* batch
+        );
+        std::shared_ptr<thread_pool::thread_pool_class> get_thread_pool();
+
+        std::size_t worker_count;
+        std::shared_ptr<thread_pool::thread_pool_class> pool;
+        mutable std::mutex pool_mutex;
+        std::shared_ptr<const metadata_policy::policy_class> policy;
+        mutable std::mutex policy_mutex;
     };
 
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include <memory>
 #include <exiv2/exiv2.hpp>
 #include "./base/file_handler.h"
+#include "./base/file_io.h"
 
 namespace jpeg_processor {
 
@@ -10,7 +11,9 @@ namespace jpeg_processor {
     public:
         jpeg_processor_class(const std::string& path,
                              file_handler::operation_type type,
-                             const file_handler::operation_options& opts);
+                             file_handler::shared_options opts,
+                             file_properties::file_type_probe probe = {},
+                             file_handler::buffer_binding buffers = {});
         ~jpeg_processor_class() override;;
     protected:
         file_handler::operation_result check_prerequisites() override;
@@ -20,6 +23,13 @@ namespace jpeg_processor {
         file_handler::operation_result export_metadata() override;
         file_handler::operation_result restore_metadata() override;
     private:
+        bool load_header_metadata();
+        bool load_image();
+        void write_image();
+        file_handler::operation_result clean_selected_metadata();
+
+        // Exiv2 reads through a MemIo over this mapping or buffer, it must outlive jpeg_image
+        std::unique_ptr<file_io::byte_source> input_map;
         std::unique_ptr<Exiv2::Image> jpeg_image;
         bool jpeg_loaded;
     };
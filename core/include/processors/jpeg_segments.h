@@ -0,0 +1,75 @@
+/**
+ * @file jpeg_segments.h
+ * @brief Marker-level JPEG parsing and metadata stripping without decoding
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include "./base/file_io.h"
+
+namespace jpeg_segments {
+
+    /**
+     * @brief Marker codes, without the 0xFF prefix
+     */
+    namespace marker {
+        constexpr unsigned char SOI = 0xD8;
+        constexpr unsigned char EOI = 0xD9;
+        constexpr unsigned char SOS = 0xDA;
+        constexpr unsigned char APP0 = 0xE0;
+        constexpr unsigned char APP1 = 0xE1;
+        constexpr unsigned char APP2 = 0xE2;
+        constexpr unsigned char APP13 = 0xED;
+        constexpr unsigned char APP14 = 0xEE;
+        constexpr unsigned char APP15 = 0xEF;
+        constexpr unsigned char COM = 0xFE;
+    }
+
+    /**
+     * @brief Location of one marker segment in the source
+     */
+    struct segment {
+        unsigned char marker;
+        std::uint64_t offset;           // offset of the 0xFF prefix
+        std::uint64_t size;             // marker plus payload
+        std::uint64_t payload_offset;   // first byte after the length field
+        std::size_t payload_size;
+    };
+
+    struct strip_options {
+        // Drop every APPn segment except JFIF, Adobe and ICC profiles, which affect decoding
+        bool remove_all_app_segments {false};
+    };
+
+    /**
+     * @brief Walk the marker segments preceding the first scan
+     *
+     * Only the marker and length fields are read, payloads are left to the callback.
+     *
+     * @param source JPEG data
+     * @param callback Called for every segment between SOI and SOS
+     * @return Offset of the SOS marker, or of EOI / the end of the source if there is no scan
+     * @throws std::runtime_error if the data is not a well-formed JPEG header
+     */
+    std::uint64_t walk_header(const file_io::byte_source& source,
+                              const std::function<void(const segment&)>& callback);
+
+    /**
+     * @brief Copy a JPEG, leaving out its metadata segments
+     *
+     * APP1 (EXIF, XMP), APP13 (IPTC) and COM segments are dropped. Everything from
+     * the first SOS marker onwards is copied verbatim as one range, so memory use
+     * does not depend on the image size.
+     *
+     * @param source JPEG data
+     * @param sink Destination of the cleaned JPEG
+     * @param options Strip options
+     * @return Number of segments removed
+     * @throws std::runtime_error if the data is not a well-formed JPEG header
+     */
+    std::size_t strip(const file_io::byte_source& source, file_io::byte_sink& sink,
+                      const strip_options& options = {});
+
+}
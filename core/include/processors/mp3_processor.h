@@ -0,0 +1,98 @@
+/**
+ * @file mp3_processor.h
+ * @brief MP3 metadata processor working on tags without touching the audio frames
+ */
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "./base/file_handler.h"
+#include "./processors/mp3_tags.h"
+
+namespace mp3_processor {
+
+    /**
+     * @brief Tags of a file rebuilt without the removed keys
+     */
+    struct tag_plan {
+        mp3_tags::tag_layout layout;
+        std::vector<unsigned char> head;    // ID3v2 tags written before the audio
+        std::vector<unsigned char> tail;    // tags written after the audio
+        bool head_changed {false};
+        bool tail_changed {false};
+    };
+
+    /**
+     * @brief Processor for MP3 files
+     *
+     * Keys are reported as "ID3v2.<frame>" ("ID3v2.TXXX:<description>" for
+     * user text frames), "ID3v1.<field>", "APE.<item>" and
+     * "Lyrics3.<field>". Only the tags are read, the audio frames are copied
+     * unchanged:
+     * - when only tags after the audio change, the file is truncated at the
+     *   end of the audio and the remaining tags appended;
+     * - when an ID3v2 tag at the start keeps some frames, it is padded to its
+     *   old size and written over itself;
+     * - otherwise the audio is copied into a new file between the new tags,
+     *   through copy_file_range where the system has it.
+     * Memory use depends on the size of the tags, never on the audio.
+     */
+    class mp3_processor_class : public file_handler::file_handler_class {
+    public:
+        /**
+         * @brief Constructor
+         * @param path Path to the MP3 file
+         * @param type Operation type
+         * @param opts Shared operation options
+         * @param probe Result of the type probe
+         * @param buffers In-memory input and output used instead of the file
+         */
+        mp3_processor_class(const std::string& path,
+                            file_handler::operation_type type,
+                            file_handler::shared_options opts,
+                            file_properties::file_type_probe probe = {},
+                            file_handler::buffer_binding buffers = {});
+        ~mp3_processor_class() override;
+
+    protected:
+        file_handler::operation_result check_prerequisites() override;
+        file_handler::operation_result read_metadata() override;
+        file_handler::operation_result clean_metadata() override;
+        file_handler::operation_result overwrite_metadata() override;
+        file_handler::operation_result export_metadata() override;
+        file_handler::operation_result restore_metadata() override;
+
+    private:
+        /**
+         * @brief Rebuild the tags and write the file if anything changed
+         * @param drop Decides which keys are removed, nullptr removes every tag
+         * @param new_head ID3v2 tag written before the audio instead of the old ones, empty for none
+         * @param warnings Collects problems that do not stop the operation
+         */
+        void rewrite(const std::function<bool(const std::string&)>& drop,
+                     const std::vector<unsigned char>& new_head, std::vector<std::string>& warnings) const;
+
+        /**
+         * @brief Write the audio between the rebuilt tags
+         * @param source Input file, released before the output is committed
+         * @param plan Rebuilt tags
+         */
+        void commit_tags(std::unique_ptr<file_io::byte_source> source, tag_plan& plan) const;
+    };
+
+}
+
+#include "./base/processor_factory.h"
+
+namespace {
+    /**
+     * @brief Static registrar for MP3 files
+     */
+    processor_factory::processor_registrar<
+        mp3_processor::mp3_processor_class,
+        file_properties::type_major::MP3,
+        file_properties::type_minor::UNKNOWN
+    > register_mp3_processor;
+}
@@ -0,0 +1,134 @@
+/**
+ * @file mp3_tags.h
+ * @brief Location and parsing of ID3v2, ID3v1, APE and Lyrics3 tags around MP3 audio
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "./base/file_io.h"
+
+namespace mp3_tags {
+
+    enum class tag_kind {
+        ID3V2,
+        ID3V1,
+        ID3V1_EXTENDED,     // 227-byte "TAG+" block right before ID3v1
+        APE,
+        LYRICS3
+    };
+
+    /**
+     * @brief Location of one tag in the source
+     */
+    struct tag {
+        tag_kind kind;
+        std::uint64_t offset;
+        std::uint64_t size;             // whole tag including headers and footers
+
+        [[nodiscard]] std::uint64_t end() const { return offset + size; }
+    };
+
+    /**
+     * @brief Tags found before and after the audio frames
+     */
+    struct tag_layout {
+        std::vector<tag> head;          // ID3v2 tags at the start, in file order
+        std::vector<tag> tail;          // appended tags, in file order
+        std::uint64_t audio_begin {0};
+        std::uint64_t audio_end {0};
+
+        [[nodiscard]] bool empty() const { return head.empty() && tail.empty(); }
+    };
+
+    /**
+     * @brief ID3v2 header flags
+     */
+    namespace id3v2_flag {
+        constexpr unsigned char UNSYNCHRONISATION = 0x80;
+        constexpr unsigned char EXTENDED_HEADER = 0x40;
+        constexpr unsigned char FOOTER = 0x10;
+    }
+
+    /**
+     * @brief Fields of the 10-byte ID3v2 header
+     */
+    struct id3v2_header {
+        unsigned char version;          // major version, 2 to 4
+        unsigned char flags;
+        std::uint32_t size;             // size of the tag after the header, without the footer
+    };
+
+    /**
+     * @brief One frame of an ID3v2 tag
+     */
+    struct id3v2_frame {
+        std::string id;                 // "TIT2", or three characters in ID3v2.2
+        std::uint64_t offset;           // offset of the frame header in the tag body source
+        std::size_t header_size;        // 6 in ID3v2.2, 10 otherwise
+        std::uint64_t size;             // size of the frame data
+        std::uint16_t flags;            // status and format flags, 0 in ID3v2.2
+
+        [[nodiscard]] std::uint64_t data_offset() const { return offset + header_size; }
+        [[nodiscard]] std::uint64_t end() const { return offset + header_size + size; }
+    };
+
+    /**
+     * @brief Find the tags of an MP3 file
+     *
+     * Only tag headers and footers are read: ID3v2 tags at the start of the
+     * file, and APEv1/v2, Lyrics3v2, ID3v1 (with a "TAG+" extension) and
+     * appended ID3v2 tags with a footer at the end, in any order.
+     *
+     * @param source MP3 data
+     * @return Tag locations and the range of the audio frames between them
+     */
+    tag_layout locate(const file_io::byte_source& source);
+
+    /**
+     * @brief Check if data starts like an MP3 file, with an ID3v2 tag or an MPEG frame sync
+     */
+    bool looks_like_mp3(const unsigned char* data, std::size_t size);
+
+    /**
+     * @brief Decode a 28-bit integer stored in four bytes of seven bits
+     */
+    std::uint32_t get_syncsafe(const unsigned char* p);
+
+    /**
+     * @brief Encode a value below 2^28 as four bytes of seven bits
+     */
+    void put_syncsafe(unsigned char* p, std::uint32_t value);
+
+    /**
+     * @brief Parse an ID3v2 header
+     * @param data At least 10 bytes starting with "ID3"
+     * @param header Filled with the header fields
+     * @return False if the bytes are not a valid ID3v2 header
+     */
+    bool parse_id3v2_header(const unsigned char* data, id3v2_header& header);
+
+    /**
+     * @brief Undo ID3v2 unsynchronisation, every 0xFF 0x00 pair becomes 0xFF
+     */
+    std::vector<unsigned char> remove_unsynchronisation(const unsigned char* data, std::size_t size);
+
+    /**
+     * @brief List the frames of an ID3v2 tag body
+     *
+     * Frame headers are read one at a time through read_at, frame data is
+     * left to the caller. The list ends at the first padding byte or at the
+     * first frame header that is not valid.
+     *
+     * @param body Source holding the frames, the file itself or a decoded copy
+     * @param begin Offset of the first frame, after the header and any extended header
+     * @param end End of the frames
+     * @param version Major version of the tag
+     * @return Frames in tag order
+     */
+    std::vector<id3v2_frame> id3v2_frames(const file_io::byte_source& body, std::uint64_t begin,
+                                          std::uint64_t end, unsigned version);
+
+}
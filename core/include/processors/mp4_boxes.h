@@ -0,0 +1,85 @@
+/**
+ * @file mp4_boxes.h
+ * @brief Box-level parsing of ISO base media (MP4, MOV) files without reading media data
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "./base/file_io.h"
+
+namespace mp4_boxes {
+
+    /**
+     * @brief Location of one box in the source
+     */
+    struct box {
+        std::string type;               // four-character type, e.g. "moov"
+        std::uint64_t offset;           // offset of the size field
+        std::uint64_t header_size;      // 8, or 16 with a 64-bit size
+        std::uint64_t size;             // whole box including the header
+
+        [[nodiscard]] std::uint64_t data_offset() const { return offset + header_size; }
+        [[nodiscard]] std::uint64_t data_size() const { return size - header_size; }
+        [[nodiscard]] std::uint64_t end() const { return offset + size; }
+    };
+
+    std::uint32_t get32(const unsigned char* p);
+    std::uint64_t get64(const unsigned char* p);
+    void put32(unsigned char* p, std::uint32_t value);
+    void put64(unsigned char* p, std::uint64_t value);
+
+    /**
+     * @brief Walk the boxes in a range of the source
+     *
+     * Only the size and type fields are read, box data is left to the callback,
+     * so walking the top level of a file never touches mdat. A size of zero
+     * extends the box to the end of the range.
+     *
+     * @param source File or box data
+     * @param begin Offset of the first box
+     * @param end End of the range, usually the end of the source or of the parent box
+     * @param callback Called for every box in order
+     * @throws std::runtime_error if a box header is truncated or a box exceeds the range
+     */
+    void walk(const file_io::byte_source& source, std::uint64_t begin, std::uint64_t end,
+              const std::function<void(const box&)>& callback);
+
+    /**
+     * @brief Get the offset of the first child of a meta box
+     *
+     * ISO files make meta a full box with four bytes of version and flags
+     * before its children, QuickTime files do not.
+     *
+     * @param source Data holding the box
+     * @param meta The meta box
+     * @return Offset of the first child
+     */
+    std::uint64_t meta_children_offset(const file_io::byte_source& source, const box& meta);
+
+    /**
+     * @brief Append a box header, using a 64-bit size only when needed
+     * @param out Destination
+     * @param type Four-character type
+     * @param data_size Size of the data following the header
+     * @return Size of the header written
+     */
+    std::size_t append_header(std::vector<unsigned char>& out, const std::string& type, std::uint64_t data_size);
+
+    /**
+     * @brief Append a free box covering exactly size bytes, its data zeroed
+     * @param out Destination
+     * @param size Size of the whole box, at least 8
+     */
+    void append_free(std::vector<unsigned char>& out, std::uint64_t size);
+
+    /**
+     * @brief Append bytes of the source
+     */
+    void append_range(std::vector<unsigned char>& out, const file_io::byte_source& source,
+                      std::uint64_t offset, std::uint64_t size);
+
+}
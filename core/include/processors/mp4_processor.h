@@ -0,0 +1,104 @@
+/**
+ * @file mp4_processor.h
+ * @brief MP4 and MOV metadata processor working on boxes without reading media data
+ */
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include "./base/file_handler.h"
+#include "./processors/mp4_boxes.h"
+
+namespace mp4_processor {
+
+    /**
+     * @brief Rebuilt top-level box
+     */
+    struct box_edit {
+        mp4_boxes::box original;
+        std::vector<unsigned char> data;            // rebuilt box, empty if it is dropped
+        std::vector<std::size_t> chunk_tables;      // offsets of stco and co64 boxes in data
+        bool changed {false};
+    };
+
+    /**
+     * @brief Processor for MP4, MOV and other ISO base media files
+     *
+     * Metadata lives in udta and meta boxes of moov and its tracks, in XMP
+     * boxes and in the creation and modification times of the movie header.
+     * Keys are reported as "UserData.<atom>" (QuickTime atoms such as
+     * "UserData.©xyz"), "QuickTime.<key>" for mdta item lists,
+     * "iTunes.<atom>" for iTunes item lists, "XMP.<key>" and
+     * "Movie.CreationTime" / "Movie.ModificationTime". Track metadata is
+     * prefixed with "Track<n>.".
+     *
+     * Only the top-level box headers and moov are read, mdat is never
+     * touched. How a change is written depends on where moov lies:
+     * - after the last mdat, the file is truncated at moov and the rebuilt
+     *   boxes appended;
+     * - before mdat and the file is changed in place, the rebuilt moov is
+     *   padded with a free box to its old size and written over itself;
+     * - otherwise the file is copied with the removed bytes left out and the
+     *   stco/co64 chunk offsets shifted to match.
+     */
+    class mp4_processor_class : public file_handler::file_handler_class {
+    public:
+        /**
+         * @brief Constructor
+         * @param path Path to the MP4 file
+         * @param type Operation type
+         * @param opts Shared operation options
+         * @param probe Result of the type probe
+         * @param buffers In-memory input and output used instead of the file
+         */
+        mp4_processor_class(const std::string& path,
+                            file_handler::operation_type type,
+                            file_handler::shared_options opts,
+                            file_properties::file_type_probe probe = {},
+                            file_handler::buffer_binding buffers = {});
+        ~mp4_processor_class() override;
+
+    protected:
+        file_handler::operation_result check_prerequisites() override;
+        file_handler::operation_result read_metadata() override;
+        file_handler::operation_result clean_metadata() override;
+        file_handler::operation_result overwrite_metadata() override;
+        file_handler::operation_result export_metadata() override;
+        file_handler::operation_result restore_metadata() override;
+
+    private:
+        /**
+         * @brief Rebuild the metadata boxes and write the file if anything changed
+         * @param drop Decides which keys are removed, nullptr removes all metadata
+         * @param extra_user_data udta box appended to moov, empty for none
+         * @param warnings Collects problems that do not stop the operation
+         */
+        void rewrite(const std::function<bool(const std::string&)>& drop,
+                     const std::vector<unsigned char>& extra_user_data, std::vector<std::string>& warnings) const;
+
+        /**
+         * @brief Write the file with the top-level boxes replaced by their edits
+         * @param source Input file, released before the output is committed
+         * @param boxes All top-level boxes in file order
+         * @param edits Rebuilt boxes, moov always included
+         */
+        void commit_edits(std::unique_ptr<file_io::byte_source> source, const std::vector<mp4_boxes::box>& boxes,
+                          std::vector<box_edit>& edits) const;
+    };
+
+}
+
+#include "./base/processor_factory.h"
+
+namespace {
+    /**
+     * @brief Static registrar for MP4 files
+     */
+    processor_factory::processor_registrar<
+        mp4_processor::mp4_processor_class,
+        file_properties::type_major::MP4,
+        file_properties::type_minor::UNKNOWN
+    > register_mp4_processor;
+}
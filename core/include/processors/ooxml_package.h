@@ -0,0 +1,194 @@
+/**
+ * @file ooxml_package.h
+ * @brief Office Open XML package access shared by the DOCX, XLSX and PPTX processors
+ */
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <zip.h>
+#include "./base/file_io.h"
+#include "./processors/zip_entries.h"
+
+namespace ooxml_package {
+
+    /**
+     * @brief Content types of the package-level property parts
+     */
+    namespace content_type {
+        constexpr const char* CORE_PROPERTIES = "application/vnd.openxmlformats-package.core-properties+xml";
+        constexpr const char* EXTENDED_PROPERTIES =
+            "application/vnd.openxmlformats-officedocument.extended-properties+xml";
+        constexpr const char* CUSTOM_PROPERTIES =
+            "application/vnd.openxmlformats-officedocument.custom-properties+xml";
+    }
+
+    /**
+     * @brief Relationship types of package-level parts without a content type of their own
+     */
+    namespace relationship_type {
+        constexpr const char* THUMBNAIL = "http://schemas.openxmlformats.org/package/2006/relationships/metadata/thumbnail";
+    }
+
+    /**
+     * @brief Transactional set of part changes for an OOXML package
+     *
+     * Part replacements and removals are collected first and written with a
+     * single archive rewrite, no matter how many parts changed.
+     */
+    class package_edit {
+    public:
+        /**
+         * @brief Replace a part, or add it if the package does not have it
+         * @param part_name Path of the part within the archive
+         * @param content New content of the part
+         */
+        void replace_part(const std::string& part_name, std::string content);
+
+        /**
+         * @brief Remove a part from the package
+         * @param part_name Path of the part within the archive
+         */
+        void remove_part(const std::string& part_name);
+
+        /**
+         * @brief Check if any change was collected
+         * @return True if there is nothing to commit
+         */
+        [[nodiscard]] bool empty() const { return replacements.empty() && removals.empty(); }
+
+        /**
+         * @brief Check if a part is removed by the edit
+         * @param part_name Path of the part within the archive
+         * @return True if remove_part was called for it last
+         */
+        [[nodiscard]] bool removes(const std::string& part_name) const { return removals.count(part_name) > 0; }
+
+        [[nodiscard]] const std::map<std::string, std::string>& get_replacements() const { return replacements; }
+        [[nodiscard]] const std::set<std::string>& get_removals() const { return removals; }
+
+    private:
+        std::map<std::string, std::string> replacements;
+        std::set<std::string> removals;
+    };
+
+    /**
+     * @brief Open OOXML package
+     *
+     * Keeps one archive handle over the mapped input, the index of its
+     * entries and the content types from [Content_Types].xml, so parts can
+     * be found by content type instead of by the path one format uses.
+     * Parts are read and rewritten through zip_entries, libzip only reads
+     * parts in methods zip_entries does not decode.
+     */
+    class package_class {
+    public:
+        package_class() = default;
+        ~package_class();
+
+        package_class(const package_class&) = delete;
+        package_class& operator=(const package_class&) = delete;
+
+        /**
+         * @brief Open the archive and index its entries and content types
+         * @param data Package bytes, kept until the package is closed or written
+         * @return True if successful, false otherwise
+         */
+        bool open(std::unique_ptr<file_io::byte_source> data);
+
+        /**
+         * @brief Discard the archive handle and release the input
+         */
+        void close();
+
+        [[nodiscard]] bool is_open() const { return archive != nullptr; }
+
+        [[nodiscard]] bool has_part(const std::string& part_name) const { return entry_index.count(part_name) > 0; }
+
+        /**
+         * @brief Read a part from the archive
+         *
+         * Safe to call from several threads. Stored and deflated parts are
+         * inflated from the input by zip_entries without a lock, parts with
+         * other methods go through libzip one at a time.
+         *
+         * @param part_name Path of the part within the archive
+         * @param content Output string to store content
+         * @return True if the part exists and is not empty
+         */
+        bool read_part(const std::string& part_name, std::string& content) const;
+
+        /**
+         * @brief Get the content type of a part
+         * @param part_name Path of the part within the archive
+         * @return Type from its override or from the default of its extension, empty if neither exists
+         */
+        [[nodiscard]] std::string content_type(const std::string& part_name) const;
+
+        /**
+         * @brief List the parts of a content type
+         * @param type Content type to look for
+         * @return Part names in archive order
+         */
+        [[nodiscard]] std::vector<std::string> parts_of_type(const std::string& type) const;
+
+        /**
+         * @brief List the targets of package-level relationships of a type
+         * @param type Relationship type in _rels/.rels
+         * @return Part names of the internal targets
+         */
+        [[nodiscard]] std::vector<std::string> package_relationships(const std::string& type) const;
+
+        /**
+         * @brief Remove parts together with everything that refers to them
+         *
+         * Their content type overrides and the relationships pointing at them
+         * are removed as well, and so are their own relationship parts. Call
+         * it at most once per edit, it rewrites [Content_Types].xml and the
+         * relationship parts from the archive.
+         *
+         * @param edit Edit collecting the changes
+         * @param part_names Parts to remove
+         */
+        void remove_parts(package_edit& edit, const std::set<std::string>& part_names) const;
+
+        /**
+         * @brief Write the package with an edit applied into a sink
+         *
+         * Unchanged entries are copied with their compressed data as is, only
+         * replaced parts are deflated again, in parallel when workers are
+         * given. The package is closed afterwards, successful or not, so the
+         * sink may replace the file it was mapped from.
+         *
+         * @param out Sink receiving the package
+         * @param edit Part changes to apply
+         * @param options Compression level and workers of the rewrite
+         * @throws std::runtime_error if the package is not open or an entry cannot be written
+         */
+        void write_to(file_io::byte_sink& out, const package_edit& edit, const zip_entries::write_options& options);
+
+    private:
+        std::unique_ptr<file_io::byte_source> input;
+        zip* archive {nullptr};
+        std::vector<zip_entries::entry> directory;
+        std::unordered_map<std::string, zip_uint64_t> entry_index;
+        std::vector<std::string> entry_names;                       // archive order
+        std::unordered_map<std::string, std::string> overrides;     // part name without the leading '/'
+        std::unordered_map<std::string, std::string> defaults;      // lower-case extension
+        mutable std::mutex read_mutex;                              // a libzip handle is not thread-safe
+    };
+
+    /**
+     * @brief Resolve a relationship target against the part that holds the relationship
+     * @param relationships_part Name of the .rels part, such as "word/_rels/document.xml.rels"
+     * @param target Target attribute, relative or starting with '/'
+     * @return Part name within the archive
+     */
+    std::string resolve_target(const std::string& relationships_part, const std::string& target);
+
+}
@@ -0,0 +1,165 @@
+/**
+ * @file ooxml_processor.h
+ * @brief Metadata processor shared by the Office Open XML formats
+ */
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+#include <pugixml.hpp>
+#include "./base/file_handler.h"
+#include "./processors/ooxml_package.h"
+
+namespace ooxml_processor {
+
+    /**
+     * @brief Base processor for DOCX, XLSX and PPTX packages
+     *
+     * Parts are found through [Content_Types].xml, so the same code handles
+     * every format. Keys are reported as "Core.<property>",
+     * "App.<property>", "Custom.<name>", "Comments.Authors" for the people
+     * named in comments and people parts, and "Package.Thumbnail".
+     *
+     * Cleaning empties the core and extended properties, removes custom
+     * properties, thumbnails and Word's people.xml, and clears the names of
+     * comment authors. Embedded JPEG and PNG images, such as photos pasted
+     * into a document, are cleaned like standalone images, also when only
+     * selected keys or a policy decide what goes, in parallel on the worker
+     * pool of the options. All changes of an
+     * operation are written with one archive rewrite. Formats only tell
+     * their name and main part content types.
+     */
+    class ooxml_processor_class : public file_handler::file_handler_class {
+    public:
+        /**
+         * @brief Constructor
+         * @param path Path to the package
+         * @param type Operation type
+         * @param opts Shared operation options
+         * @param probe Result of the type probe
+         * @param buffers In-memory input and output used instead of the file
+         */
+        ooxml_processor_class(const std::string& path,
+                              file_handler::operation_type type,
+                              file_handler::shared_options opts,
+                              file_properties::file_type_probe probe = {},
+                              file_handler::buffer_binding buffers = {});
+
+        /**
+         * @brief Destructor
+         */
+        ~ooxml_processor_class() override;
+
+    protected:
+        /**
+         * @brief Check if the file is a package of the processor's format
+         * @return Operation result
+         */
+        file_handler::operation_result check_prerequisites() override;
+
+        /**
+         * @brief Read metadata from the package
+         * @return Operation result with metadata
+         */
+        file_handler::operation_result read_metadata() override;
+
+        /**
+         * @brief Clean metadata from the package
+         * @return Operation result
+         */
+        file_handler::operation_result clean_metadata() override;
+
+        /**
+         * @brief Overwrite metadata in the package
+         * @return Operation result
+         */
+        file_handler::operation_result overwrite_metadata() override;
+
+        /**
+         * @brief Export metadata to external file
+         * @return Operation result
+         */
+        file_handler::operation_result export_metadata() override;
+
+        /**
+         * @brief Restore metadata from backup
+         * @return Operation result
+         */
+        file_handler::operation_result restore_metadata() override;
+
+        /**
+         * @brief Get the name of the format used in messages
+         * @return Format name, such as "DOCX"
+         */
+        [[nodiscard]] virtual const char* format_name() const = 0;
+
+        /**
+         * @brief Get the content types the main part of the format may have
+         * @return Content types of documents, templates and their macro-enabled variants
+         */
+        [[nodiscard]] virtual std::vector<std::string> main_content_types() const = 0;
+
+    private:
+        /**
+         * @brief Remove only the properties selected in the options
+         * @return Operation result
+         */
+        file_handler::operation_result clean_selected_metadata();
+
+        /**
+         * @brief Collect the removal of custom properties, comment authors, people and thumbnails
+         * @param drop Decides which keys are removed, nullptr removes all of them
+         * @param edit Edit collecting the changes
+         */
+        void strip_package_metadata(const std::function<bool(const std::string&)>& drop,
+                                    ooxml_package::package_edit& edit) const;
+
+        /**
+         * @brief Collect embedded JPEG and PNG images with their metadata removed
+         *
+         * Each image is inflated and cleaned on a worker of its own, parts
+         * the edit already removes are left out. Without a selection all
+         * metadata segments and chunks are stripped, with one the image goes
+         * through clean_selected_image.
+         *
+         * @param edit Edit collecting the changes
+         * @param warnings Collects images that could not be cleaned
+         */
+        void scrub_media(ooxml_package::package_edit& edit, std::vector<std::string>& warnings) const;
+
+        /**
+         * @brief Remove the selected keys from an embedded image
+         *
+         * The image is cleaned in memory by the processor of its type with the
+         * options of this operation, so a selection or policy such as
+         * "drop GPS*" matches the EXIF and XMP keys it reports for a
+         * standalone image.
+         *
+         * @param part_name Part name, its extension helps pick the processor
+         * @param data Image content
+         * @param cleaned Receives the cleaned image if anything was removed
+         * @param warnings Receives the warnings of the image processor
+         * @return True if the image changed
+         * @throws std::runtime_error if the image processor fails
+         */
+        bool clean_selected_image(const std::string& part_name, const std::string& data, std::string& cleaned,
+                                  std::vector<std::string>& warnings) const;
+
+        /**
+         * @brief Commit a package edit and write the result to the output
+         * @param edit Part changes to apply
+         * @return True if successful, false otherwise
+         */
+        bool commit_edit(const ooxml_package::package_edit& edit);
+
+        ooxml_package::package_class package;
+        std::string core_part;          // core properties part, empty if the package has none
+        std::string app_part;           // extended properties part, empty if the package has none
+        std::unique_ptr<pugi::xml_document> core_xml;
+        std::unique_ptr<pugi::xml_document> app_xml;
+        bool package_loaded;
+    };
+
+}
@@ -3,6 +3,8 @@
 #include <memory>
 #include <podofo/podofo.h>
 #include "./base/file_handler.h"
+#include "./base/file_io.h"
+#include "./processors/pdf_structure.h"
 
 namespace pdf_processor {
 
@@ -15,7 +17,9 @@ namespace pdf_processor {
     public:
         pdf_processor_class(const std::string& path,
                       file_handler::operation_type type,
-                      const file_handler::operation_options& opts);
+                      file_handler::shared_options opts,
+                      file_properties::file_type_probe probe = {},
+                      file_handler::buffer_binding buffers = {});
         ~pdf_processor_class() override;
     protected:
         file_handler::operation_result check_prerequisites() override;
@@ -25,8 +29,19 @@ namespace pdf_processor {
         file_handler::operation_result export_metadata() override;
         file_handler::operation_result restore_metadata() override;
     private:
+        void load_document();
+        void save_document();
+        bool open_structure();
+        file_handler::operation_result read_structure_metadata();
+        file_handler::operation_result clean_structure();
+
+        // PoDoFo reads through a device over this mapping or buffer, it must outlive pdf_document
+        std::unique_ptr<file_io::byte_source> input_map;
         std::unique_ptr<PoDoFo::PdfMemDocument> pdf_document;
         bool pdf_loaded;
+        // Lazy reader used by READ, EXPORT and CLEAN instead of a full load
+        std::unique_ptr<file_io::byte_source> pdf_input;
+        std::unique_ptr<pdf_structure::pdf_reader_class> pdf_reader;
     };
 
 }
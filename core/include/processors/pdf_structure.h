@@ -0,0 +1,239 @@
+/**
+ * @file pdf_structure.h
+ * @brief Lightweight PDF reader that resolves objects through the cross-reference data on demand
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+#include "./base/file_io.h"
+
+namespace pdf_structure {
+
+    /**
+     * @brief Parsed PDF value
+     *
+     * Spans refer to the buffer the value was parsed from. For objects loaded
+     * from the file they are absolute file offsets.
+     */
+    struct value {
+        enum class kind {
+            NONE,
+            NULL_VALUE,
+            BOOLEAN,
+            NUMBER,
+            STRING,
+            NAME,
+            ARRAY,
+            DICTIONARY,
+            REFERENCE
+        };
+
+        kind type {kind::NONE};
+        std::string text;                 // string bytes, name without slash, number or boolean token
+        std::uint32_t object_number {0};  // reference target
+        std::uint32_t generation {0};
+        std::vector<value> items;
+        std::vector<std::pair<std::string, value>> entries;
+        std::uint64_t begin {0};
+        std::uint64_t end {0};
+
+        [[nodiscard]] bool is_dictionary() const { return type == kind::DICTIONARY; }
+        [[nodiscard]] bool is_reference() const { return type == kind::REFERENCE; }
+        [[nodiscard]] bool is_string() const { return type == kind::STRING; }
+
+        /**
+         * @brief Find a dictionary entry
+         * @return Pointer to the value, or nullptr if the key is missing
+         */
+        [[nodiscard]] const value* find(const std::string& key) const;
+
+        /**
+         * @brief Interpret a number as an integer
+         * @throws std::runtime_error if the value is not an integer
+         */
+        [[nodiscard]] long long as_integer() const;
+    };
+
+    /**
+     * @brief Object location taken from a cross-reference table or stream
+     */
+    struct xref_entry {
+        enum class kind {
+            FREE,
+            IN_USE,
+            COMPRESSED
+        };
+
+        kind type {kind::FREE};
+        std::uint64_t offset {0};      // byte offset, or the number of the containing object stream
+        std::uint32_t generation {0};  // generation, or the index inside the object stream
+    };
+
+    /**
+     * @brief Indirect object together with its position in the file
+     */
+    struct indirect_object {
+        std::uint32_t number {0};
+        std::uint32_t generation {0};
+        value object;
+        std::uint64_t begin {0};          // offset of the "n g obj" header
+        std::uint64_t end {0};            // offset just past "endobj"
+        bool has_stream {false};
+        std::uint64_t stream_offset {0};  // first byte of the raw stream data
+        std::uint64_t stream_length {0};
+        bool compressed {false};          // stored inside an object stream, spans refer to the decoded stream
+        std::uint32_t container {0};      // number of the object stream holding a compressed object
+    };
+
+    /**
+     * @brief Reader that only touches the bytes it needs
+     *
+     * Construction parses the trailer and the cross-reference sections of every
+     * revision. Classic tables are not loaded, entries are read on lookup.
+     * Objects are parsed when requested and stream data is never read unless
+     * asked for, so memory use does not grow with the document size.
+     * Only FlateDecode is supported for cross-reference and object streams.
+     */
+    class pdf_reader_class {
+    public:
+        /**
+         * @brief Parse the cross-reference data of a PDF
+         * @param source PDF data, must outlive the reader
+         * @throws std::runtime_error if the structure cannot be parsed
+         */
+        explicit pdf_reader_class(const file_io::byte_source& source);
+
+        /**
+         * @brief Get the trailer dictionary of the newest revision
+         */
+        [[nodiscard]] const value& get_trailer() const { return trailer; }
+
+        /**
+         * @brief Check if the document is encrypted, strings are then unreadable without a key
+         */
+        [[nodiscard]] bool is_encrypted() const { return trailer.find("Encrypt") != nullptr; }
+
+        /**
+         * @brief Get the number of object slots declared by the trailer
+         */
+        [[nodiscard]] std::uint32_t get_size() const;
+
+        /**
+         * @brief Look up an object in the cross-reference data
+         * @return False if the object does not exist or is free
+         */
+        bool find_entry(std::uint32_t number, xref_entry& entry) const;
+
+        /**
+         * @brief Load an indirect object
+         * @throws std::runtime_error if the object is missing or malformed
+         */
+        [[nodiscard]] indirect_object get_object(std::uint32_t number) const;
+
+        /**
+         * @brief Resolve a reference, other values are returned unchanged
+         *
+         * References to missing objects resolve to the null value, as the PDF
+         * specification requires.
+         */
+        [[nodiscard]] value resolve(const value& val) const;
+
+        /**
+         * @brief Read and decode the data of a stream object
+         * @throws std::runtime_error if a filter is not supported
+         */
+        [[nodiscard]] std::vector<unsigned char> read_stream(const indirect_object& object) const;
+
+        /**
+         * @brief Get the source bytes of a value that belongs to an object
+         *
+         * Values of the trailer can be passed with a default-constructed object.
+         */
+        [[nodiscard]] std::string read_raw(const indirect_object& object, const value& val) const;
+
+        /**
+         * @brief Get the offset of the newest cross-reference section
+         */
+        [[nodiscard]] std::uint64_t get_startxref() const { return startxref; }
+
+        [[nodiscard]] const file_io::byte_source& get_source() const { return source; }
+
+    private:
+        struct object_stream {
+            std::vector<unsigned char> data;
+            std::size_t first {0};
+            std::size_t count {0};
+        };
+
+        struct xref_section {
+            std::uint32_t first {0};
+            std::uint32_t count {0};
+            std::uint64_t table_offset {0};   // classic table, entries read on demand
+            unsigned entry_size {20};
+            std::vector<xref_entry> entries;  // cross-reference stream, decoded up front
+        };
+
+        std::uint64_t find_startxref() const;
+        void read_xref_chain(std::uint64_t offset);
+        value read_xref_table(std::uint64_t offset);
+        value read_xref_stream(std::uint64_t offset);
+        xref_entry read_table_entry(const xref_section& section, std::uint32_t number) const;
+        indirect_object load_object_at(std::uint64_t offset) const;
+        indirect_object load_compressed_object(std::uint32_t number, const xref_entry& entry) const;
+        std::uint64_t stream_length(const value& dictionary) const;
+        std::uint64_t find_stream_end(std::uint64_t offset) const;
+
+        const file_io::byte_source& source;
+        std::uint64_t startxref {0};
+        value trailer;
+        std::vector<xref_section> sections;  // newest revision first
+
+        // Decoded object streams, Info often lives in one
+        mutable std::map<std::uint32_t, std::shared_ptr<const object_stream>> object_streams;
+        // Guards against /Length references that lead back into a stream
+        mutable unsigned length_depth {0};
+    };
+
+    /**
+     * @brief Changes applied while copying a document
+     */
+    struct rewrite_plan {
+        std::set<std::string> removed_trailer_keys;
+        // Dictionary keys dropped from individual objects
+        std::map<std::uint32_t, std::set<std::string>> removed_keys;
+    };
+
+    /**
+     * @brief Write the document as a single revision, copying objects byte for byte
+     *
+     * Only objects reachable from the trailer are written, so whatever the plan
+     * unlinks (an Info dictionary, an XMP stream) is dropped together with stale
+     * objects of earlier revisions. Objects outside the plan are copied from the
+     * source without re-serialisation and streams are never decoded. Objects of
+     * object streams are written as plain objects and a classic cross-reference
+     * table replaces the original ones.
+     *
+     * @param reader Reader over the source document
+     * @param sink Destination of the new document
+     * @param plan Keys to remove
+     * @return Number of objects written
+     * @throws std::runtime_error if the document cannot be copied this way
+     */
+    std::size_t write_copy(const pdf_reader_class& reader, file_io::byte_sink& sink, const rewrite_plan& plan);
+
+    /**
+     * @brief Convert a PDF text string to UTF-8
+     *
+     * Handles UTF-16BE and UTF-8 strings with a byte order mark, anything else
+     * is taken as PDFDocEncoding.
+     */
+    std::string decode_text_string(const std::string& raw);
+
+}
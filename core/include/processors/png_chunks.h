@@ -0,0 +1,120 @@
+/**
+ * @file png_chunks.h
+ * @brief Chunk-level PNG parsing and metadata stripping without decoding
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "./base/file_io.h"
+
+namespace png_chunks {
+
+    /**
+     * @brief Size of the PNG signature preceding the first chunk
+     */
+    constexpr std::size_t signature_size = 8;
+
+    /**
+     * @brief Location of one chunk in the source
+     */
+    struct chunk {
+        std::string type;               // four-letter chunk type, e.g. "tEXt"
+        std::uint64_t offset;           // offset of the length field
+        std::uint64_t data_offset;      // first byte after the type field
+        std::uint32_t length;           // length of the chunk data
+
+        /**
+         * @brief Size of the whole chunk including length, type and CRC
+         */
+        [[nodiscard]] std::uint64_t size() const { return 12 + static_cast<std::uint64_t>(length); }
+    };
+
+    enum class chunk_action {
+        KEEP,
+        REMOVE,
+        REPLACE
+    };
+
+    /**
+     * @brief Check if data starts with the PNG signature
+     * @param data Leading bytes of a file
+     * @param size Number of bytes available
+     */
+    bool has_signature(const unsigned char* data, std::size_t size);
+
+    /**
+     * @brief Check if a chunk only carries metadata
+     * @return True for tEXt, zTXt, iTXt, eXIf and tIME
+     */
+    bool is_metadata(const chunk& c);
+
+    /**
+     * @brief Walk the chunks up to and including IEND
+     *
+     * Only the length and type fields are read, chunk data is left to the
+     * callback and CRCs are not verified.
+     *
+     * @param source PNG data
+     * @param callback Called for every chunk in file order
+     * @return Offset just past IEND, or the end of the source if IEND is missing
+     * @throws std::runtime_error if the signature or a chunk header is invalid
+     */
+    std::uint64_t walk(const file_io::byte_source& source, const std::function<void(const chunk&)>& callback);
+
+    /**
+     * @brief Compute the CRC of a chunk
+     * @param type Four-letter chunk type
+     * @param data Chunk data
+     * @param size Size of the chunk data
+     * @return CRC-32 over type and data
+     */
+    std::uint32_t chunk_crc(const std::string& type, const unsigned char* data, std::size_t size);
+
+    /**
+     * @brief Append a complete chunk with a freshly computed CRC
+     * @param sink Destination
+     * @param type Four-letter chunk type
+     * @param data Chunk data
+     * @param size Size of the chunk data
+     */
+    void write_chunk(file_io::byte_sink& sink, const std::string& type, const unsigned char* data, std::size_t size);
+
+    /**
+     * @brief Copy a PNG, removing or replacing chunks
+     *
+     * Kept chunks, IDAT included, are copied byte for byte with their original
+     * CRC, adjacent ones as one range. Only replaced chunks get a new CRC.
+     * Anything after IEND is dropped.
+     *
+     * @param source PNG data
+     * @param sink Destination of the rewritten PNG
+     * @param edit Called for every chunk but IEND, fills the data of a chunk it replaces
+     * @param insert Called once before the first IDAT (or IEND) is copied, to add new chunks
+     *        where every reader expects them
+     * @return Number of chunks removed or replaced
+     * @throws std::runtime_error if the signature or a chunk header is invalid
+     */
+    std::size_t rewrite(const file_io::byte_source& source, file_io::byte_sink& sink,
+                        const std::function<chunk_action(const chunk&, std::vector<unsigned char>&)>& edit,
+                        const std::function<void(file_io::byte_sink&)>& insert = nullptr);
+
+    /**
+     * @brief Copy a PNG, leaving out chunks
+     *
+     * @param source PNG data
+     * @param sink Destination of the cleaned PNG
+     * @param remove Decides which chunks are left out
+     * @param insert Called once before the first IDAT (or IEND) is copied, to add new chunks
+     *        where every reader expects them
+     * @return Number of chunks removed
+     * @throws std::runtime_error if the signature or a chunk header is invalid
+     */
+    std::size_t strip(const file_io::byte_source& source, file_io::byte_sink& sink,
+                      const std::function<bool(const chunk&)>& remove = is_metadata,
+                      const std::function<void(file_io::byte_sink&)>& insert = nullptr);
+
+}
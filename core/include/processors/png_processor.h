@@ -0,0 +1,80 @@
+/**
+ * @file png_processor.h
+ * @brief PNG metadata processor working on chunks without decoding the image
+ */
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "./base/file_handler.h"
+#include "./processors/png_chunks.h"
+
+namespace png_processor {
+
+    /**
+     * @brief Processor for PNG images
+     *
+     * Metadata lives in tEXt, zTXt and iTXt text chunks, the eXIf chunk and
+     * the tIME chunk. Keys are reported as "Text.<keyword>", "EXIF.<key>" and
+     * "XMP.<key>" (from the iTXt chunk "XML:com.adobe.xmp"), and
+     * "Time.LastModified". Every operation walks the chunks once and copies
+     * IDAT unchanged, image data is never decompressed.
+     */
+    class png_processor_class : public file_handler::file_handler_class {
+    public:
+        /**
+         * @brief Constructor
+         * @param path Path to the PNG file
+         * @param type Operation type
+         * @param opts Shared operation options
+         * @param probe Result of the type probe
+         * @param buffers In-memory input and output used instead of the file
+         */
+        png_processor_class(const std::string& path,
+                            file_handler::operation_type type,
+                            file_handler::shared_options opts,
+                            file_properties::file_type_probe probe = {},
+                            file_handler::buffer_binding buffers = {});
+        ~png_processor_class() override;
+
+    protected:
+        file_handler::operation_result check_prerequisites() override;
+        file_handler::operation_result read_metadata() override;
+        file_handler::operation_result clean_metadata() override;
+        file_handler::operation_result overwrite_metadata() override;
+        file_handler::operation_result export_metadata() override;
+        file_handler::operation_result restore_metadata() override;
+
+    private:
+        /**
+         * @brief Remove the selected keys, rewriting eXIf and XMP chunks that keep other entries
+         */
+        file_handler::operation_result clean_selected_metadata();
+
+        /**
+         * @brief Decide what happens to one metadata chunk when only selected keys are removed
+         * @param source PNG data
+         * @param c Chunk to decide on
+         * @param data Filled with the new chunk data when the chunk is replaced
+         * @param warnings Collects keys that cannot be removed
+         */
+        png_chunks::chunk_action edit_selected(const file_io::byte_source& source, const png_chunks::chunk& c,
+                                               std::vector<unsigned char>& data,
+                                               std::vector<std::string>& warnings) const;
+    };
+
+}
+
+#include "./base/processor_factory.h"
+
+namespace {
+    /**
+     * @brief Static registrar for PNG files
+     */
+    processor_factory::processor_registrar<
+        png_processor::png_processor_class,
+        file_properties::type_major::PNG,
+        file_properties::type_minor::UNKNOWN
+    > register_png_processor;
+}
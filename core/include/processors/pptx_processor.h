@@ -0,0 +1,58 @@
+/**
+ * @file pptx_processor.h
+ * @brief Processor for PPTX file format metadata
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include "./processors/ooxml_processor.h"
+
+namespace pptx_processor {
+
+    /**
+     * @brief PPTX metadata processor
+     *
+     * PowerPoint presentations, slide shows, templates and their
+     * macro-enabled variants, handled by the shared OOXML package engine.
+     */
+    class pptx_processor_class : public ooxml_processor::ooxml_processor_class {
+    public:
+        /**
+         * @brief Constructor
+         * @param path Path to the PPTX file
+         * @param type Operation type
+         * @param opts Shared operation options
+         * @param probe Result of the type probe
+         * @param buffers In-memory input and output used instead of the file
+         */
+        pptx_processor_class(const std::string& path,
+                             file_handler::operation_type type,
+                             file_handler::shared_options opts,
+                             file_properties::file_type_probe probe = {},
+                             file_handler::buffer_binding buffers = {});
+
+        /**
+         * @brief Destructor
+         */
+        ~pptx_processor_class() override;
+
+    protected:
+        [[nodiscard]] const char* format_name() const override;
+        [[nodiscard]] std::vector<std::string> main_content_types() const override;
+    };
+
+}
+
+#include "./base/processor_factory.h"
+
+namespace {
+    /**
+     * @brief Static registrar for PPTX files
+     */
+    processor_factory::processor_registrar<
+        pptx_processor::pptx_processor_class,
+        file_properties::type_major::POWERPOINT,
+        file_properties::type_minor::PPTX
+    > register_pptx_processor;
+}
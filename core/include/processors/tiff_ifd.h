@@ -0,0 +1,47 @@
+/**
+ * @file tiff_ifd.h
+ * @brief In-place removal of TIFF IFD entries, as found in EXIF blocks
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <set>
+#include <string>
+#include <utility>
+
+namespace tiff_ifd {
+
+    /**
+     * @brief Tag of an entry together with the Exiv2 group name of its IFD
+     *
+     * The groups are "Image" (IFD0), "Photo" (Exif IFD), "GPSInfo", "Iop"
+     * (interoperability IFD) and "Thumbnail" (IFD1).
+     */
+    using tag_ref = std::pair<std::string, std::uint16_t>;
+
+    /**
+     * @brief Check if entries of a group can be removed by remove_entries
+     * @param group Exiv2 group name
+     * @return True for the IFDs reachable from IFD0 without a maker note
+     */
+    bool is_supported_group(const std::string& group);
+
+    /**
+     * @brief Remove entries from a TIFF structure without moving any other data
+     *
+     * The remaining entries of an IFD move up and its entry count shrinks, the
+     * freed entry slots and the value data of removed entries are zeroed, so the
+     * structure keeps its size and every offset stays valid. Removing a pointer
+     * to a sub-IFD also removes every entry of that IFD, removing the thumbnail
+     * offset also zeroes the thumbnail.
+     *
+     * @param data TIFF structure starting with its byte order mark
+     * @param size Size of the structure
+     * @param tags Entries to remove
+     * @return Number of entries removed
+     * @throws std::runtime_error if the structure is malformed
+     */
+    std::size_t remove_entries(unsigned char* data, std::size_t size, const std::set<tag_ref>& tags);
+
+}
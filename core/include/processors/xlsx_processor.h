@@ -0,0 +1,58 @@
+/**
+ * @file xlsx_processor.h
+ * @brief Processor for XLSX file format metadata
+ */
+#pragma once
+
+#include <string>
+#include <vector>
+#include "./processors/ooxml_processor.h"
+
+namespace xlsx_processor {
+
+    /**
+     * @brief XLSX metadata processor
+     *
+     * Excel workbooks, templates and their macro-enabled variants, handled by
+     * the shared OOXML package engine.
+     */
+    class xlsx_processor_class : public ooxml_processor::ooxml_processor_class {
+    public:
+        /**
+         * @brief Constructor
+         * @param path Path to the XLSX file
+         * @param type Operation type
+         * @param opts Shared operation options
+         * @param probe Result of the type probe
+         * @param buffers In-memory input and output used instead of the file
+         */
+        xlsx_processor_class(const std::string& path,
+                             file_handler::operation_type type,
+                             file_handler::shared_options opts,
+                             file_properties::file_type_probe probe = {},
+                             file_handler::buffer_binding buffers = {});
+
+        /**
+         * @brief Destructor
+         */
+        ~xlsx_processor_class() override;
+
+    protected:
+        [[nodiscard]] const char* format_name() const override;
+        [[nodiscard]] std::vector<std::string> main_content_types() const override;
+    };
+
+}
+
+#include "./base/processor_factory.h"
+
+namespace {
+    /**
+     * @brief Static registrar for XLSX files
+     */
+    processor_factory::processor_registrar<
+        xlsx_processor::xlsx_processor_class,
+        file_properties::type_major::EXCEL,
+        file_properties::type_minor::XLSX
+    > register_xlsx_processor;
+}
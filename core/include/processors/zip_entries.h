@@ -0,0 +1,101 @@
+/**
+ * @file zip_entries.h
+ * @brief Entry-level ZIP archive rewriting with parallel compression
+ */
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+#include "./base/file_io.h"
+#include "./base/thread_pool.h"
+
+namespace zip_entries {
+
+    /**
+     * @brief Compression level of zlib's default speed and size tradeoff
+     */
+    constexpr int default_compression = -1;
+
+    /**
+     * @brief Entry of the central directory
+     */
+    struct entry {
+        std::string name;                   // raw name bytes as stored
+        std::uint16_t version_made_by {20};
+        std::uint16_t version_needed {20};
+        std::uint16_t flags {0};
+        std::uint16_t method {0};           // 0 stored, 8 deflated
+        std::uint16_t time {0};             // MS-DOS time and date
+        std::uint16_t date {0x21};
+        std::uint32_t crc {0};
+        std::uint64_t compressed_size {0};
+        std::uint64_t size {0};
+        std::uint32_t external_attributes {0};
+        std::uint64_t header_offset {0};    // offset of the local header
+    };
+
+    /**
+     * @brief Settings of an archive rewrite
+     */
+    struct write_options {
+        // zlib level, 0 stores, 1 is fastest and 9 smallest
+        int compression_level {default_compression};
+        // Workers compressing replaced entries, nullptr compresses them on the calling thread
+        thread_pool::thread_pool_class* workers {nullptr};
+    };
+
+    /**
+     * @brief Read the central directory, Zip64 records included
+     *
+     * @param source ZIP archive
+     * @return Entries in directory order
+     * @throws std::runtime_error if the end of central directory record is missing or a record is invalid
+     */
+    std::vector<entry> read_directory(const file_io::byte_source& source);
+
+    /**
+     * @brief Check if read_entry can decode an entry
+     * @return True for unencrypted stored and deflated entries
+     */
+    bool can_read(const entry& e);
+
+    /**
+     * @brief Read the content of a stored or deflated entry
+     *
+     * Only the local header and data of the entry are read, a mapped source
+     * in place, so several threads may read entries of one source at once.
+     * The content may not grow beyond the size in the directory.
+     *
+     * @param source ZIP archive
+     * @param e Entry from read_directory
+     * @return Uncompressed content
+     * @throws std::runtime_error if the entry cannot be decoded or its size or CRC does not match
+     */
+    std::string read_entry(const file_io::byte_source& source, const entry& e);
+
+    /**
+     * @brief Copy an archive with entries replaced, added or removed
+     *
+     * Kept entries are copied with their compressed data as is. Replaced and
+     * added entries are deflated first, concurrently on the workers, and the
+     * archive is then written in one pass in the order of the source
+     * directory, added entries last. Extra fields, such as extended
+     * timestamps, and the archive comment are not carried over, and Zip64
+     * records are only written when sizes or offsets need them.
+     *
+     * @param source ZIP archive
+     * @param directory Central directory of the source, as returned by read_directory
+     * @param replacements New content by entry name, names missing from the directory are added
+     * @param removals Names of entries to leave out
+     * @param sink Destination of the rewritten archive
+     * @param options Compression level and workers
+     * @throws std::runtime_error if an entry cannot be located in the source or compression fails
+     */
+    void rewrite(const file_io::byte_source& source, const std::vector<entry>& directory,
+                 const std::map<std::string, std::string>& replacements, const std::set<std::string>& removals,
+                 file_io::byte_sink& sink, const write_options& options = {});
+
+}
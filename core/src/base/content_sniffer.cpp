@@ -0,0 +1,160 @@
+/**
+ * @file content_sniffer.cpp
+ * @brief Implementation of magic-byte based file type detection
+ */
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include "./base/content_sniffer.h"
+
+namespace content_sniffer {
+
+    using file_properties::category;
+    using file_properties::type_major;
+    using file_properties::type_minor;
+    using file_properties::file_type_probe;
+
+    namespace {
+
+        /**
+         * @brief Refines a raw signature match, returns false if the file type stays undecided
+         */
+        using refine_func = bool (*)(const unsigned char*, std::size_t, file_type_probe&);
+
+        /**
+         * @brief Entry of the signature table
+         */
+        struct signature {
+            const char* magic;
+            std::size_t magic_size;
+            std::size_t offset;          // fixed offset of the magic bytes
+            std::size_t search_window;   // if non-zero, the magic may start anywhere below this offset
+            category file_category;
+            type_major file_type_major;
+            type_minor file_type_minor;
+            refine_func refine;
+        };
+
+        unsigned int read_le16(const unsigned char* p) {
+            return static_cast<unsigned int>(p[0]) | (static_cast<unsigned int>(p[1]) << 8);
+        }
+
+        void set_type(file_type_probe& probe, category cat, type_major major, type_minor minor) {
+            probe.file_category = cat;
+            probe.file_type_major = major;
+            probe.file_type_minor = minor;
+        }
+
+        bool is_ooxml(const file_type_probe& probe) {
+            return probe.file_type_minor == type_minor::DOCX ||
+                   probe.file_type_minor == type_minor::XLSX ||
+                   probe.file_type_minor == type_minor::PPTX;
+        }
+
+        /**
+         * @brief Tell OOXML packages from plain ZIP archives by the entry names in the local headers
+         */
+        bool refine_zip(const unsigned char* data, std::size_t size, file_type_probe& probe) {
+            static const unsigned char local_header[] = {'P', 'K', 0x03, 0x04};
+            bool has_content_types = false;
+
+            const unsigned char* end = data + size;
+            const unsigned char* pos = data;
+            while ((pos = std::search(pos, end, local_header, local_header + 4)) != end) {
+                if (end - pos < 30) {
+                    break;
+                }
+                const std::size_t name_size = read_le16(pos + 26);
+                if (static_cast<std::size_t>(end - pos) < 30 + name_size) {
+                    break;
+                }
+
+                const std::string name(reinterpret_cast<const char*>(pos + 30), name_size);
+                if (name == "[Content_Types].xml") {
+                    has_content_types = true;
+                } else if (name.compare(0, 5, "word/") == 0) {
+                    set_type(probe, category::DOCUMENT, type_major::WORD, type_minor::DOCX);
+                    return true;
+                } else if (name.compare(0, 3, "xl/") == 0) {
+                    set_type(probe, category::DOCUMENT, type_major::EXCEL, type_minor::XLSX);
+                    return true;
+                } else if (name.compare(0, 4, "ppt/") == 0) {
+                    set_type(probe, category::DOCUMENT, type_major::POWERPOINT, type_minor::PPTX);
+                    return true;
+                }
+                pos += 30 + name_size;
+            }
+
+            // The parts that tell the OOXML flavours apart may lie beyond the probed bytes
+            if (is_ooxml(probe)) {
+                return false;
+            }
+
+            set_type(probe, has_content_types ? category::DOCUMENT : category::ARCHIVE,
+                     type_major::UNKNOWN, type_minor::UNKNOWN);
+            return true;
+        }
+
+        /**
+         * @brief Classify ISO base media files by their major brand
+         */
+        bool refine_ftyp(const unsigned char* data, std::size_t size, file_type_probe& probe) {
+            set_type(probe, category::VIDEO, type_major::MP4, type_minor::UNKNOWN);
+            if (size < 12) {
+                return true;
+            }
+
+            const std::string brand(reinterpret_cast<const char*>(data + 8), 4);
+            if (brand == "M4A " || brand == "M4B ") {
+                probe.file_category = category::AUDIO;
+            } else if (brand == "heic" || brand == "heix" || brand == "mif1" || brand == "msf1" || brand == "avif") {
+                probe.file_category = category::IMAGE;
+                probe.file_type_major = type_major::UNKNOWN;
+            }
+            return true;
+        }
+
+        const signature signatures[] = {
+            {"\xFF\xD8\xFF", 3, 0, 0, category::IMAGE, type_major::JPEG, type_minor::JPEG, nullptr},
+            {"\x89PNG\r\n\x1A\n", 8, 0, 0, category::IMAGE, type_major::PNG, type_minor::UNKNOWN, nullptr},
+            {"GIF87a", 6, 0, 0, category::IMAGE, type_major::UNKNOWN, type_minor::UNKNOWN, nullptr},
+            {"GIF89a", 6, 0, 0, category::IMAGE, type_major::UNKNOWN, type_minor::UNKNOWN, nullptr},
+            {"II*\0", 4, 0, 0, category::IMAGE, type_major::UNKNOWN, type_minor::UNKNOWN, nullptr},
+            {"MM\0*", 4, 0, 0, category::IMAGE, type_major::UNKNOWN, type_minor::UNKNOWN, nullptr},
+            {"PK\x03\x04", 4, 0, 0, category::ARCHIVE, type_major::UNKNOWN, type_minor::UNKNOWN, refine_zip},
+            {"ID3", 3, 0, 0, category::AUDIO, type_major::MP3, type_minor::UNKNOWN, nullptr},
+            {"ftyp", 4, 4, 0, category::VIDEO, type_major::MP4, type_minor::UNKNOWN, refine_ftyp},
+            // PDF readers accept the header anywhere in the first 1024 bytes
+            {"%PDF-", 5, 0, 1024, category::DOCUMENT, type_major::PDF, type_minor::UNKNOWN, nullptr},
+        };
+
+        bool matches(const signature& sig, const unsigned char* data, std::size_t size) {
+            const auto* magic = reinterpret_cast<const unsigned char*>(sig.magic);
+            if (sig.search_window == 0) {
+                return size >= sig.offset + sig.magic_size &&
+                       std::memcmp(data + sig.offset, magic, sig.magic_size) == 0;
+            }
+
+            const unsigned char* end = data + std::min(size, sig.search_window + sig.magic_size);
+            return std::search(data, end, magic, magic + sig.magic_size) != end;
+        }
+
+    }
+
+    bool sniff(const unsigned char* data, std::size_t size, file_type_probe& probe) {
+        for (const auto& sig : signatures) {
+            if (!matches(sig, data, size)) {
+                continue;
+            }
+
+            if (sig.refine) {
+                return sig.refine(data, size, probe);
+            }
+
+            set_type(probe, sig.file_category, sig.file_type_major, sig.file_type_minor);
+            return true;
+        }
+        return false;
+    }
+
+}
@@ -1,15 +1,129 @@
 #include <algorithm>
 #include <filesystem>
+#include <utility>
 #include "./base/file_handler.h"
+#include "./base/file_hasher.h"
 #include "./base/processor_factory.h"
 
 namespace file_handler {
 
-    file_handler_class::file_handler_class(const std::string &path, operation_type type, const operation_options& opts)
-        : file_properties_class(path), type(type), options(opts) {}
+    namespace {
+
+        /**
+         * @brief Memory sink that hands its content to a buffer binding on commit
+         */
+        class buffer_output : public file_io::memory_sink {
+        public:
+            explicit buffer_output(std::vector<unsigned char>* target) : target(target) {}
+
+            void commit() override {
+                if (target != nullptr) {
+                    target->swap(get_data());
+                }
+            }
+
+        private:
+            std::vector<unsigned char>* target;
+        };
+
+    }
+
+    shared_options make_options(operation_options options) {
+        auto& selected = options.selected_properties;
+        selected.erase(std::remove(selected.begin(), selected.end(), std::string()), selected.end());
+        if (!options.output_directory.empty()) {
+            options.output_directory = options.output_directory.lexically_normal();
+        }
+        options.compression_level = std::clamp(options.compression_level, -1, 9);
+        return std::make_shared<const operation_options>(std::move(options));
+    }
+
+    file_handler_class::file_handler_class(const std::string &path, operation_type type, shared_options opts,
+                                           file_properties::file_type_probe probe, buffer_binding buffers)
+        : file_properties_class(path, opts->hash_algorithm, std::move(probe)), type(type),
+          options_holder(std::move(opts)), options(*options_holder), buffers(buffers) {}
 
     file_handler_class::~file_handler_class() = default;
 
+    std::unique_ptr<file_io::byte_source> file_handler_class::open_input() const {
+        if (in_memory()) {
+            return std::make_unique<file_io::memory_source>(buffers.data, buffers.size);
+        }
+        return std::make_unique<file_io::input_file>(file_path);
+    }
+
+    std::unique_ptr<file_io::byte_source> file_handler_class::map_input() const {
+        if (in_memory()) {
+            return std::make_unique<file_io::memory_source>(buffers.data, buffers.size);
+        }
+        return std::make_unique<file_io::mapped_file>(file_path);
+    }
+
+    std::filesystem::path file_handler_class::get_output_path() const {
+        if (!options.output_directory.empty() &&
+            (type == operation_type::CLEAN || type == operation_type::OVERWRITE)) {
+            return options.output_directory / file_name;
+        }
+        return file_path;
+    }
+
+    std::unique_ptr<file_io::byte_sink> file_handler_class::open_output() const {
+        if (in_memory()) {
+            return std::make_unique<buffer_output>(buffers.output);
+        }
+
+        const std::filesystem::path output_path = get_output_path();
+        if (output_path.has_parent_path() && !std::filesystem::exists(output_path.parent_path())) {
+            std::filesystem::create_directories(output_path.parent_path());
+        }
+        return std::make_unique<file_io::output_file>(output_path.string(), output_batch);
+    }
+
+    void file_handler_class::commit_patches(const std::vector<file_io::byte_patch>& patches) const {
+        if (!in_memory() && get_output_path() == std::filesystem::path(file_path)) {
+            if (!patches.empty()) {
+                file_io::patch_file(file_path, patches);
+            }
+            return;
+        }
+
+        auto in = open_input();
+        auto out = open_output();
+        file_io::write_patched(*in, *out, patches);
+        in.reset();
+        out->commit();
+    }
+
+    void file_handler_class::commit_tail(std::uint64_t offset, const std::vector<unsigned char>& tail) const {
+        if (!in_memory() && get_output_path() == std::filesystem::path(file_path)) {
+            file_io::replace_tail(file_path, offset, tail);
+            return;
+        }
+
+        auto in = open_input();
+        auto out = open_output();
+        out->copy_from(*in, 0, offset);
+        out->write(tail.data(), tail.size());
+        in.reset();
+        out->commit();
+    }
+
+    void file_handler_class::init_file_hash() const {
+        if (in_memory()) {
+            file_hash = file_hasher::hash_buffer(buffers.data, buffers.size, file_hash_algorithm);
+            return;
+        }
+        file_properties_class::init_file_hash();
+    }
+
+    bool file_handler_class::is_selected(const std::string& key) const {
+        if (options.selected_properties.empty() && options.policy != nullptr) {
+            return options.policy->evaluate(key) == metadata_policy::action::DROP;
+        }
+        return std::any_of(options.selected_properties.begin(), options.selected_properties.end(),
+                           [&key](const std::string& pattern) { return match_key_pattern(pattern, key); });
+    }
+
     operation_result file_handler_class::execute_operation() {
         auto prereq_result = check_prerequisites();
         if (!prereq_result.success) {
@@ -33,6 +147,34 @@ namespace file_handler {
         }
     }
 
+    bool match_key_pattern(const std::string& pattern, const std::string& key) {
+        // Greedy wildcard matching that backtracks to the last '*' only
+        std::size_t p = 0;
+        std::size_t k = 0;
+        std::size_t star = std::string::npos;
+        std::size_t star_key = 0;
+
+        while (k < key.size()) {
+            if (p < pattern.size() && (pattern[p] == '?' || pattern[p] == key[k])) {
+                p++;
+                k++;
+            } else if (p < pattern.size() && pattern[p] == '*') {
+                star = p++;
+                star_key = k;
+            } else if (star != std::string::npos) {
+                p = star + 1;
+                k = ++star_key;
+            } else {
+                return false;
+            }
+        }
+
+        while (p < pattern.size() && pattern[p] == '*') {
+            p++;
+        }
+        return p == pattern.size();
+    }
+
     /**
      * @brief Create appropriate file handler for the given file
      *
@@ -48,9 +190,27 @@ namespace file_handler {
         const std::string& file_path,
         operation_type op_type,
         const operation_options& options
+    ) {
+        return create_handler(file_path, op_type, make_options(options));
+    }
+
+    std::unique_ptr<file_handler_class> create_handler(
+        const std::string& file_path,
+        operation_type op_type,
+        const shared_options& options
     ) {
         return processor_factory::processor_factory_class::create_processor(
             file_path, op_type, options);
     }
 
+    std::unique_ptr<file_handler_class> create_buffer_handler(
+        const std::string& name,
+        const buffer_binding& buffers,
+        operation_type op_type,
+        const shared_options& options
+    ) {
+        return processor_factory::processor_factory_class::create_buffer_processor(
+            name, buffers, op_type, options);
+    }
+
 }
\ No newline at end of file
@@ -0,0 +1,300 @@
+/**
+ * @file file_hasher.cpp
+ * @brief Implementation of streaming file hashing
+ */
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <vector>
+#include "./base/file_hasher.h"
+
+namespace file_hasher {
+
+    namespace {
+
+        constexpr std::size_t read_buffer_size = 64 * 1024;
+
+        std::uint64_t rotl64(std::uint64_t x, int r) {
+            return (x << r) | (x >> (64 - r));
+        }
+
+        std::uint32_t rotr32(std::uint32_t x, int r) {
+            return (x >> r) | (x << (32 - r));
+        }
+
+        std::uint64_t load_le64(const unsigned char* p) {
+            std::uint64_t v = 0;
+            for (int i = 7; i >= 0; i--) {
+                v = (v << 8) | p[i];
+            }
+            return v;
+        }
+
+        std::string to_hex(const unsigned char* bytes, std::size_t size) {
+            static const char digits[] = "0123456789abcdef";
+            std::string hex(size * 2, '0');
+            for (std::size_t i = 0; i < size; i++) {
+                hex[2 * i] = digits[bytes[i] >> 4];
+                hex[2 * i + 1] = digits[bytes[i] & 0x0F];
+            }
+            return hex;
+        }
+
+        /**
+         * @brief Incremental MurmurHash3 x64 128-bit
+         */
+        class murmur3_128 {
+        public:
+            void update(const unsigned char* data, std::size_t size) {
+                total += size;
+
+                // Complete a block left over from the previous call
+                if (tail_size > 0) {
+                    const std::size_t take = std::min(size, block_size - tail_size);
+                    std::memcpy(tail.data() + tail_size, data, take);
+                    tail_size += take;
+                    data += take;
+                    size -= take;
+                    if (tail_size < block_size) {
+                        return;
+                    }
+                    process_block(tail.data());
+                    tail_size = 0;
+                }
+
+                while (size >= block_size) {
+                    process_block(data);
+                    data += block_size;
+                    size -= block_size;
+                }
+
+                std::memcpy(tail.data(), data, size);
+                tail_size = size;
+            }
+
+            std::string finish() {
+                std::uint64_t k1 = 0;
+                std::uint64_t k2 = 0;
+                for (std::size_t i = tail_size; i > 8; i--) {
+                    k2 ^= static_cast<std::uint64_t>(tail[i - 1]) << ((i - 9) * 8);
+                }
+                if (tail_size > 8) {
+                    k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+                }
+                for (std::size_t i = std::min<std::size_t>(tail_size, 8); i > 0; i--) {
+                    k1 ^= static_cast<std::uint64_t>(tail[i - 1]) << ((i - 1) * 8);
+                }
+                if (tail_size > 0) {
+                    k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+                }
+
+                h1 ^= total;
+                h2 ^= total;
+                h1 += h2;
+                h2 += h1;
+                h1 = fmix64(h1);
+                h2 = fmix64(h2);
+                h1 += h2;
+                h2 += h1;
+
+                std::array<unsigned char, 16> digest {};
+                for (int i = 0; i < 8; i++) {
+                    digest[i] = static_cast<unsigned char>(h1 >> (56 - 8 * i));
+                    digest[8 + i] = static_cast<unsigned char>(h2 >> (56 - 8 * i));
+                }
+                return to_hex(digest.data(), digest.size());
+            }
+
+        private:
+            static constexpr std::size_t block_size = 16;
+            static constexpr std::uint64_t c1 = 0x87c37b91114253d5ULL;
+            static constexpr std::uint64_t c2 = 0x4cf5ad432745937fULL;
+
+            static std::uint64_t fmix64(std::uint64_t k) {
+                k ^= k >> 33;
+                k *= 0xff51afd7ed558ccdULL;
+                k ^= k >> 33;
+                k *= 0xc4ceb9fe1a85ec53ULL;
+                k ^= k >> 33;
+                return k;
+            }
+
+            void process_block(const unsigned char* block) {
+                std::uint64_t k1 = load_le64(block);
+                std::uint64_t k2 = load_le64(block + 8);
+
+                k1 *= c1; k1 = rotl64(k1, 31); k1 *= c2; h1 ^= k1;
+                h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+
+                k2 *= c2; k2 = rotl64(k2, 33); k2 *= c1; h2 ^= k2;
+                h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+            }
+
+            std::uint64_t h1 {0};
+            std::uint64_t h2 {0};
+            std::uint64_t total {0};
+            std::array<unsigned char, block_size> tail {};
+            std::size_t tail_size {0};
+        };
+
+        /**
+         * @brief Incremental SHA-256
+         */
+        class sha256 {
+        public:
+            void update(const unsigned char* data, std::size_t size) {
+                total += size;
+
+                if (buffer_size > 0) {
+                    const std::size_t take = std::min(size, block_size - buffer_size);
+                    std::memcpy(buffer.data() + buffer_size, data, take);
+                    buffer_size += take;
+                    data += take;
+                    size -= take;
+                    if (buffer_size < block_size) {
+                        return;
+                    }
+                    process_block(buffer.data());
+                    buffer_size = 0;
+                }
+
+                while (size >= block_size) {
+                    process_block(data);
+                    data += block_size;
+                    size -= block_size;
+                }
+
+                std::memcpy(buffer.data(), data, size);
+                buffer_size = size;
+            }
+
+            std::string finish() {
+                const std::uint64_t bit_length = total * 8;
+
+                // Pad with 0x80, zeros and the big-endian message length
+                buffer[buffer_size++] = 0x80;
+                if (buffer_size > block_size - 8) {
+                    std::memset(buffer.data() + buffer_size, 0, block_size - buffer_size);
+                    process_block(buffer.data());
+                    buffer_size = 0;
+                }
+                std::memset(buffer.data() + buffer_size, 0, block_size - 8 - buffer_size);
+                for (int i = 0; i < 8; i++) {
+                    buffer[block_size - 1 - i] = static_cast<unsigned char>(bit_length >> (8 * i));
+                }
+                process_block(buffer.data());
+
+                std::array<unsigned char, 32> digest {};
+                for (int i = 0; i < 8; i++) {
+                    for (int j = 0; j < 4; j++) {
+                        digest[4 * i + j] = static_cast<unsigned char>(state[i] >> (24 - 8 * j));
+                    }
+                }
+                return to_hex(digest.data(), digest.size());
+            }
+
+        private:
+            static constexpr std::size_t block_size = 64;
+
+            void process_block(const unsigned char* block) {
+                static constexpr std::uint32_t k[64] = {
+                    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+                    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+                    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+                    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+                    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+                    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+                    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+                    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+                };
+
+                std::uint32_t w[64];
+                for (int i = 0; i < 16; i++) {
+                    w[i] = (static_cast<std::uint32_t>(block[4 * i]) << 24) |
+                           (static_cast<std::uint32_t>(block[4 * i + 1]) << 16) |
+                           (static_cast<std::uint32_t>(block[4 * i + 2]) << 8) |
+                           static_cast<std::uint32_t>(block[4 * i + 3]);
+                }
+                for (int i = 16; i < 64; i++) {
+                    const std::uint32_t s0 = rotr32(w[i - 15], 7) ^ rotr32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+                    const std::uint32_t s1 = rotr32(w[i - 2], 17) ^ rotr32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+                    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+                }
+
+                std::uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+                std::uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+                for (int i = 0; i < 64; i++) {
+                    const std::uint32_t s1 = rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25);
+                    const std::uint32_t ch = (e & f) ^ (~e & g);
+                    const std::uint32_t t1 = h + s1 + ch + k[i] + w[i];
+                    const std::uint32_t s0 = rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22);
+                    const std::uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+                    const std::uint32_t t2 = s0 + maj;
+                    h = g; g = f; f = e; e = d + t1;
+                    d = c; c = b; b = a; a = t1 + t2;
+                }
+
+                state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+                state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+            }
+
+            std::array<std::uint32_t, 8> state {
+                0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+            };
+            std::uint64_t total {0};
+            std::array<unsigned char, block_size> buffer {};
+            std::size_t buffer_size {0};
+        };
+
+        template<typename Hasher>
+        std::string hash_stream(std::ifstream& file) {
+            Hasher hasher;
+            std::vector<char> buffer(read_buffer_size);
+            while (file) {
+                file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+                const std::streamsize bytes_read = file.gcount();
+                if (bytes_read <= 0) {
+                    break;
+                }
+                hasher.update(reinterpret_cast<const unsigned char*>(buffer.data()), static_cast<std::size_t>(bytes_read));
+            }
+            return hasher.finish();
+        }
+
+        template<typename Hasher>
+        std::string hash_memory(const void* data, std::size_t size) {
+            Hasher hasher;
+            hasher.update(static_cast<const unsigned char*>(data), size);
+            return hasher.finish();
+        }
+
+    }
+
+    std::string hash_file(const std::string& path, hash_algorithm algorithm) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            return "error";
+        }
+
+        switch (algorithm) {
+            case hash_algorithm::SHA256:
+                return hash_stream<sha256>(file);
+            case hash_algorithm::FAST_128:
+            default:
+                return hash_stream<murmur3_128>(file);
+        }
+    }
+
+    std::string hash_buffer(const void* data, std::size_t size, hash_algorithm algorithm) {
+        switch (algorithm) {
+            case hash_algorithm::SHA256:
+                return hash_memory<sha256>(data, size);
+            case hash_algorithm::FAST_128:
+            default:
+                return hash_memory<murmur3_128>(data, size);
+        }
+    }
+
+}
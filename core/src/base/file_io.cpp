@@ -0,0 +1,704 @@
+/**
+ * @file file_io.cpp
+ * @brief Implementation of byte sources and sinks
+ */
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <filesystem>
+#include <random>
+#include <stdexcept>
+#include <system_error>
+#include "./base/file_io.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+#endif
+
+namespace file_io {
+
+    namespace {
+
+        constexpr std::size_t copy_buffer_size = 256 * 1024;
+
+#ifdef _WIN32
+        const std::intptr_t invalid_handle = reinterpret_cast<std::intptr_t>(INVALID_HANDLE_VALUE);
+
+        HANDLE to_handle(std::intptr_t handle) {
+            return reinterpret_cast<HANDLE>(handle);
+        }
+
+        std::system_error last_error(const std::string& what) {
+            return {static_cast<int>(GetLastError()), std::system_category(), what};
+        }
+#else
+        const std::intptr_t invalid_handle = -1;
+
+        int to_fd(std::intptr_t handle) {
+            return static_cast<int>(handle);
+        }
+
+        std::system_error last_error(const std::string& what) {
+            return {errno, std::generic_category(), what};
+        }
+#endif
+
+        /**
+         * @brief Build a unique temporary file name in the directory of the target
+         */
+        std::filesystem::path temp_candidate(const std::string& target_path) {
+            static std::atomic<unsigned long long> counter {0};
+            thread_local std::mt19937_64 generator {std::random_device{}()};
+
+            const std::filesystem::path target(target_path);
+            const auto suffix = generator() ^ counter.fetch_add(1, std::memory_order_relaxed);
+
+            char hex[17];
+            for (int i = 0; i < 16; i++) {
+                hex[i] = "0123456789abcdef"[(suffix >> (60 - 4 * i)) & 0x0F];
+            }
+            hex[16] = '\0';
+
+            return target.parent_path() / ("." + target.filename().string() + ".mwtmp-" + hex);
+        }
+
+        /**
+         * @brief Persist the directory entries of a directory, renames are not durable before this
+         */
+        void sync_directory([[maybe_unused]] const std::filesystem::path& directory) {
+#ifndef _WIN32
+            const int dir_fd = ::open(directory.empty() ? "." : directory.c_str(), O_RDONLY | O_CLOEXEC);
+            if (dir_fd >= 0) {
+                ::fsync(dir_fd);
+                ::close(dir_fd);
+            }
+#endif
+        }
+
+    }
+
+    void byte_source::read_exact(std::uint64_t offset, void* buffer, std::size_t length) const {
+        if (read_at(offset, buffer, length) != length) {
+            throw std::runtime_error("Unexpected end of data at offset " + std::to_string(offset));
+        }
+    }
+
+    void byte_sink::copy_from(const byte_source& source, std::uint64_t offset, std::uint64_t length) {
+        if (const unsigned char* data = source.get_data()) {
+            if (offset + length > source.size()) {
+                throw std::runtime_error("Unexpected end of data at offset " + std::to_string(source.size()));
+            }
+            write(data + offset, static_cast<std::size_t>(length));
+            return;
+        }
+
+        std::vector<unsigned char> buffer(static_cast<std::size_t>(std::min<std::uint64_t>(length, copy_buffer_size)));
+        while (length > 0) {
+            const auto chunk = static_cast<std::size_t>(std::min<std::uint64_t>(length, buffer.size()));
+            source.read_exact(offset, buffer.data(), chunk);
+            write(buffer.data(), chunk);
+            offset += chunk;
+            length -= chunk;
+        }
+    }
+
+    // input_file
+
+    input_file::input_file(const std::string& path) : handle(invalid_handle) {
+#ifdef _WIN32
+        HANDLE file = CreateFileW(std::filesystem::path(path).wstring().c_str(), GENERIC_READ,
+                                  FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw last_error("Failed to open file: " + path);
+        }
+        handle = reinterpret_cast<std::intptr_t>(file);
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size)) {
+            auto error = last_error("Failed to get file size: " + path);
+            close();
+            throw error;
+        }
+        file_size = static_cast<std::uint64_t>(size.QuadPart);
+#else
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw last_error("Failed to open file: " + path);
+        }
+        handle = fd;
+
+        struct stat st {};
+        if (::fstat(fd, &st) != 0) {
+            auto error = last_error("Failed to get file size: " + path);
+            close();
+            throw error;
+        }
+        file_size = static_cast<std::uint64_t>(st.st_size);
+#endif
+    }
+
+    input_file::~input_file() {
+        close();
+    }
+
+    void input_file::close() {
+        if (handle == invalid_handle) {
+            return;
+        }
+#ifdef _WIN32
+        CloseHandle(to_handle(handle));
+#else
+        ::close(to_fd(handle));
+#endif
+        handle = invalid_handle;
+    }
+
+    std::size_t input_file::read_at(std::uint64_t offset, void* buffer, std::size_t length) const {
+        auto* out = static_cast<unsigned char*>(buffer);
+        std::size_t total = 0;
+        while (total < length) {
+#ifdef _WIN32
+            OVERLAPPED overlapped {};
+            const std::uint64_t position = offset + total;
+            overlapped.Offset = static_cast<DWORD>(position & 0xFFFFFFFFu);
+            overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+            const auto chunk = static_cast<DWORD>(std::min<std::size_t>(length - total, 1u << 30));
+            DWORD bytes_read = 0;
+            if (!ReadFile(to_handle(handle), out + total, chunk, &bytes_read, &overlapped)) {
+                if (GetLastError() == ERROR_HANDLE_EOF) {
+                    break;
+                }
+                throw last_error("Failed to read file");
+            }
+#else
+            const ssize_t bytes_read = ::pread(to_fd(handle), out + total, length - total,
+                                               static_cast<off_t>(offset + total));
+            if (bytes_read < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw last_error("Failed to read file");
+            }
+#endif
+            if (bytes_read == 0) {
+                break;
+            }
+            total += static_cast<std::size_t>(bytes_read);
+        }
+        return total;
+    }
+
+    // output_file
+
+    output_file::output_file(const std::string& target_path, commit_batch* batch)
+        : target_path(target_path), handle(invalid_handle), batch(batch) {
+        for (int attempt = 0; attempt < 16 && handle == invalid_handle; attempt++) {
+            const std::filesystem::path candidate = temp_candidate(target_path);
+#ifdef _WIN32
+            HANDLE file = CreateFileW(candidate.wstring().c_str(), GENERIC_WRITE, 0, nullptr,
+                                      CREATE_NEW, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE) {
+                if (GetLastError() == ERROR_FILE_EXISTS) {
+                    continue;
+                }
+                throw last_error("Failed to create temporary file: " + candidate.string());
+            }
+            handle = reinterpret_cast<std::intptr_t>(file);
+#else
+            const int fd = ::open(candidate.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, 0666);
+            if (fd < 0) {
+                if (errno == EEXIST) {
+                    continue;
+                }
+                throw last_error("Failed to create temporary file: " + candidate.string());
+            }
+            handle = fd;
+
+            // Keep the permissions of a file that is being replaced
+            struct stat st {};
+            if (::stat(target_path.c_str(), &st) == 0) {
+                ::fchmod(fd, st.st_mode & 07777);
+            }
+#endif
+            temp_path = candidate.string();
+        }
+
+        if (handle == invalid_handle) {
+            throw std::runtime_error("Failed to create a unique temporary file for: " + target_path);
+        }
+    }
+
+    output_file::~output_file() {
+        close_handle();
+        if (!committed && !temp_path.empty()) {
+            std::error_code ec;
+            std::filesystem::remove(temp_path, ec);
+        }
+    }
+
+    void output_file::close_handle() {
+        if (handle == invalid_handle) {
+            return;
+        }
+#ifdef _WIN32
+        CloseHandle(to_handle(handle));
+#else
+        ::close(to_fd(handle));
+#endif
+        handle = invalid_handle;
+    }
+
+    void output_file::write(const void* data, std::size_t length) {
+        const auto* in = static_cast<const unsigned char*>(data);
+        while (length > 0) {
+#ifdef _WIN32
+            const auto chunk = static_cast<DWORD>(std::min<std::size_t>(length, 1u << 30));
+            DWORD written = 0;
+            if (!WriteFile(to_handle(handle), in, chunk, &written, nullptr)) {
+                throw last_error("Failed to write file: " + temp_path);
+            }
+#else
+            const ssize_t written = ::write(to_fd(handle), in, length);
+            if (written < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                throw last_error("Failed to write file: " + temp_path);
+            }
+#endif
+            in += written;
+            length -= static_cast<std::size_t>(written);
+        }
+    }
+
+    void output_file::copy_from(const byte_source& source, std::uint64_t offset, std::uint64_t length) {
+#ifdef __linux__
+        // File to file copies stay in the kernel, and may share extents on filesystems with reflinks
+        if (const auto* file = dynamic_cast<const input_file*>(&source)) {
+            const int in_fd = to_fd(file->native_handle());
+            const int out_fd = to_fd(handle);
+            auto in_offset = static_cast<off_t>(offset);
+
+            bool use_copy_file_range = true;
+            while (length > 0) {
+                const auto chunk = static_cast<std::size_t>(std::min<std::uint64_t>(length, 1u << 30));
+                ssize_t copied;
+                if (use_copy_file_range) {
+                    copied = ::copy_file_range(in_fd, &in_offset, out_fd, nullptr, chunk, 0);
+                    if (copied < 0 && (errno == EXDEV || errno == ENOSYS || errno == EINVAL || errno == EOPNOTSUPP)) {
+                        use_copy_file_range = false;
+                        continue;
+                    }
+                } else {
+                    copied = ::sendfile(out_fd, in_fd, &in_offset, chunk);
+                    if (copied < 0 && (errno == ENOSYS || errno == EINVAL)) {
+                        break;
+                    }
+                }
+
+                if (copied < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    throw last_error("Failed to copy into file: " + temp_path);
+                }
+                if (copied == 0) {
+                    throw std::runtime_error("Unexpected end of data at offset " + std::to_string(in_offset));
+                }
+                length -= static_cast<std::uint64_t>(copied);
+            }
+
+            offset = static_cast<std::uint64_t>(in_offset);
+            if (length == 0) {
+                return;
+            }
+        }
+#endif
+        byte_sink::copy_from(source, offset, length);
+    }
+
+    void output_file::commit() {
+        if (batch != nullptr) {
+            // The batch flushes all of its files in one pass
+            close_handle();
+            batch->add(temp_path, target_path);
+            committed = true;
+            return;
+        }
+
+#ifdef _WIN32
+        if (!FlushFileBuffers(to_handle(handle))) {
+            throw last_error("Failed to flush file: " + temp_path);
+        }
+        close_handle();
+
+        if (!MoveFileExW(std::filesystem::path(temp_path).wstring().c_str(),
+                         std::filesystem::path(target_path).wstring().c_str(),
+                         MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+            throw last_error("Failed to replace file: " + target_path);
+        }
+#else
+        if (::fsync(to_fd(handle)) != 0) {
+            throw last_error("Failed to flush file: " + temp_path);
+        }
+        close_handle();
+
+        if (::rename(temp_path.c_str(), target_path.c_str()) != 0) {
+            throw last_error("Failed to replace file: " + target_path);
+        }
+
+        // Persist the rename itself
+        sync_directory(std::filesystem::path(target_path).parent_path());
+#endif
+        committed = true;
+    }
+
+    // commit_batch
+
+    commit_batch::~commit_batch() {
+        for (const auto& entry : pending) {
+            std::error_code ec;
+            std::filesystem::remove(entry.first, ec);
+        }
+    }
+
+    void commit_batch::add(std::string temp_path, std::string target_path) {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.emplace_back(std::move(temp_path), std::move(target_path));
+    }
+
+    std::vector<std::pair<std::string, std::string>> commit_batch::flush() {
+        std::vector<std::pair<std::string, std::string>> entries;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            entries.swap(pending);
+        }
+
+        std::vector<std::pair<std::string, std::string>> failures;
+        std::vector<std::filesystem::path> directories;
+        for (const auto& entry : entries) {
+            const auto directory = std::filesystem::path(entry.second).parent_path();
+            if (std::find(directories.begin(), directories.end(), directory) == directories.end()) {
+                directories.push_back(directory);
+            }
+        }
+
+        for (std::size_t i = 0; i < entries.size(); i++) {
+            const auto& [temp_path, target_path] = entries[i];
+            try {
+                // Flush only the files of the batch, a filesystem-wide sync would write back unrelated data too
+#ifdef _WIN32
+                HANDLE file = CreateFileW(std::filesystem::path(temp_path).wstring().c_str(), GENERIC_WRITE, 0,
+                                          nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+                if (file == INVALID_HANDLE_VALUE) {
+                    throw last_error("Failed to open file: " + temp_path);
+                }
+                const bool ok = FlushFileBuffers(file) != 0;
+                auto error = last_error("Failed to flush file: " + temp_path);
+                CloseHandle(file);
+                if (!ok) {
+                    throw error;
+                }
+#else
+                const int fd = ::open(temp_path.c_str(), O_WRONLY | O_CLOEXEC);
+                if (fd < 0) {
+                    throw last_error("Failed to open file: " + temp_path);
+                }
+                const bool ok = ::fsync(fd) == 0;
+                auto error = last_error("Failed to flush file: " + temp_path);
+                ::close(fd);
+                if (!ok) {
+                    throw error;
+                }
+#endif
+
+#ifdef _WIN32
+                if (!MoveFileExW(std::filesystem::path(temp_path).wstring().c_str(),
+                                 std::filesystem::path(target_path).wstring().c_str(),
+                                 MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+                    throw last_error("Failed to replace file: " + target_path);
+                }
+#else
+                if (::rename(temp_path.c_str(), target_path.c_str()) != 0) {
+                    throw last_error("Failed to replace file: " + target_path);
+                }
+#endif
+            } catch (const std::exception& e) {
+                std::error_code ec;
+                std::filesystem::remove(temp_path, ec);
+                failures.emplace_back(target_path, e.what());
+            }
+        }
+
+        // Persist all renames with one sync per directory
+        for (const auto& directory : directories) {
+            sync_directory(directory);
+        }
+
+        return failures;
+    }
+
+    // mapped_file
+
+    mapped_file::mapped_file(const std::string& path) {
+#ifdef _WIN32
+        HANDLE file = CreateFileW(std::filesystem::path(path).wstring().c_str(), GENERIC_READ,
+                                  FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw last_error("Failed to open file: " + path);
+        }
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size)) {
+            auto error = last_error("Failed to get file size: " + path);
+            CloseHandle(file);
+            throw error;
+        }
+        length = static_cast<std::uint64_t>(size.QuadPart);
+
+        if (length > 0) {
+            // The view keeps the mapping alive, both handles can be closed right away
+            HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping == nullptr) {
+                auto error = last_error("Failed to map file: " + path);
+                CloseHandle(file);
+                throw error;
+            }
+            view = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            auto error = last_error("Failed to map file: " + path);
+            CloseHandle(mapping);
+            if (view == nullptr) {
+                CloseHandle(file);
+                throw error;
+            }
+        }
+        CloseHandle(file);
+#else
+        const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            throw last_error("Failed to open file: " + path);
+        }
+
+        struct stat st {};
+        if (::fstat(fd, &st) != 0) {
+            auto error = last_error("Failed to get file size: " + path);
+            ::close(fd);
+            throw error;
+        }
+        length = static_cast<std::uint64_t>(st.st_size);
+
+        if (length > 0) {
+            void* address = ::mmap(nullptr, static_cast<std::size_t>(length), PROT_READ, MAP_SHARED, fd, 0);
+            if (address == MAP_FAILED) {
+                auto error = last_error("Failed to map file: " + path);
+                ::close(fd);
+                throw error;
+            }
+            view = static_cast<const unsigned char*>(address);
+        }
+        // The mapping stays valid after the descriptor is closed
+        ::close(fd);
+#endif
+    }
+
+    mapped_file::~mapped_file() {
+        if (view == nullptr) {
+            return;
+        }
+#ifdef _WIN32
+        UnmapViewOfFile(view);
+#else
+        ::munmap(const_cast<unsigned char*>(view), static_cast<std::size_t>(length));
+#endif
+    }
+
+    std::size_t mapped_file::read_at(std::uint64_t offset, void* buffer, std::size_t count) const {
+        if (offset >= length) {
+            return 0;
+        }
+        const auto to_copy = static_cast<std::size_t>(std::min<std::uint64_t>(count, length - offset));
+        std::memcpy(buffer, view + offset, to_copy);
+        return to_copy;
+    }
+
+    // patches
+
+    void write_patched(const byte_source& source, byte_sink& sink, std::vector<byte_patch> patches) {
+        std::sort(patches.begin(), patches.end(), [](const byte_patch& a, const byte_patch& b) {
+            return a.offset < b.offset;
+        });
+
+        std::uint64_t position = 0;
+        for (const auto& patch : patches) {
+            if (patch.offset < position || patch.offset + patch.data.size() > source.size()) {
+                throw std::runtime_error("Invalid patch at offset " + std::to_string(patch.offset));
+            }
+            sink.copy_from(source, position, patch.offset - position);
+            sink.write(patch.data.data(), patch.data.size());
+            position = patch.offset + patch.data.size();
+        }
+        sink.copy_from(source, position, source.size() - position);
+    }
+
+    namespace {
+
+        /**
+         * @brief Open an existing file for positioned writes
+         */
+        std::intptr_t open_for_patching(const std::string& path) {
+#ifdef _WIN32
+            HANDLE file = CreateFileW(std::filesystem::path(path).wstring().c_str(), GENERIC_WRITE,
+                                      FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE) {
+                throw last_error("Failed to open file: " + path);
+            }
+            return reinterpret_cast<std::intptr_t>(file);
+#else
+            const int fd = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);
+            if (fd < 0) {
+                throw last_error("Failed to open file: " + path);
+            }
+            return fd;
+#endif
+        }
+
+        void close_patched(std::intptr_t handle) {
+#ifdef _WIN32
+            CloseHandle(to_handle(handle));
+#else
+            ::close(to_fd(handle));
+#endif
+        }
+
+        /**
+         * @brief Write a whole buffer at an absolute offset, the handle is closed on failure
+         */
+        void write_all_at(std::intptr_t handle, const std::string& path, std::uint64_t offset,
+                          const unsigned char* data, std::size_t size) {
+            std::size_t written_total = 0;
+            while (written_total < size) {
+                const std::uint64_t position = offset + written_total;
+#ifdef _WIN32
+                OVERLAPPED overlapped {};
+                overlapped.Offset = static_cast<DWORD>(position & 0xFFFFFFFFu);
+                overlapped.OffsetHigh = static_cast<DWORD>(position >> 32);
+                const auto chunk = static_cast<DWORD>(std::min<std::size_t>(size - written_total, 1u << 30));
+                DWORD written = 0;
+                if (!WriteFile(to_handle(handle), data + written_total, chunk, &written, &overlapped)) {
+                    auto error = last_error("Failed to write file: " + path);
+                    close_patched(handle);
+                    throw error;
+                }
+#else
+                const ssize_t written = ::pwrite(to_fd(handle), data + written_total,
+                                                 size - written_total, static_cast<off_t>(position));
+                if (written < 0) {
+                    if (errno == EINTR) {
+                        continue;
+                    }
+                    auto error = last_error("Failed to write file: " + path);
+                    close_patched(handle);
+                    throw error;
+                }
+#endif
+                written_total += static_cast<std::size_t>(written);
+            }
+        }
+
+        /**
+         * @brief Flush written data to disk and close the handle
+         */
+        void flush_patched(std::intptr_t handle, const std::string& path) {
+#ifdef _WIN32
+            const bool flushed = FlushFileBuffers(to_handle(handle)) != 0;
+#else
+            const bool flushed = ::fdatasync(to_fd(handle)) == 0;
+#endif
+            auto error = last_error("Failed to flush file: " + path);
+            close_patched(handle);
+            if (!flushed) {
+                throw error;
+            }
+        }
+
+    }
+
+    void patch_file(const std::string& path, const std::vector<byte_patch>& patches) {
+        const std::intptr_t handle = open_for_patching(path);
+
+        for (const auto& patch : patches) {
+            write_all_at(handle, path, patch.offset, patch.data.data(), patch.data.size());
+        }
+
+        flush_patched(handle, path);
+    }
+
+    void replace_tail(const std::string& path, std::uint64_t offset, const std::vector<unsigned char>& tail) {
+        const std::intptr_t handle = open_for_patching(path);
+
+        write_all_at(handle, path, offset, tail.data(), tail.size());
+
+        const std::uint64_t end = offset + tail.size();
+#ifdef _WIN32
+        LARGE_INTEGER position;
+        position.QuadPart = static_cast<LONGLONG>(end);
+        const bool truncated = SetFilePointerEx(to_handle(handle), position, nullptr, FILE_BEGIN) &&
+                               SetEndOfFile(to_handle(handle));
+#else
+        int status;
+        do {
+            status = ::ftruncate(to_fd(handle), static_cast<off_t>(end));
+        } while (status != 0 && errno == EINTR);
+        const bool truncated = status == 0;
+#endif
+        if (!truncated) {
+            auto error = last_error("Failed to truncate file: " + path);
+            close_patched(handle);
+            throw error;
+        }
+
+        flush_patched(handle, path);
+    }
+
+    // memory_source
+
+    std::size_t memory_source::read_at(std::uint64_t offset, void* buffer, std::size_t count) const {
+        if (offset >= length) {
+            return 0;
+        }
+        const auto available = static_cast<std::size_t>(length - offset);
+        const std::size_t to_copy = std::min(count, available);
+        std::copy(data + offset, data + offset + to_copy, static_cast<unsigned char*>(buffer));
+        return to_copy;
+    }
+
+    // memory_sink
+
+    void memory_sink::write(const void* data, std::size_t length) {
+        const auto* in = static_cast<const unsigned char*>(data);
+        buffer.insert(buffer.end(), in, in + length);
+    }
+
+    void memory_sink::copy_from(const byte_source& source, std::uint64_t offset, std::uint64_t length) {
+        if (source.get_data() != nullptr) {
+            byte_sink::copy_from(source, offset, length);
+            return;
+        }
+
+        const std::size_t start = buffer.size();
+        buffer.resize(start + static_cast<std::size_t>(length));
+        source.read_exact(offset, buffer.data() + start, static_cast<std::size_t>(length));
+    }
+
+}
@@ -1,36 +1,90 @@
 #include <algorithm>
 #include <utility>
 #include <fstream>
-#include <sstream>
 #include "./base/file_properties.h"
+#include "./base/content_sniffer.h"
 
 namespace file_properties {
 
-    file_properties_class::file_properties_class(std::string  path) : file_path(std::move(path)) {
+    file_properties_class::file_properties_class(std::string  path, file_hasher::hash_algorithm algorithm,
+                                                 file_type_probe probe)
+        : file_path(std::move(path)), file_hash_algorithm(algorithm) {
         init_file_name();
         init_file_extension();
-        init_file_type_major();
-        init_file_category();
-        init_file_type_minor();
-        init_file_hash();
+        if (probe.header_loaded) {
+            // reuse the bytes and types already probed by the factory
+            file_header = std::move(probe.header);
+            file_category = probe.file_category;
+            file_type_major = probe.file_type_major;
+            file_type_minor = probe.file_type_minor;
+        } else {
+            init_file_type_major();
+            init_file_category();
+            init_file_type_minor();
+            init_file_header();
+            init_file_signature();
+        }
+        // the hash is computed on the first get_file_hash() call
     }
 
     file_properties_class::~file_properties_class() = default;
 
-    void file_properties_class::init_file_hash() {
-        const std::ifstream file(file_path, std::ios::binary);
+    const std::string& file_properties_class::get_file_hash() const {
+        if (!file_hash_ready) {
+            init_file_hash();
+            file_hash_ready = true;
+        }
+        return file_hash;
+    }
+
+    file_type_probe file_properties_class::probe_file_type(const std::string& path) {
+        // construction reads the header once and never hashes the file
+        file_properties_class props(path);
+        return {props.file_category, props.file_type_major, props.file_type_minor, std::move(props.file_header), true};
+    }
+
+    file_type_probe file_properties_class::probe_buffer_type(const unsigned char* data, std::size_t size,
+                                                             const std::string& name) {
+        // a loaded header keeps the constructor away from the disk, the types are derived here instead
+        file_type_probe probe;
+        probe.header.assign(data, data + std::min(size, content_sniffer::probe_size));
+        probe.header_loaded = true;
+
+        file_properties_class props(name, file_hasher::hash_algorithm::FAST_128, std::move(probe));
+        props.init_file_type_major();
+        props.init_file_category();
+        props.init_file_type_minor();
+        props.init_file_signature();
+        return {props.file_category, props.file_type_major, props.file_type_minor, std::move(props.file_header), true};
+    }
+
+    void file_properties_class::init_file_header() {
+        std::ifstream file(file_path, std::ios::binary);
         if (!file) {
-            file_hash = "error"; // default hash value
             return;
         }
 
-        std::ostringstream oss;
-        oss << file.rdbuf(); // read the file content into a string stream
-        const std::string file_content = oss.str();
+        file_header.resize(content_sniffer::probe_size);
+        file.read(reinterpret_cast<char*>(file_header.data()), static_cast<std::streamsize>(file_header.size()));
+        file_header.resize(static_cast<size_t>(std::max<std::streamsize>(file.gcount(), 0)));
+    }
+
+    void file_properties_class::init_file_signature() {
+        // content wins over the extension, so misnamed files reach the right processor
+        file_type_probe probe;
+        probe.file_category = file_category;
+        probe.file_type_major = file_type_major;
+        probe.file_type_minor = file_type_minor;
+        if (content_sniffer::sniff(file_header.data(), file_header.size(), probe)) {
+            file_category = probe.file_category;
+            file_type_major = probe.file_type_major;
+            file_type_minor = probe.file_type_minor;
+        }
+    }
 
-        // use std::hash to generate a hash value
-        constexpr std::hash<std::string> hasher;
-        file_hash = std::to_string(hasher(file_content));
+    void file_properties_class::init_file_hash() const {
+        // streams the file through a fixed buffer, returns "error" if it cannot be read
+        file_hash = file_hasher::hash_file(file_path, file_hash_algorithm);
     }
 
     void file_properties_class::init_file_name()  {
@@ -62,7 +116,7 @@ namespace file_properties {
                    file_extension == "flac") {
             file_category = category::AUDIO;
         } else if (file_extension == "mp4" || file_extension == "avi" || file_extension == "mkv" ||
-                   file_extension == "mov") {
+                   file_extension == "mov" || file_extension == "m4v") {
             file_category = category::VIDEO;
         } else if (file_extension == "zip" || file_extension == "rar" || file_extension == "7z" ||
                    file_extension == "tar" || file_extension == "gz") {
@@ -87,7 +141,7 @@ namespace file_properties {
             file_type_major = type_major::PNG;
         } else if (file_extension == "mp3") {
             file_type_major = type_major::MP3;
-        } else if (file_extension == "mp4") {
+        } else if (file_extension == "mp4" || file_extension == "mov" || file_extension == "m4v") {
             file_type_major = type_major::MP4;
         } else {
             file_type_major = type_major::UNKNOWN;
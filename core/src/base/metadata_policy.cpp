@@ -0,0 +1,289 @@
+/**
+ * @file metadata_policy.cpp
+ * @brief Implementation of the metadata policy parser and compiler
+ */
+#include <algorithm>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include "./base/metadata_policy.h"
+
+namespace metadata_policy {
+
+    namespace {
+
+        // Subset construction is exponential in the worst case, refuse pathological policies
+        constexpr std::size_t max_states = 1 << 16;
+
+        // NFA states shared by all rules: at a key or component start, or inside a component
+        constexpr std::uint32_t at_start = 0;
+        constexpr std::uint32_t in_component = 1;
+
+        std::string trim(const std::string& text) {
+            const auto first = text.find_first_not_of(" \t\r");
+            if (first == std::string::npos) {
+                return {};
+            }
+            const auto last = text.find_last_not_of(" \t\r");
+            return text.substr(first, last - first + 1);
+        }
+
+        /**
+         * @brief Split a rule body into patterns separated by whitespace or commas
+         */
+        std::vector<std::string> split_patterns(const std::string& text) {
+            std::vector<std::string> patterns;
+            std::string current;
+            for (const char c : text) {
+                if (c == ' ' || c == '\t' || c == ',') {
+                    if (!current.empty()) {
+                        patterns.push_back(std::move(current));
+                        current.clear();
+                    }
+                } else {
+                    current += c;
+                }
+            }
+            if (!current.empty()) {
+                patterns.push_back(std::move(current));
+            }
+            return patterns;
+        }
+
+        bool parse_action(const std::string& word, action& result) {
+            if (word == "keep") {
+                result = action::KEEP;
+                return true;
+            }
+            if (word == "drop") {
+                result = action::DROP;
+                return true;
+            }
+            return false;
+        }
+
+        /**
+         * @brief Thompson-style automaton over all patterns
+         *
+         * Pattern states are numbered after the two shared states, state
+         * starts[r] + i means the first i characters of rule r have matched.
+         */
+        class pattern_nfa {
+        public:
+            explicit pattern_nfa(const std::vector<rule>& rules) : rules(rules) {
+                std::uint32_t next = 2;
+                for (const auto& r : rules) {
+                    starts.push_back(next);
+                    next += static_cast<std::uint32_t>(r.pattern.size()) + 1;
+                }
+                owner.resize(next, 0);
+                for (std::size_t r = 0; r < rules.size(); r++) {
+                    for (std::size_t i = 0; i <= rules[r].pattern.size(); i++) {
+                        owner[starts[r] + i] = static_cast<std::uint32_t>(r);
+                    }
+                }
+            }
+
+            [[nodiscard]] std::vector<std::uint32_t> closure(std::vector<std::uint32_t> states) const {
+                std::vector<bool> seen(owner.size(), false);
+                std::vector<std::uint32_t> pending = std::move(states);
+                std::vector<std::uint32_t> result;
+                while (!pending.empty()) {
+                    const std::uint32_t state = pending.back();
+                    pending.pop_back();
+                    if (seen[state]) {
+                        continue;
+                    }
+                    seen[state] = true;
+                    result.push_back(state);
+
+                    if (state == at_start) {
+                        pending.insert(pending.end(), starts.begin(), starts.end());
+                    } else if (state != in_component) {
+                        const auto& pattern = rules[owner[state]].pattern;
+                        const std::size_t pos = state - starts[owner[state]];
+                        // '*' may match nothing
+                        if (pos < pattern.size() && pattern[pos] == '*') {
+                            pending.push_back(state + 1);
+                        }
+                    }
+                }
+                std::sort(result.begin(), result.end());
+                return result;
+            }
+
+            [[nodiscard]] std::vector<std::uint32_t> step(const std::vector<std::uint32_t>& states, char c) const {
+                std::vector<std::uint32_t> next;
+                for (const std::uint32_t state : states) {
+                    if (state == at_start || state == in_component) {
+                        next.push_back(c == '.' ? at_start : in_component);
+                        continue;
+                    }
+                    const auto& pattern = rules[owner[state]].pattern;
+                    const std::size_t pos = state - starts[owner[state]];
+                    if (pos == pattern.size()) {
+                        continue;
+                    }
+                    if (pattern[pos] == '*') {
+                        next.push_back(state);
+                    } else if (pattern[pos] == '?' || pattern[pos] == c) {
+                        next.push_back(state + 1);
+                    }
+                }
+                return closure(std::move(next));
+            }
+
+            /**
+             * @brief Highest rule index whose pattern is fully matched, -1 if none
+             */
+            [[nodiscard]] int accepted_rule(const std::vector<std::uint32_t>& states) const {
+                int result = -1;
+                for (const std::uint32_t state : states) {
+                    if (state == at_start || state == in_component) {
+                        continue;
+                    }
+                    const std::uint32_t r = owner[state];
+                    if (state - starts[r] == rules[r].pattern.size()) {
+                        result = std::max(result, static_cast<int>(r));
+                    }
+                }
+                return result;
+            }
+
+        private:
+            const std::vector<rule>& rules;
+            std::vector<std::uint32_t> starts;
+            std::vector<std::uint32_t> owner;
+        };
+
+    }
+
+    policy_class::policy_class(std::vector<rule> rules, action default_action)
+        : rules(std::move(rules)), default_action(default_action) {
+        compile();
+    }
+
+    policy_class policy_class::parse(const std::string& text) {
+        std::vector<rule> rules;
+        action default_action = action::KEEP;
+
+        std::istringstream stream(text);
+        std::string line;
+        std::size_t line_number = 0;
+        while (std::getline(stream, line)) {
+            line_number++;
+            line = trim(line.substr(0, line.find('#')));
+            if (line.empty()) {
+                continue;
+            }
+
+            const auto split = line.find_first_of(" \t");
+            const std::string keyword = line.substr(0, split);
+            const std::string body = split == std::string::npos ? std::string() : trim(line.substr(split));
+            const auto patterns = split_patterns(body);
+
+            action rule_action;
+            if (keyword == "default") {
+                if (patterns.size() != 1 || !parse_action(patterns[0], default_action)) {
+                    throw std::runtime_error("Policy line " + std::to_string(line_number) +
+                                             ": expected 'default keep' or 'default drop'");
+                }
+            } else if (parse_action(keyword, rule_action)) {
+                if (patterns.empty()) {
+                    throw std::runtime_error("Policy line " + std::to_string(line_number) + ": missing key pattern");
+                }
+                for (const auto& pattern : patterns) {
+                    rules.push_back({rule_action, pattern});
+                }
+            } else {
+                throw std::runtime_error("Policy line " + std::to_string(line_number) +
+                                         ": unknown directive '" + keyword + "'");
+            }
+        }
+
+        return policy_class(std::move(rules), default_action);
+    }
+
+    policy_class policy_class::load(const std::string& path) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) {
+            throw std::runtime_error("Cannot open policy file: " + path);
+        }
+        std::ostringstream content;
+        content << file.rdbuf();
+        return parse(content.str());
+    }
+
+    void policy_class::compile() {
+        // Every literal pattern character and the component separator get their own class
+        std::fill(std::begin(char_class), std::end(char_class), 0);
+        std::vector<char> representatives {'\0'};
+        const auto add_class = [&](char c) {
+            auto& slot = char_class[static_cast<unsigned char>(c)];
+            if (slot == 0) {
+                if (representatives.size() > 255) {
+                    throw std::runtime_error("Policy uses too many distinct characters");
+                }
+                slot = static_cast<unsigned char>(representatives.size());
+                representatives.push_back(c);
+            }
+        };
+        add_class('.');
+        for (const auto& r : rules) {
+            for (const char c : r.pattern) {
+                if (c != '*' && c != '?') {
+                    add_class(c);
+                }
+            }
+        }
+        // Class 0 stands for every other character, pick one of them to drive the construction
+        for (int c = 1; c < 256; c++) {
+            if (char_class[c] == 0) {
+                representatives[0] = static_cast<char>(c);
+                break;
+            }
+        }
+        class_count = representatives.size();
+
+        // Subset construction, DFA state 0 is the start
+        const pattern_nfa nfa(rules);
+        std::map<std::vector<std::uint32_t>, std::uint32_t> ids;
+        std::vector<std::vector<std::uint32_t>> sets;
+        const auto intern = [&](std::vector<std::uint32_t> states) {
+            const auto found = ids.find(states);
+            if (found != ids.end()) {
+                return found->second;
+            }
+            if (sets.size() >= max_states) {
+                throw std::runtime_error("Policy is too complex to compile");
+            }
+            const auto id = static_cast<std::uint32_t>(sets.size());
+            ids.emplace(states, id);
+            sets.push_back(std::move(states));
+            return id;
+        };
+
+        intern(nfa.closure({at_start}));
+        transitions.clear();
+        accepting_rule.clear();
+        for (std::size_t id = 0; id < sets.size(); id++) {
+            // sets grows inside intern, so the current set is copied before stepping
+            const std::vector<std::uint32_t> current = sets[id];
+            accepting_rule.push_back(nfa.accepted_rule(current));
+            for (std::size_t c = 0; c < class_count; c++) {
+                transitions.push_back(intern(nfa.step(current, representatives[c])));
+            }
+        }
+    }
+
+    action policy_class::evaluate(const std::string& key) const {
+        std::uint32_t state = 0;
+        for (const char c : key) {
+            state = transitions[state * class_count + char_class[static_cast<unsigned char>(c)]];
+        }
+        const int matched = accepting_rule[state];
+        return matched < 0 ? default_action : rules[matched].rule_action;
+    }
+
+}
@@ -0,0 +1,178 @@
+/**
+ * @file metadata_table.cpp
+ * @brief Implementation of the key table and metadata map
+ */
+#include <algorithm>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include "./base/metadata_table.h"
+
+namespace metadata_table {
+
+    namespace {
+
+        /**
+         * @brief Process-wide table of interned keys
+         *
+         * Names live in a deque so references to them stay valid while the
+         * table grows, the index maps views into those names to their ids.
+         */
+        class key_table {
+        public:
+            bool intern(std::string_view key, key_id& id) {
+                if (find(key, id)) {
+                    return true;
+                }
+
+                std::unique_lock<std::shared_mutex> lock(mutex);
+                const auto found = ids.find(key);
+                if (found != ids.end()) {
+                    id = found->second;
+                    return true;
+                }
+                if (names.size() >= max_interned_keys) {
+                    return false;
+                }
+                id = static_cast<key_id>(names.size());
+                names.emplace_back(key);
+                ids.emplace(names.back(), id);
+                return true;
+            }
+
+            bool find(std::string_view key, key_id& id) const {
+                std::shared_lock<std::shared_mutex> lock(mutex);
+                const auto found = ids.find(key);
+                if (found == ids.end()) {
+                    return false;
+                }
+                id = found->second;
+                return true;
+            }
+
+            const std::string& name(key_id id) const {
+                std::shared_lock<std::shared_mutex> lock(mutex);
+                return names.at(id);
+            }
+
+        private:
+            mutable std::shared_mutex mutex;
+            std::deque<std::string> names;
+            std::unordered_map<std::string_view, key_id> ids;
+        };
+
+        key_table& table() {
+            static key_table instance;
+            return instance;
+        }
+
+    }
+
+    bool intern_key(std::string_view key, key_id& id) {
+        return table().intern(key, id);
+    }
+
+    bool find_key(std::string_view key, key_id& id) {
+        return table().find(key, id);
+    }
+
+    const std::string& key_name(key_id id) {
+        return table().name(id);
+    }
+
+    void metadata_map::set(std::string_view key, std::string_view value) {
+        key_id id;
+        if (!intern_key(key, id)) {
+            const auto found = local_ids.find(std::string(key));
+            if (found != local_ids.end()) {
+                id = found->second;
+            } else {
+                id = local_key_flag | static_cast<key_id>(local_keys.size());
+                local_keys.emplace_back(key);
+                local_ids.emplace(local_keys.back(), id);
+            }
+        }
+        set(id, value);
+    }
+
+    void metadata_map::set(std::string_view prefix, std::string_view key, std::string_view value) {
+        // Reused per thread, so joining only allocates until the longest key has been seen
+        thread_local std::string joined;
+        joined.assign(prefix);
+        joined.append(key);
+        set(std::string_view(joined), value);
+    }
+
+    void metadata_map::set(key_id key, std::string_view value) {
+        if (arena.size() + value.size() > std::numeric_limits<std::uint32_t>::max()) {
+            throw std::length_error("Metadata values exceed 4 GiB");
+        }
+        const auto offset = static_cast<std::uint32_t>(arena.size());
+        const auto length = static_cast<std::uint32_t>(value.size());
+        arena.append(value);
+
+        // A replaced value stays in the arena, keys are rarely set twice
+        auto pos = std::lower_bound(entries.begin(), entries.end(), key,
+                                    [](const entry& e, key_id k) { return e.key < k; });
+        if (pos != entries.end() && pos->key == key) {
+            pos->offset = offset;
+            pos->length = length;
+        } else {
+            entries.insert(pos, {key, offset, length});
+        }
+    }
+
+    metadata_map::const_iterator metadata_map::find(key_id key) const {
+        const auto pos = std::lower_bound(entries.begin(), entries.end(), key,
+                                          [](const entry& e, key_id k) { return e.key < k; });
+        if (pos == entries.end() || pos->key != key) {
+            return end();
+        }
+        return {this, static_cast<std::size_t>(pos - entries.begin())};
+    }
+
+    metadata_map::const_iterator metadata_map::find(std::string_view key) const {
+        key_id id;
+        if (find_key(key, id)) {
+            return find(id);
+        }
+        const auto found = local_ids.find(std::string(key));
+        return found == local_ids.end() ? end() : find(found->second);
+    }
+
+    std::string_view metadata_map::value(std::string_view key) const {
+        const auto it = find(key);
+        return it == end() ? std::string_view() : it->second;
+    }
+
+    void metadata_map::clear() {
+        entries.clear();
+        arena.clear();
+        local_keys.clear();
+        local_ids.clear();
+    }
+
+    void metadata_map::shrink_to_fit() {
+        entries.shrink_to_fit();
+        arena.shrink_to_fit();
+        local_keys.shrink_to_fit();
+    }
+
+    std::unordered_map<std::string, std::string> metadata_map::to_map() const {
+        std::unordered_map<std::string, std::string> result;
+        result.reserve(entries.size());
+        for (const auto& [key, value] : *this) {
+            result.emplace(key, std::string(value));
+        }
+        return result;
+    }
+
+    metadata_map::value_type metadata_map::item(std::size_t index) const {
+        const entry& e = entries[index];
+        const std::string& name = (e.key & local_key_flag) != 0 ? local_keys[e.key & ~local_key_flag] : key_name(e.key);
+        return {name, std::string_view(arena.data() + e.offset, e.length)};
+    }
+
+}
@@ -21,32 +21,54 @@ namespace processor_factory {
         factories[{major, minor}] = std::move(creator);
     }
 
-    std::unique_ptr<file_handler::file_handler_class> processor_factory_class::create_processor(
-        const std::string& file_path,
-        file_handler::operation_type op_type,
-        const file_handler::operation_options& options)
+    const processor_factory_class::creator_func* processor_factory_class::find_creator(
+        const file_properties::file_type_probe& probe)
     {
-        // Create a temporary file_properties object to determine the file type
-        file_properties::file_properties_class file_props(file_path);
-
-        // Get the file types
-        auto major = file_props.get_file_type_major();
-        auto minor = file_props.get_file_type_minor();
-
         // Look for an exact match first
-        auto it = factories.find({major, minor});
+        auto it = factories.find({probe.file_type_major, probe.file_type_minor});
         if (it != factories.end()) {
-            return it->second(file_path, op_type, options);
+            return &it->second;
         }
 
         // If no exact match, try with UNKNOWN minor type
-        it = factories.find({major, file_properties::type_minor::UNKNOWN});
+        it = factories.find({probe.file_type_major, file_properties::type_minor::UNKNOWN});
         if (it != factories.end()) {
-            return it->second(file_path, op_type, options);
+            return &it->second;
         }
 
         // No suitable processor found
         return nullptr;
     }
 
+    std::unique_ptr<file_handler::file_handler_class> processor_factory_class::create_processor(
+        const std::string& file_path,
+        file_handler::operation_type op_type,
+        const file_handler::shared_options& options)
+    {
+        // Probe the file type from its header, this does not hash or load the file
+        auto probe = file_properties::file_properties_class::probe_file_type(file_path);
+
+        const creator_func* creator = find_creator(probe);
+        if (creator == nullptr) {
+            return nullptr;
+        }
+        return (*creator)(file_path, op_type, options, std::move(probe), {});
+    }
+
+    std::unique_ptr<file_handler::file_handler_class> processor_factory_class::create_buffer_processor(
+        const std::string& name,
+        const file_handler::buffer_binding& buffers,
+        file_handler::operation_type op_type,
+        const file_handler::shared_options& options)
+    {
+        // The name only stands in for the path, every read goes to the buffer
+        auto probe = file_properties::file_properties_class::probe_buffer_type(buffers.data, buffers.size, name);
+
+        const creator_func* creator = find_creator(probe);
+        if (creator == nullptr) {
+            return nullptr;
+        }
+        return (*creator)(name, op_type, options, std::move(probe), buffers);
+    }
+
 }
\ No newline at end of file
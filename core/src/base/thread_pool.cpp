@@ -0,0 +1,197 @@
+/**
+ * @file thread_pool.cpp
+ * @brief Implementation of the work-stealing thread pool
+ */
+#include <algorithm>
+#include <exception>
+#include "./base/thread_pool.h"
+
+namespace thread_pool {
+
+    namespace {
+        // Identifies the pool and queue owned by the current thread, if any
+        thread_local const thread_pool_class* current_pool = nullptr;
+        thread_local std::size_t current_index = 0;
+    }
+
+    thread_pool_class::thread_pool_class(std::size_t worker_count) {
+        if (worker_count == 0) {
+            worker_count = default_worker_count();
+        }
+
+        queues.reserve(worker_count);
+        for (std::size_t i = 0; i < worker_count; i++) {
+            queues.push_back(std::make_unique<work_queue>());
+        }
+
+        workers.reserve(worker_count);
+        for (std::size_t i = 0; i < worker_count; i++) {
+            workers.emplace_back(&thread_pool_class::worker_loop, this, i);
+        }
+    }
+
+    thread_pool_class::~thread_pool_class() {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            stopping = true;
+        }
+        sleep_cv.notify_all();
+
+        for (auto& worker : workers) {
+            if (worker.joinable()) {
+                worker.join();
+            }
+        }
+    }
+
+    std::size_t thread_pool_class::default_worker_count() {
+        const unsigned int hardware = std::thread::hardware_concurrency();
+        return hardware == 0 ? 1 : hardware;
+    }
+
+    void thread_pool_class::submit(task t) {
+        // Tasks spawned by a worker stay on its own queue, external ones are spread round-robin
+        const std::size_t index = current_pool == this
+            ? current_index
+            : next_queue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+        push_task(index, std::move(t));
+    }
+
+    void thread_pool_class::parallel_for(std::size_t count, const std::function<void(std::size_t)>& body) {
+        if (count == 0) {
+            return;
+        }
+        if (count == 1) {
+            body(0);
+            return;
+        }
+
+        struct batch_state {
+            std::atomic<std::size_t> remaining {0};
+            std::mutex mutex;
+            std::condition_variable done_cv;
+            std::exception_ptr error;
+        };
+
+        auto state = std::make_shared<batch_state>();
+        state->remaining = count;
+
+        // Hand out contiguous blocks so every worker starts on its own slice of the input
+        const std::size_t queue_count = queues.size();
+        const std::size_t block = (count + queue_count - 1) / queue_count;
+        for (std::size_t q = 0; q < queue_count; q++) {
+            const std::size_t begin = q * block;
+            const std::size_t end = std::min(count, begin + block);
+            for (std::size_t i = begin; i < end; i++) {
+                push_task(q, [state, &body, i]() {
+                    try {
+                        body(i);
+                    } catch (...) {
+                        std::lock_guard<std::mutex> lock(state->mutex);
+                        if (!state->error) {
+                            state->error = std::current_exception();
+                        }
+                    }
+
+                    if (state->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                        std::lock_guard<std::mutex> lock(state->mutex);
+                        state->done_cv.notify_all();
+                    }
+                });
+            }
+        }
+
+        // Help with queued work instead of blocking, then wait for in-flight tasks
+        while (state->remaining.load(std::memory_order_acquire) > 0) {
+            if (run_pending_task()) {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(state->mutex);
+            state->done_cv.wait(lock, [&state]() {
+                return state->remaining.load(std::memory_order_acquire) == 0;
+            });
+        }
+
+        if (state->error) {
+            std::rethrow_exception(state->error);
+        }
+    }
+
+    void thread_pool_class::push_task(std::size_t index, task t) {
+        {
+            std::lock_guard<std::mutex> lock(queues[index]->mutex);
+            queues[index]->tasks.push_back(std::move(t));
+            pending.fetch_add(1, std::memory_order_release);
+        }
+
+        // Taking the sleep mutex orders this wake-up after a worker's predicate check
+        { std::lock_guard<std::mutex> lock(sleep_mutex); }
+        sleep_cv.notify_one();
+    }
+
+    bool thread_pool_class::pop_task(std::size_t index, task& out) {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        auto& tasks = queues[index]->tasks;
+        if (tasks.empty()) {
+            return false;
+        }
+        out = std::move(tasks.front());
+        tasks.pop_front();
+        pending.fetch_sub(1, std::memory_order_acq_rel);
+        return true;
+    }
+
+    bool thread_pool_class::steal_task(std::size_t thief, task& out) {
+        const std::size_t queue_count = queues.size();
+        for (std::size_t offset = 1; offset <= queue_count; offset++) {
+            const std::size_t victim = (thief + offset) % queue_count;
+            std::lock_guard<std::mutex> lock(queues[victim]->mutex);
+            auto& tasks = queues[victim]->tasks;
+            if (tasks.empty()) {
+                continue;
+            }
+            out = std::move(tasks.back());
+            tasks.pop_back();
+            pending.fetch_sub(1, std::memory_order_acq_rel);
+            return true;
+        }
+        return false;
+    }
+
+    bool thread_pool_class::run_pending_task() {
+        task t;
+        const bool is_worker = current_pool == this;
+        const std::size_t index = is_worker ? current_index : 0;
+
+        if ((is_worker && pop_task(index, t)) || steal_task(index, t)) {
+            try {
+                t();
+            } catch (...) {
+                // Tasks report their own failures, never let one take down a worker
+            }
+            return true;
+        }
+        return false;
+    }
+
+    void thread_pool_class::worker_loop(std::size_t index) {
+        current_pool = this;
+        current_index = index;
+
+        while (true) {
+            if (run_pending_task()) {
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleep_mutex);
+            sleep_cv.wait(lock, [this]() {
+                return stopping || pending.load(std::memory_order_acquire) > 0;
+            });
+            if (stopping && pending.load(std::memory_order_acquire) == 0) {
+                return;
+            }
+        }
+    }
+
+}
@@ -1,17 +1,71 @@
 //need to be checked
 #include "meta_wiper_core.h"
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
 #include <filesystem>
+#include <unordered_set>
+#include "./base/thread_pool.h"
 
 namespace meta_wiper_core {
 
-    meta_wiper_core_class::meta_wiper_core_class() = default;
+    namespace {
+
+        /**
+         * @brief Check if an operation writes its result into the output directory
+         */
+        bool writes_to_directory(file_handler::operation_type op_type, const file_handler::operation_options& options) {
+            return !options.output_directory.empty() &&
+                   (op_type == file_handler::operation_type::CLEAN ||
+                    op_type == file_handler::operation_type::OVERWRITE);
+        }
+
+        /**
+         * @brief Mark files whose output name an earlier file of the batch already takes
+         *
+         * Outputs are named after the input file only, so same-named inputs from
+         * different directories would replace each other.
+         */
+        std::vector<bool> find_output_clashes(const std::vector<std::string>& file_paths) {
+            std::vector<bool> clashes(file_paths.size(), false);
+            std::unordered_set<std::string> names;
+            for (std::size_t i = 0; i < file_paths.size(); i++) {
+                std::string name = std::filesystem::path(file_paths[i]).filename().string();
+#ifdef _WIN32
+                // NTFS names are case-insensitive
+                std::transform(name.begin(), name.end(), name.begin(), ::tolower);
+#endif
+                clashes[i] = !names.insert(std::move(name)).second;
+            }
+            return clashes;
+        }
+
+        file_handler::operation_result output_clash_result(const std::string& file_path) {
+            return {false, "Another file of the batch has the same output name: " +
+                           std::filesystem::path(file_path).filename().string(), {}, {}};
+        }
+
+    }
+
+    meta_wiper_core_class::meta_wiper_core_class(std::size_t worker_count)
+        : worker_count(worker_count == 0 ? thread_pool::thread_pool_class::default_worker_count() : worker_count) {}
+
     meta_wiper_core_class::~meta_wiper_core_class() = default;
 
     file_handler::operation_result meta_wiper_core_class::process_file(
         const std::string& file_path,
         const file_handler::operation_type op_type,
         const file_handler::operation_options& options) {
+        return run_file(file_path, op_type, share_options(options), nullptr);
+    }
+
+    file_handler::operation_result meta_wiper_core_class::run_file(
+        const std::string& file_path,
+        const file_handler::operation_type op_type,
+        const file_handler::shared_options& options,
+        file_io::commit_batch* batch) {
 
         // Check if file exists
         if (!std::filesystem::exists(file_path)) {
@@ -24,28 +78,291 @@ namespace meta_wiper_core {
             return {false, "Unsupported file format", {}, {}};
         }
 
-        return handler->execute_operation();
+        handler->set_commit_batch(batch);
+        auto result = handler->execute_operation();
+        // Results of a batch are held until it ends, drop the slack of the growing arena
+        result.metadata.shrink_to_fit();
+        return result;
+    }
+
+    buffer_result meta_wiper_core_class::process_buffer(
+        const void* data,
+        std::size_t size,
+        const std::string& type_hint,
+        const file_handler::operation_type op_type,
+        const file_handler::operation_options& options) {
+
+        buffer_result output {{false, "", {}, {}}, {}};
+        if (data == nullptr || size == 0) {
+            output.result.message = "Buffer is empty";
+            return output;
+        }
+        if (op_type == file_handler::operation_type::EXPORT && options.output_directory.empty()) {
+            output.result.message = "Exporting a buffer requires an output directory";
+            return output;
+        }
+
+        // The hint stands in for a file name, a bare extension gets a placeholder stem
+        std::string name = type_hint;
+        if (name.empty() || name[0] == '.') {
+            name = "buffer" + name;
+        } else if (name.find('.') == std::string::npos) {
+            name = "buffer." + name;
+        }
+
+        file_handler::buffer_binding buffers;
+        buffers.data = static_cast<const unsigned char*>(data);
+        buffers.size = size;
+        buffers.output = &output.data;
+
+        try {
+            auto handler = file_handler::create_buffer_handler(name, buffers, op_type, share_options(options));
+            if (!handler) {
+                output.result.message = "Unsupported file format";
+                return output;
+            }
+            output.result = handler->execute_operation();
+        } catch (const std::exception& e) {
+            output.result = {false, "Exception: " + std::string(e.what()), {}, {}};
+        }
+
+        if (!output.result.success) {
+            output.data.clear();
+        }
+        return output;
     }
 
     std::vector<file_handler::operation_result> meta_wiper_core_class::process_files(
         const std::vector<std::string>& file_paths,
         file_handler::operation_type op_type,
-        const file_handler::operation_options& options) {
+        const file_handler::operation_options& batch_options) {
 
-        std::vector<file_handler::operation_result> results;
-        results.reserve(file_paths.size());
+        // Every handler of the batch shares one copy of the options, a concurrent
+        // set_policy only affects later batches
+        const auto options = share_options(batch_options);
 
-        for (const auto& path : file_paths) {
-            results.push_back(process_file(path, op_type, options));
+        // Results are written by index, so their order always matches file_paths
+        std::vector<file_handler::operation_result> results(file_paths.size());
+
+        // Copies into an output directory are flushed and renamed together once the batch is done
+        const bool to_directory = writes_to_directory(op_type, *options);
+        file_io::commit_batch batch;
+        file_io::commit_batch* output_batch = to_directory && file_paths.size() > 1 ? &batch : nullptr;
+
+        // The first file of a name wins, later ones fail before anything is written
+        const auto clashes = to_directory ? find_output_clashes(file_paths) : std::vector<bool>(file_paths.size(), false);
+
+        if (file_paths.size() == 1 || get_worker_count() == 1) {
+            for (size_t i = 0; i < file_paths.size(); i++) {
+                results[i] = clashes[i] ? output_clash_result(file_paths[i])
+                                        : run_file(file_paths[i], op_type, options, output_batch);
+            }
+        } else {
+            // Hold a reference so a concurrent set_worker_count cannot tear the pool down mid-batch
+            const auto batch_pool = get_thread_pool();
+            batch_pool->parallel_for(file_paths.size(), [&](std::size_t i) {
+                if (clashes[i]) {
+                    results[i] = output_clash_result(file_paths[i]);
+                    return;
+                }
+                try {
+                    results[i] = run_file(file_paths[i], op_type, options, output_batch);
+                } catch (const std::exception& e) {
+                    results[i] = {false, "Exception: " + std::string(e.what()), {}, {}};
+                }
+            });
+        }
+
+        if (output_batch != nullptr) {
+            for (const auto& [target_path, error] : batch.flush()) {
+                // Output names are unique within the batch, so a target belongs to one file
+                for (size_t i = 0; i < file_paths.size(); i++) {
+                    const auto output_path = options->output_directory / std::filesystem::path(file_paths[i]).filename();
+                    if (!clashes[i] && results[i].success && output_path.string() == target_path) {
+                        results[i] = {false, "Failed to write output file: " + error, {}, {}};
+                        break;
+                    }
+                }
+            }
         }
 
         return results;
     }
 
+    std::size_t meta_wiper_core_class::process_files(
+        const std::vector<std::string>& file_paths,
+        file_handler::operation_type op_type,
+        const result_callback& on_result,
+        const file_handler::operation_options& batch_options,
+        std::size_t max_pending) {
+
+        const auto options = share_options(batch_options);
+        const auto clashes = writes_to_directory(op_type, *options) ? find_output_clashes(file_paths)
+                                                                    : std::vector<bool>(file_paths.size(), false);
+        const auto run_guarded = [&](std::size_t i) -> file_handler::operation_result {
+            if (clashes[i]) {
+                return output_clash_result(file_paths[i]);
+            }
+            try {
+                return run_file(file_paths[i], op_type, options, nullptr);
+            } catch (const std::exception& e) {
+                return {false, "Exception: " + std::string(e.what()), {}, {}};
+            }
+        };
+
+        std::size_t delivered = 0;
+        if (file_paths.size() <= 1 || get_worker_count() == 1) {
+            for (std::size_t i = 0; i < file_paths.size(); i++) {
+                delivered++;
+                if (!on_result(i, run_guarded(i))) {
+                    break;
+                }
+            }
+            return delivered;
+        }
+
+        // Hold a reference so a concurrent set_worker_count cannot tear the pool down mid-batch
+        const auto batch_pool = get_thread_pool();
+        const std::size_t runner_count = std::min(batch_pool->get_worker_count(), file_paths.size());
+        if (max_pending == 0) {
+            max_pending = 2 * runner_count;
+        }
+
+        std::mutex queue_mutex;
+        std::condition_variable result_ready;
+        std::condition_variable queue_space;
+        std::deque<std::pair<std::size_t, file_handler::operation_result>> queue;
+        std::atomic<std::size_t> next_index {0};
+        std::size_t running = runner_count;
+        bool cancelled = false;
+
+        // One long-running task per worker pulls indices, so the pool never holds a task per file
+        for (std::size_t r = 0; r < runner_count; r++) {
+            batch_pool->submit([&]() {
+                for (;;) {
+                    const std::size_t i = next_index.fetch_add(1);
+                    if (i >= file_paths.size()) {
+                        break;
+                    }
+                    {
+                        std::lock_guard<std::mutex> lock(queue_mutex);
+                        if (cancelled) {
+                            break;
+                        }
+                    }
+
+                    auto result = run_guarded(i);
+
+                    std::unique_lock<std::mutex> lock(queue_mutex);
+                    queue_space.wait(lock, [&] { return cancelled || queue.size() < max_pending; });
+                    if (cancelled) {
+                        break;
+                    }
+                    queue.emplace_back(i, std::move(result));
+                    result_ready.notify_one();
+                }
+
+                std::lock_guard<std::mutex> lock(queue_mutex);
+                running--;
+                result_ready.notify_one();
+            });
+        }
+
+        std::exception_ptr callback_error;
+        std::unique_lock<std::mutex> lock(queue_mutex);
+        for (;;) {
+            result_ready.wait(lock, [&] { return !queue.empty() || running == 0; });
+            if (queue.empty()) {
+                break;
+            }
+            auto item = std::move(queue.front());
+            queue.pop_front();
+            queue_space.notify_one();
+
+            // The callback runs unlocked so the workers keep going while it works
+            lock.unlock();
+            bool keep_going = false;
+            try {
+                keep_going = on_result(item.first, std::move(item.second));
+            } catch (...) {
+                callback_error = std::current_exception();
+            }
+            delivered++;
+            lock.lock();
+
+            if (!keep_going) {
+                cancelled = true;
+                queue_space.notify_all();
+                break;
+            }
+        }
+
+        // The workers reference this frame, wait for all of them before returning
+        result_ready.wait(lock, [&] { return running == 0; });
+        lock.unlock();
+
+        if (callback_error) {
+            std::rethrow_exception(callback_error);
+        }
+        return delivered;
+    }
+
     std::vector<std::string> meta_wiper_core_class::get_supported_file_types() {
         // Return all supported extensions
         // In a more advanced implementation, this could query the processor_factory
-        return {".pdf", ".jpg", ".jpeg", ".docx"};
+        return {".pdf", ".jpg", ".jpeg", ".png", ".mp4", ".mov", ".m4v", ".mp3", ".docx", ".xlsx", ".pptx"};
+    }
+
+    void meta_wiper_core_class::set_worker_count(std::size_t count) {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        const std::size_t new_count = count == 0 ? thread_pool::thread_pool_class::default_worker_count() : count;
+        if (new_count != worker_count) {
+            worker_count = new_count;
+            pool.reset();
+        }
+    }
+
+    std::size_t meta_wiper_core_class::get_worker_count() const {
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        return worker_count;
+    }
+
+    void meta_wiper_core_class::set_policy(std::shared_ptr<const metadata_policy::policy_class> new_policy) {
+        std::lock_guard<std::mutex> lock(policy_mutex);
+        policy = std::move(new_policy);
+    }
+
+    void meta_wiper_core_class::load_policy(const std::string& policy_path) {
+        set_policy(std::make_shared<const metadata_policy::policy_class>(
+            metadata_policy::policy_class::load(policy_path)));
+    }
+
+    std::shared_ptr<const metadata_policy::policy_class> meta_wiper_core_class::get_policy() const {
+        std::lock_guard<std::mutex> lock(policy_mutex);
+        return policy;
+    }
+
+    file_handler::shared_options meta_wiper_core_class::share_options(
+        const file_handler::operation_options& options) {
+        file_handler::operation_options result = options;
+        // Explicitly selected properties and a per-call policy take precedence
+        if (result.selected_properties.empty() && !result.policy) {
+            result.policy = get_policy();
+        }
+        // Work inside one file shares the batch workers, a waiting worker runs queued tasks itself
+        if (!result.worker_pool && get_worker_count() > 1) {
+            result.worker_pool = get_thread_pool();
+        }
+        return file_handler::make_options(std::move(result));
+    }
+
+    std::shared_ptr<thread_pool::thread_pool_class> meta_wiper_core_class::get_thread_pool() {
+        // Workers are only started on the first call that can use them
+        std::lock_guard<std::mutex> lock(pool_mutex);
+        if (!pool) {
+            pool = std::make_shared<thread_pool::thread_pool_class>(worker_count);
+        }
+        return pool;
     }
 
     bool meta_wiper_core_class::type_supported(const std::string& file_extension) const {
@@ -1,17 +1,62 @@
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 #include <filesystem>
 #include <fstream>
+#include <iterator>
+#include <set>
+#include "./base/file_io.h"
 #include "./processors/jpeg_processor.h"
+#include "./processors/jpeg_segments.h"
+#include "./processors/tiff_ifd.h"
+
+namespace {
+    // The XMP toolkit is not thread-safe to initialise, do it once before batches run in parallel
+    [[maybe_unused]] const bool xmp_parser_initialized = Exiv2::XmpParser::initialize();
+}
 
 namespace jpeg_processor {
 
     jpeg_processor_class::jpeg_processor_class(const std::string& path,
                                                file_handler::operation_type type,
-                                               const file_handler::operation_options& opts)
-            : file_handler_class(path, type, opts), jpeg_loaded(false) {
+                                               file_handler::shared_options opts,
+                                               file_properties::file_type_probe probe,
+                                               file_handler::buffer_binding buffers)
+            : file_handler_class(path, type, std::move(opts), std::move(probe), buffers), jpeg_loaded(false) {
+        // Cleaning works on the marker segments directly and never needs Exiv2
+        if (type == file_handler::operation_type::CLEAN && !has_selection()) {
+            return;
+        }
+
+        try {
+            // Exiv2 reads from a shared read-only mapping instead of its own file buffers
+            input_map = map_input();
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to map JPEG file: " << e.what() << std::endl;
+            return;
+        }
+        if (input_map->size() == 0) {
+            return;
+        }
+
+        // Reading and finding the selected keys only need the segments in front of the scan data
+        if ((type == file_handler::operation_type::READ || type == file_handler::operation_type::EXPORT ||
+             type == file_handler::operation_type::CLEAN) && load_header_metadata()) {
+            return;
+        }
+
+        load_image();
+    }
+
+    /**
+     * @brief Load the whole image through Exiv2
+     * @return True if the metadata could be read
+     */
+    bool jpeg_processor_class::load_image() {
+        jpeg_loaded = false;
         try {
             // load jpeg file
-            jpeg_image = Exiv2::ImageFactory::open(file_path);
+            jpeg_image = Exiv2::ImageFactory::open(input_map->get_data(), static_cast<size_t>(input_map->size()));
             if (jpeg_image.get() != nullptr) {
                 jpeg_image->readMetadata();
                 jpeg_loaded = true;
@@ -21,21 +66,61 @@ namespace jpeg_processor {
         } catch (const std::exception& e) {
             std::cerr << "Exception: " << e.what() << std::endl;
         }
+        return jpeg_loaded;
     }
 
     jpeg_processor_class::~jpeg_processor_class() = default;
 
+    /**
+     * @brief Parse the metadata from the bytes preceding the first SOS marker
+     *
+     * Exiv2 only sees the mapped header segments up to and including the SOS
+     * (or EOI) marker, where it stops parsing, so the pages holding the
+     * entropy-coded data are never touched.
+     *
+     * @return False if the header could not be parsed, the caller then loads the whole file
+     */
+    bool jpeg_processor_class::load_header_metadata() {
+        try {
+            const std::uint64_t scan_offset = jpeg_segments::walk_header(*input_map, [](const jpeg_segments::segment&) {});
+            const std::uint64_t header_size = std::min<std::uint64_t>(input_map->size(), scan_offset + 2);
+
+            jpeg_image = Exiv2::ImageFactory::open(input_map->get_data(), static_cast<size_t>(header_size));
+            if (jpeg_image.get() != nullptr) {
+                jpeg_image->readMetadata();
+                jpeg_loaded = true;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to read JPEG header, loading the whole file: " << e.what() << std::endl;
+            jpeg_image.reset();
+        }
+        return jpeg_loaded;
+    }
+
+    /**
+     * @brief Replace the file or output buffer with the image Exiv2 wrote into its memory buffer
+     */
+    void jpeg_processor_class::write_image() {
+        Exiv2::BasicIo& io = jpeg_image->io();
+        auto out = open_output();
+        out->write(io.mmap(), io.size());
+        io.munmap();
+
+        // The mapping has to be released before the file is replaced
+        jpeg_image.reset();
+        input_map.reset();
+        jpeg_loaded = false;
+        out->commit();
+    }
+
     file_handler::operation_result jpeg_processor_class::check_prerequisites() {
-        std::ifstream file(file_path, std::ios::binary);
-        if (!file) {
+        // The header was read once when the file type was probed
+        if (file_header.empty()) {
             return {false, "Failed to open file", {}, {}};
         }
 
-        unsigned char header[2];
-        file.read(reinterpret_cast<char*>(header), 2);
-
         // JPEG files start with the magic bytes FF D8
-        if (file.good() && header[0] == 0xFF && header[1] == 0xD8) {
+        if (file_header.size() >= 2 && file_header[0] == 0xFF && file_header[1] == 0xD8) {
             return {true, "JPEG file is valid", {}, {}};
         }
         else {
@@ -51,38 +136,36 @@ namespace jpeg_processor {
         result.success = true;
         result.message = "Metadata successfully read";
 
+        if (!jpeg_loaded) {
+            return {false, "Failed to load JPEG document", {}, {}};
+        }
+
         try {
             // Read EXIF metadata
             if (jpeg_image->exifData().count() > 0) {
                 for (const auto& exif : jpeg_image->exifData()) {
-                    std::string key = "EXIF." + exif.key();
-                    std::string value = exif.toString();
-                    result.metadata[key] = value;
+                    result.metadata.set("EXIF.", exif.key(), exif.toString());
                 }
             }
 
             // Read IPTC metadata
             if (jpeg_image->iptcData().count() > 0) {
                 for (const auto& iptc : jpeg_image->iptcData()) {
-                    std::string key = "IPTC." + iptc.key();
-                    std::string value = iptc.toString();
-                    result.metadata[key] = value;
+                    result.metadata.set("IPTC.", iptc.key(), iptc.toString());
                 }
             }
 
             // Read XMP metadata
             if (jpeg_image->xmpData().count() > 0) {
                 for (const auto& xmp : jpeg_image->xmpData()) {
-                    std::string key = "XMP." + xmp.key();
-                    std::string value = xmp.toString();
-                    result.metadata[key] = value;
+                    result.metadata.set("XMP.", xmp.key(), xmp.toString());
                 }
             }
 
             // Add summary information
-            result.metadata["Total.EXIF"] = std::to_string(jpeg_image->exifData().count());
-            result.metadata["Total.IPTC"] = std::to_string(jpeg_image->iptcData().count());
-            result.metadata["Total.XMP"] = std::to_string(jpeg_image->xmpData().count());
+            result.metadata.set("Total.EXIF", std::to_string(jpeg_image->exifData().count()));
+            result.metadata.set("Total.IPTC", std::to_string(jpeg_image->iptcData().count()));
+            result.metadata.set("Total.XMP", std::to_string(jpeg_image->xmpData().count()));
 
         } catch (const Exiv2::Error& e) {
             result.success = false;
@@ -96,30 +179,126 @@ namespace jpeg_processor {
     }
 
     /**
-     * @brief THis fuction needs to be further checked
+     * @brief Strip the metadata segments and atomically replace the file or output buffer
      */
     file_handler::operation_result jpeg_processor_class::clean_metadata() {
+        if (has_selection()) {
+            return clean_selected_metadata();
+        }
+
         file_handler::operation_result result;
         result.success = true;
         result.message = "Metadata successfully cleaned";
 
         try {
-            // Clear all metadata
-            jpeg_image->clearExifData();
-            jpeg_image->clearIptcData();
-            jpeg_image->clearXmpData();
-            jpeg_image->clearComment();
+            auto in = open_input();
+            auto out = open_output();
+
+            jpeg_segments::strip(*in, *out);
+
+            in.reset();
+            out->commit();
+
+        } catch (const std::exception& e) {
+            result.success = false;
+            result.message = "Failed to clean metadata: " + std::string(e.what());
+            std::cerr << "Standard exception: " << e.what() << std::endl;
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief Remove only the selected keys
+     *
+     * EXIF entries of the main IFDs are removed from the TIFF structure in
+     * place, so the file keeps its size and only the EXIF block is written.
+     * IPTC, XMP and maker note keys need Exiv2 to rewrite the image.
+     */
+    file_handler::operation_result jpeg_processor_class::clean_selected_metadata() {
+        file_handler::operation_result result;
+        result.success = true;
+        result.message = "Selected metadata successfully removed";
+
+        if (!jpeg_loaded) {
+            return {false, "Failed to load JPEG document", {}, {}};
+        }
+
+        try {
+            std::set<tiff_ifd::tag_ref> exif_tags;
+            bool needs_rewrite = false;
+            for (const auto& exif : jpeg_image->exifData()) {
+                if (is_selected("EXIF." + exif.key())) {
+                    exif_tags.emplace(exif.groupName(), exif.tag());
+                    needs_rewrite = needs_rewrite || !tiff_ifd::is_supported_group(exif.groupName());
+                }
+            }
+            for (const auto& iptc : jpeg_image->iptcData()) {
+                needs_rewrite = needs_rewrite || is_selected("IPTC." + iptc.key());
+            }
+            for (const auto& xmp : jpeg_image->xmpData()) {
+                needs_rewrite = needs_rewrite || is_selected("XMP." + xmp.key());
+            }
+
+            if (!needs_rewrite) {
+                // Exiv2 reads the first EXIF segment only, patch the same one
+                std::vector<file_io::byte_patch> patches;
+                bool exif_found = false;
+                jpeg_segments::walk_header(*input_map, [&](const jpeg_segments::segment& seg) {
+                    static const char identifier[] = "Exif\0";
+                    if (exif_tags.empty() || exif_found || seg.marker != jpeg_segments::marker::APP1 ||
+                        seg.payload_size < sizeof(identifier) + 8) {
+                        return;
+                    }
+                    const unsigned char* payload = input_map->get_data() + seg.payload_offset;
+                    if (std::memcmp(payload, identifier, sizeof(identifier)) != 0) {
+                        return;
+                    }
+                    exif_found = true;
+
+                    file_io::byte_patch patch {seg.payload_offset + sizeof(identifier),
+                                               {payload + sizeof(identifier), payload + seg.payload_size}};
+                    if (tiff_ifd::remove_entries(patch.data.data(), patch.data.size(), exif_tags) > 0) {
+                        patches.push_back(std::move(patch));
+                    }
+                });
+
+                // The mapping has to be released before the file is patched
+                jpeg_image.reset();
+                input_map.reset();
+                jpeg_loaded = false;
+                commit_patches(patches);
+                return result;
+            }
+
+            // Keys outside the main IFDs are removed by letting Exiv2 write the whole image
+            if (!load_image()) {
+                return {false, "Failed to load JPEG document", {}, {}};
+            }
+
+            Exiv2::ExifData& exif_data = jpeg_image->exifData();
+            for (auto it = exif_data.begin(); it != exif_data.end();) {
+                it = is_selected("EXIF." + it->key()) ? exif_data.erase(it) : std::next(it);
+            }
+            Exiv2::IptcData& iptc_data = jpeg_image->iptcData();
+            for (auto it = iptc_data.begin(); it != iptc_data.end();) {
+                it = is_selected("IPTC." + it->key()) ? iptc_data.erase(it) : std::next(it);
+            }
+            Exiv2::XmpData& xmp_data = jpeg_image->xmpData();
+            for (auto it = xmp_data.begin(); it != xmp_data.end();) {
+                it = is_selected("XMP." + it->key()) ? xmp_data.erase(it) : std::next(it);
+            }
 
-            // Write changes back to file
             jpeg_image->writeMetadata();
+            write_image();
 
         } catch (const Exiv2::Error& e) {
             result.success = false;
-            result.message = "Failed to clean metadata: " + std::string(e.what());
+            result.message = "Failed to remove selected metadata: " + std::string(e.what());
             std::cerr << "Exiv2 error: " << e.what() << std::endl;
         } catch (const std::exception& e) {
             result.success = false;
-            result.message = "Exception: " + std::string(e.what());
+            result.message = "Failed to remove selected metadata: " + std::string(e.what());
             std::cerr << "Standard exception: " << e.what() << std::endl;
         }
 
@@ -131,6 +310,10 @@ namespace jpeg_processor {
         result.success = true;
         result.message = "Metadata successfully overwritten";
 
+        if (!jpeg_loaded) {
+            return {false, "Failed to load JPEG document", {}, {}};
+        }
+
         try {
             // First clear all existing metadata
             jpeg_image->clearExifData();
@@ -198,6 +381,7 @@ namespace jpeg_processor {
 
             // Write changes back to file
             jpeg_image->writeMetadata();
+            write_image();
 
         } catch (const Exiv2::Error& e) {
             result.success = false;
@@ -248,7 +432,7 @@ namespace jpeg_processor {
             for (const auto& [key, value] : result.metadata) {
                 if (!first) out << ",\n";
                 // Escape JSON special characters in the value
-                std::string escaped_value = value;
+                std::string escaped_value(value);
                 size_t pos = 0;
                 while ((pos = escaped_value.find("\"", pos)) != std::string::npos) {
                     escaped_value.replace(pos, 1, "\\\"");
@@ -0,0 +1,123 @@
+/**
+ * @file jpeg_segments.cpp
+ * @brief Implementation of marker-level JPEG parsing and stripping
+ */
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include "./processors/jpeg_segments.h"
+
+namespace jpeg_segments {
+
+    namespace {
+
+        /**
+         * @brief Markers that stand alone without a length field
+         */
+        bool is_standalone(unsigned char code) {
+            return code == 0x01 || (code >= 0xD0 && code <= 0xD7);
+        }
+
+        bool is_icc_profile(const file_io::byte_source& source, const segment& seg) {
+            static const char identifier[] = "ICC_PROFILE";
+            unsigned char buffer[sizeof(identifier)];
+            if (seg.payload_size < sizeof(identifier)) {
+                return false;
+            }
+            source.read_exact(seg.payload_offset, buffer, sizeof(identifier));
+            return std::memcmp(buffer, identifier, sizeof(identifier)) == 0;
+        }
+
+        bool should_remove(const file_io::byte_source& source, const segment& seg, const strip_options& options) {
+            if (seg.marker == marker::APP1 || seg.marker == marker::APP13 || seg.marker == marker::COM) {
+                return true;
+            }
+            if (!options.remove_all_app_segments || seg.marker < marker::APP0 || seg.marker > marker::APP15) {
+                return false;
+            }
+            if (seg.marker == marker::APP0 || seg.marker == marker::APP14) {
+                return false;
+            }
+            return !(seg.marker == marker::APP2 && is_icc_profile(source, seg));
+        }
+
+    }
+
+    std::uint64_t walk_header(const file_io::byte_source& source,
+                              const std::function<void(const segment&)>& callback) {
+        const std::uint64_t size = source.size();
+        unsigned char buffer[4];
+
+        source.read_exact(0, buffer, 2);
+        if (buffer[0] != 0xFF || buffer[1] != marker::SOI) {
+            throw std::runtime_error("Missing JPEG start of image marker");
+        }
+
+        std::uint64_t offset = 2;
+        while (offset < size) {
+            const std::size_t available = source.read_at(offset, buffer, sizeof(buffer));
+            if (available < 2 || buffer[0] != 0xFF) {
+                throw std::runtime_error("Expected a JPEG marker at offset " + std::to_string(offset));
+            }
+
+            // Any number of 0xFF fill bytes may precede a marker
+            if (buffer[1] == 0xFF) {
+                offset++;
+                continue;
+            }
+
+            const unsigned char code = buffer[1];
+            if (code == marker::SOS || code == marker::EOI) {
+                return offset;
+            }
+
+            segment seg {code, offset, 2, offset + 2, 0};
+            if (!is_standalone(code)) {
+                if (available < 4) {
+                    throw std::runtime_error("Truncated JPEG segment at offset " + std::to_string(offset));
+                }
+                const std::size_t length = (static_cast<std::size_t>(buffer[2]) << 8) | buffer[3];
+                if (length < 2 || offset + 2 + length > size) {
+                    throw std::runtime_error("Invalid JPEG segment length at offset " + std::to_string(offset));
+                }
+                seg.size = 2 + length;
+                seg.payload_offset = offset + 4;
+                seg.payload_size = length - 2;
+            }
+
+            callback(seg);
+            offset += seg.size;
+        }
+
+        return size;
+    }
+
+    std::size_t strip(const file_io::byte_source& source, file_io::byte_sink& sink, const strip_options& options) {
+        // Adjacent segments that are kept are copied as one range, starting with SOI
+        std::uint64_t run_start = 0;
+        std::uint64_t run_end = 2;
+        std::size_t removed = 0;
+
+        const std::uint64_t scan_offset = walk_header(source, [&](const segment& seg) {
+            if (should_remove(source, seg, options)) {
+                removed++;
+                return;
+            }
+            if (seg.offset != run_end) {
+                sink.copy_from(source, run_start, run_end - run_start);
+                run_start = seg.offset;
+            }
+            run_end = seg.offset + seg.size;
+        });
+
+        if (scan_offset != run_end) {
+            sink.copy_from(source, run_start, run_end - run_start);
+            run_start = scan_offset;
+        }
+
+        // Entropy-coded data, later scans and any trailer are not interpreted
+        sink.copy_from(source, run_start, source.size() - run_start);
+        return removed;
+    }
+
+}
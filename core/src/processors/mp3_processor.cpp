@@ -0,0 +1,914 @@
+/**
+ * @file mp3_processor.cpp
+ * @brief Implementation of the MP3 metadata processor
+ */
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <stdexcept>
+#include "./processors/mp3_processor.h"
+
+namespace mp3_processor {
+
+    namespace {
+
+        // Frame values larger than this are pictures or similar, only their size is reported
+        constexpr std::uint64_t max_value_size = 64 * 1024;
+
+        constexpr std::size_t id3v1_size = 128;
+        constexpr std::size_t ape_footer_size = 32;
+        constexpr std::uint32_t ape_has_header = 0x80000000u;
+
+        /**
+         * @brief State shared while rebuilding the tags of one file
+         */
+        struct tag_context {
+            std::function<bool(const std::string&)> drop;   // nullptr keeps every key
+            bool drop_all {false};                          // drop every tag without looking inside
+            std::map<std::string, std::string>* found {nullptr};  // receives the keys seen, if set
+            std::vector<std::string>* warnings {nullptr};
+            std::size_t removed {0};
+            std::size_t id3v2_count {0};
+            std::size_t id3v1_count {0};
+            std::size_t ape_count {0};
+            std::size_t lyrics_count {0};
+
+            [[nodiscard]] bool dropping(const std::string& key) const {
+                return drop_all || (drop && drop(key));
+            }
+
+            void report(const std::string& key, const std::string& value) const {
+                if (found == nullptr) {
+                    return;
+                }
+                // Frames such as COMM may repeat with different languages or descriptions. Values
+                // are joined here, replacing them in the result arena would keep every old copy
+                const auto [it, added] = found->emplace(key, value);
+                if (!added) {
+                    it->second.append("; ").append(value);
+                }
+            }
+        };
+
+        std::uint32_t get32le(const unsigned char* p) {
+            return static_cast<std::uint32_t>(p[0]) | (static_cast<std::uint32_t>(p[1]) << 8) |
+                   (static_cast<std::uint32_t>(p[2]) << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+        }
+
+        void put32le(unsigned char* p, std::uint32_t value) {
+            p[0] = static_cast<unsigned char>(value);
+            p[1] = static_cast<unsigned char>(value >> 8);
+            p[2] = static_cast<unsigned char>(value >> 16);
+            p[3] = static_cast<unsigned char>(value >> 24);
+        }
+
+        std::uint32_t get32be(const unsigned char* p) {
+            return (static_cast<std::uint32_t>(p[0]) << 24) | (static_cast<std::uint32_t>(p[1]) << 16) |
+                   (static_cast<std::uint32_t>(p[2]) << 8) | p[3];
+        }
+
+        /**
+         * @brief Append a byte range of the source to out
+         */
+        void append_range(std::vector<unsigned char>& out, const file_io::byte_source& source,
+                          std::uint64_t offset, std::uint64_t size) {
+            const std::size_t start = out.size();
+            out.resize(start + static_cast<std::size_t>(size));
+            source.read_exact(offset, out.data() + start, static_cast<std::size_t>(size));
+        }
+
+        void append_utf8(std::string& out, std::uint32_t code_point) {
+            if (code_point < 0x80) {
+                out += static_cast<char>(code_point);
+            } else if (code_point < 0x800) {
+                out += static_cast<char>(0xC0 | (code_point >> 6));
+                out += static_cast<char>(0x80 | (code_point & 0x3F));
+            } else if (code_point < 0x10000) {
+                out += static_cast<char>(0xE0 | (code_point >> 12));
+                out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (code_point & 0x3F));
+            } else {
+                out += static_cast<char>(0xF0 | (code_point >> 18));
+                out += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (code_point & 0x3F));
+            }
+        }
+
+        /**
+         * @brief Convert one string in an ID3v2 text encoding to UTF-8
+         * @param encoding 0 Latin-1, 1 UTF-16 with BOM, 2 UTF-16BE, 3 UTF-8
+         */
+        std::string decode_string(unsigned char encoding, const unsigned char* data, std::size_t size) {
+            std::string out;
+            if (encoding == 1 || encoding == 2) {
+                bool big_endian = encoding == 2;
+                std::size_t i = 0;
+                if (encoding == 1 && size >= 2 && ((data[0] == 0xFF && data[1] == 0xFE) ||
+                                                   (data[0] == 0xFE && data[1] == 0xFF))) {
+                    big_endian = data[0] == 0xFE;
+                    i = 2;
+                }
+                for (; i + 1 < size; i += 2) {
+                    std::uint32_t unit = big_endian ? (data[i] << 8) | data[i + 1] : (data[i + 1] << 8) | data[i];
+                    if (unit >= 0xD800 && unit < 0xDC00 && i + 3 < size) {
+                        const std::uint32_t low = big_endian ? (data[i + 2] << 8) | data[i + 3]
+                                                             : (data[i + 3] << 8) | data[i + 2];
+                        if (low >= 0xDC00 && low < 0xE000) {
+                            unit = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+                            i += 2;
+                        }
+                    }
+                    append_utf8(out, unit);
+                }
+            } else if (encoding == 3) {
+                out.assign(reinterpret_cast<const char*>(data), size);
+            } else {
+                for (std::size_t i = 0; i < size; i++) {
+                    append_utf8(out, data[i]);
+                }
+            }
+            return out;
+        }
+
+        /**
+         * @brief Read a string ended by a terminator of the encoding's width
+         * @param pos Start of the string, moved past the terminator
+         */
+        std::string read_terminated(unsigned char encoding, const std::vector<unsigned char>& data, std::size_t& pos) {
+            const std::size_t width = encoding == 1 || encoding == 2 ? 2 : 1;
+            std::size_t end = pos;
+            while (end + width <= data.size() && !(data[end] == 0 && (width == 1 || data[end + 1] == 0))) {
+                end += width;
+            }
+            std::string text = decode_string(encoding, data.data() + pos, std::min(end, data.size()) - pos);
+            pos = std::min(end + width, data.size());
+            return text;
+        }
+
+        /**
+         * @brief Convert the rest of a frame to UTF-8, ID3v2.4 separates multiple values with terminators
+         */
+        std::string read_text(unsigned char encoding, const std::vector<unsigned char>& data, std::size_t pos) {
+            std::string text;
+            while (pos < data.size()) {
+                std::string part = read_terminated(encoding, data, pos);
+                if (part.empty()) {
+                    continue;
+                }
+                if (!text.empty()) {
+                    text += "; ";
+                }
+                text += part;
+            }
+            return text;
+        }
+
+        /**
+         * @brief Read the data of one frame and turn it into a key and a value
+         * @param body Source holding the frames
+         * @param frame Frame to decode
+         * @param version Major version of the tag
+         * @param unsynchronised True if ID3v2.4 frames of this tag are all unsynchronised
+         * @return Key and value of the frame
+         */
+        std::pair<std::string, std::string> decode_frame(const file_io::byte_source& body,
+                                                         const mp3_tags::id3v2_frame& frame,
+                                                         unsigned version, bool unsynchronised) {
+            std::string key = "ID3v2." + frame.id;
+            const std::string size_text = std::to_string(frame.size) + " bytes";
+
+            // Compressed and encrypted frames cannot be read, only their size is reported
+            const bool opaque = version == 3 ? (frame.flags & 0x00C0) != 0 : (frame.flags & 0x000C) != 0;
+            if (opaque) {
+                return {key, "(" + size_text + ")"};
+            }
+
+            const bool picture = frame.id == "APIC" || frame.id == "PIC";
+            if (frame.size > max_value_size && !picture) {
+                return {key, "(" + size_text + ")"};
+            }
+            // The picture itself is not needed, the part with the MIME type and description is
+            std::vector<unsigned char> data(static_cast<std::size_t>(std::min(frame.size, max_value_size)));
+            body.read_exact(frame.data_offset(), data.data(), data.size());
+
+            std::size_t skip = 0;
+            if (version == 3 && (frame.flags & 0x0020) != 0) {
+                skip = 1;                                   // group id
+            } else if (version == 4) {
+                skip = ((frame.flags & 0x0040) != 0 ? 1 : 0) + ((frame.flags & 0x0001) != 0 ? 4 : 0);
+            }
+            data.erase(data.begin(), data.begin() + static_cast<std::ptrdiff_t>(std::min(skip, data.size())));
+            if (version == 4 && (unsynchronised || (frame.flags & 0x0002) != 0)) {
+                data = mp3_tags::remove_unsynchronisation(data.data(), data.size());
+            }
+            if (data.empty()) {
+                return {key, ""};
+            }
+
+            const unsigned char encoding = data[0];
+            const std::string& id = frame.id;
+            if (id == "TXXX" || id == "TXX" || id == "WXXX" || id == "WXX") {
+                std::size_t pos = 1;
+                key += ":" + read_terminated(encoding, data, pos);
+                return {key, id[0] == 'T' ? read_text(encoding, data, pos) : decode_string(0, data.data() + pos,
+                                                                                           data.size() - pos)};
+            }
+            if (id[0] == 'T') {
+                return {key, read_text(encoding, data, 1)};
+            }
+            if (id[0] == 'W') {
+                return {key, decode_string(0, data.data(), data.size())};
+            }
+            if ((id == "COMM" || id == "COM" || id == "USLT" || id == "ULT") && data.size() >= 4) {
+                std::size_t pos = 4;                        // encoding and language
+                const std::string description = read_terminated(encoding, data, pos);
+                const std::string text = read_text(encoding, data, pos);
+                return {key, description.empty() ? text : description + ": " + text};
+            }
+            if (id == "APIC") {
+                std::size_t pos = 1;
+                const std::string mime = read_terminated(0, data, pos);
+                return {key, "(" + mime + ", " + size_text + ")"};
+            }
+            if (id == "PIC" && data.size() >= 4) {
+                return {key, "(" + decode_string(0, data.data() + 1, 3) + ", " + size_text + ")"};
+            }
+            return {key, "(" + size_text + ")"};
+        }
+
+        /**
+         * @brief Report the frames of an ID3v2 tag and rebuild it without the dropped ones
+         * @param out Receives the rebuilt tag, or a copy of it if nothing was dropped
+         */
+        void rebuild_id3v2(const file_io::byte_source& source, const mp3_tags::tag& t,
+                           std::vector<unsigned char>& out, tag_context& ctx) {
+            if (ctx.drop_all) {
+                ctx.removed++;
+                return;
+            }
+
+            unsigned char raw_header[10];
+            source.read_exact(t.offset, raw_header, sizeof(raw_header));
+            mp3_tags::id3v2_header header {};
+            mp3_tags::parse_id3v2_header(raw_header, header);
+
+            if (header.version == 2 && (header.flags & 0x40) != 0) {
+                if (ctx.warnings != nullptr) {
+                    ctx.warnings->push_back("Compressed ID3v2.2 tag left unchanged");
+                }
+                append_range(out, source, t.offset, t.size);
+                return;
+            }
+
+            // ID3v2.2 and 2.3 unsynchronise the whole tag, frames can only be found in a decoded copy
+            const file_io::byte_source* body = &source;
+            std::uint64_t begin = t.offset + 10;
+            std::uint64_t end = begin + header.size;
+            std::vector<unsigned char> decoded;
+            std::unique_ptr<file_io::memory_source> decoded_source;
+            if (header.version < 4 && (header.flags & mp3_tags::id3v2_flag::UNSYNCHRONISATION) != 0) {
+                std::vector<unsigned char> encoded(header.size);
+                source.read_exact(begin, encoded.data(), encoded.size());
+                decoded = mp3_tags::remove_unsynchronisation(encoded.data(), encoded.size());
+                decoded_source = std::make_unique<file_io::memory_source>(decoded.data(), decoded.size());
+                body = decoded_source.get();
+                begin = 0;
+                end = decoded.size();
+            }
+
+            if ((header.flags & mp3_tags::id3v2_flag::EXTENDED_HEADER) != 0 && end - begin >= 4) {
+                unsigned char size_bytes[4];
+                body->read_exact(begin, size_bytes, sizeof(size_bytes));
+                // The ID3v2.3 size leaves out its own four bytes, the ID3v2.4 one does not
+                const std::uint64_t extended_size = header.version == 3
+                    ? get32be(size_bytes) + 4ull
+                    : mp3_tags::get_syncsafe(size_bytes);
+                begin += std::min(extended_size, end - begin);
+            }
+
+            const bool unsynchronised = header.version == 4 &&
+                                        (header.flags & mp3_tags::id3v2_flag::UNSYNCHRONISATION) != 0;
+            const std::size_t start = out.size();
+            out.insert(out.end(), raw_header, raw_header + sizeof(raw_header));
+            std::size_t kept = 0;
+            std::size_t removed = 0;
+            for (const auto& frame : mp3_tags::id3v2_frames(*body, begin, end, header.version)) {
+                const auto [key, value] = decode_frame(*body, frame, header.version, unsynchronised);
+                ctx.report(key, value);
+                ctx.id3v2_count++;
+                if (ctx.dropping(key)) {
+                    removed++;
+                } else {
+                    append_range(out, *body, frame.offset, frame.header_size + frame.size);
+                    kept++;
+                }
+            }
+
+            if (removed == 0) {
+                out.resize(start);
+                append_range(out, source, t.offset, t.size);
+                return;
+            }
+            ctx.removed += removed;
+            if (kept == 0) {
+                out.resize(start);
+                return;
+            }
+
+            // Frames were copied decoded and without the extended header
+            unsigned char flags = header.flags & ~mp3_tags::id3v2_flag::EXTENDED_HEADER;
+            if (header.version < 4) {
+                flags &= ~mp3_tags::id3v2_flag::UNSYNCHRONISATION;
+            }
+            out[start + 5] = flags;
+            mp3_tags::put_syncsafe(out.data() + start + 6, static_cast<std::uint32_t>(out.size() - start - 10));
+            if ((flags & mp3_tags::id3v2_flag::FOOTER) != 0) {
+                const std::size_t footer = out.size();
+                out.insert(out.end(), out.begin() + static_cast<std::ptrdiff_t>(start),
+                           out.begin() + static_cast<std::ptrdiff_t>(start + 10));
+                std::memcpy(out.data() + footer, "3DI", 3);
+            }
+        }
+
+        /**
+         * @brief Get a fixed-width ID3v1 text field without the trailing zeros and spaces
+         */
+        std::string id3v1_text(const unsigned char* data, std::size_t size) {
+            std::size_t length = 0;
+            while (length < size && data[length] != 0) {
+                length++;
+            }
+            while (length > 0 && data[length - 1] == ' ') {
+                length--;
+            }
+            return decode_string(0, data, length);
+        }
+
+        /**
+         * @brief Report an ID3v1 tag and its extension block and blank the dropped fields
+         * @param extended Location of the "TAG+" block before the tag, nullptr if there is none
+         */
+        void rebuild_id3v1(const file_io::byte_source& source, const mp3_tags::tag& t, const mp3_tags::tag* extended,
+                           std::vector<unsigned char>& out, tag_context& ctx) {
+            if (ctx.drop_all) {
+                ctx.removed += extended != nullptr ? 2 : 1;
+                return;
+            }
+
+            unsigned char v1[id3v1_size];
+            source.read_exact(t.offset, v1, sizeof(v1));
+            std::vector<unsigned char> plus;
+            if (extended != nullptr) {
+                plus.resize(static_cast<std::size_t>(extended->size));
+                source.read_exact(extended->offset, plus.data(), plus.size());
+            }
+
+            // ID3v1.1 keeps the track number in the last byte of the comment
+            const bool has_track = v1[125] == 0 && v1[126] != 0;
+            struct field {
+                const char* name;
+                std::size_t offset;
+                std::size_t size;
+                std::size_t plus_offset;                    // continuation in "TAG+", 0 for none
+                std::size_t plus_size;
+            };
+            const field fields[] = {
+                {"Title", 3, 30, 4, 60},
+                {"Artist", 33, 30, 64, 60},
+                {"Album", 63, 30, 124, 60},
+                {"Year", 93, 4, 0, 0},
+                {"Comment", 97, has_track ? 28u : 30u, 0, 0}
+            };
+
+            bool changed = false;
+            bool drop_extended = false;
+            for (const auto& f : fields) {
+                std::string value = id3v1_text(v1 + f.offset, f.size);
+                if (!plus.empty() && f.plus_offset != 0) {
+                    value += id3v1_text(plus.data() + f.plus_offset, f.plus_size);
+                }
+                const std::string key = std::string("ID3v1.") + f.name;
+                if (value.empty()) {
+                    continue;
+                }
+                ctx.report(key, value);
+                ctx.id3v1_count++;
+                if (ctx.dropping(key)) {
+                    std::memset(v1 + f.offset, 0, f.size);
+                    drop_extended = drop_extended || f.plus_offset != 0;
+                    changed = true;
+                    ctx.removed++;
+                }
+            }
+            if (has_track) {
+                ctx.report("ID3v1.Track", std::to_string(v1[126]));
+                ctx.id3v1_count++;
+                if (ctx.dropping("ID3v1.Track")) {
+                    v1[126] = 0;
+                    changed = true;
+                    ctx.removed++;
+                }
+            }
+            const std::string plus_genre = plus.empty() ? std::string() : id3v1_text(plus.data() + 185, 30);
+            if (v1[127] != 0xFF || !plus_genre.empty()) {
+                ctx.report("ID3v1.Genre", plus_genre.empty() ? std::to_string(v1[127]) : plus_genre);
+                ctx.id3v1_count++;
+                if (ctx.dropping("ID3v1.Genre")) {
+                    v1[127] = 0xFF;
+                    drop_extended = drop_extended || !plus_genre.empty();
+                    changed = true;
+                    ctx.removed++;
+                }
+            }
+
+            if (!changed) {
+                out.insert(out.end(), plus.begin(), plus.end());
+                out.insert(out.end(), v1, v1 + sizeof(v1));
+                return;
+            }
+            // The extension only continues fields of the tag, it goes with any of them
+            if (!plus.empty() && !drop_extended) {
+                out.insert(out.end(), plus.begin(), plus.end());
+            }
+            const bool blank = std::all_of(v1 + 3, v1 + 127, [](unsigned char c) { return c == 0; }) && v1[127] == 0xFF;
+            if (!blank || (!plus.empty() && !drop_extended)) {
+                out.insert(out.end(), v1, v1 + sizeof(v1));
+            }
+        }
+
+        /**
+         * @brief Report the items of an APE tag and rebuild it without the dropped ones
+         */
+        void rebuild_ape(const file_io::byte_source& source, const mp3_tags::tag& t,
+                         std::vector<unsigned char>& out, tag_context& ctx) {
+            if (ctx.drop_all) {
+                ctx.removed++;
+                return;
+            }
+
+            std::vector<unsigned char> data(static_cast<std::size_t>(t.size));
+            source.read_exact(t.offset, data.data(), data.size());
+            const unsigned char* footer = data.data() + data.size() - ape_footer_size;
+            const bool has_header = (get32le(footer + 20) & ape_has_header) != 0 && data.size() >= 2 * ape_footer_size;
+            const std::size_t items_end = data.size() - ape_footer_size;
+            const std::uint32_t count = get32le(footer + 16);
+
+            std::vector<unsigned char> items;
+            std::size_t kept = 0;
+            std::size_t removed = 0;
+            std::size_t pos = has_header ? ape_footer_size : 0;
+            for (std::uint32_t i = 0; i < count && items_end - pos >= 9; i++) {
+                const std::uint32_t value_size = get32le(data.data() + pos);
+                const std::uint32_t flags = get32le(data.data() + pos + 4);
+                const auto key_begin = data.begin() + static_cast<std::ptrdiff_t>(pos + 8);
+                const auto key_end = std::find(key_begin, data.begin() + static_cast<std::ptrdiff_t>(items_end), 0);
+                const std::size_t value_offset = static_cast<std::size_t>(key_end - data.begin()) + 1;
+                if (key_end == data.begin() + static_cast<std::ptrdiff_t>(items_end) ||
+                    value_size > items_end - value_offset) {
+                    if (ctx.warnings != nullptr) {
+                        ctx.warnings->push_back("Malformed APE item skipped");
+                    }
+                    break;
+                }
+                const std::string key = "APE." + std::string(key_begin, key_end);
+                const std::size_t item_end = value_offset + value_size;
+
+                // Bits 1-2 tell text, binary or external locator
+                std::string value;
+                if (((flags >> 1) & 3) == 1) {
+                    value = "(" + std::to_string(value_size) + " bytes)";
+                } else {
+                    const std::vector<unsigned char> text(data.begin() + static_cast<std::ptrdiff_t>(value_offset),
+                                                          data.begin() + static_cast<std::ptrdiff_t>(item_end));
+                    value = read_text(3, text, 0);
+                }
+                ctx.report(key, value);
+                ctx.ape_count++;
+                if (ctx.dropping(key)) {
+                    removed++;
+                } else {
+                    items.insert(items.end(), data.begin() + static_cast<std::ptrdiff_t>(pos),
+                                 data.begin() + static_cast<std::ptrdiff_t>(item_end));
+                    kept++;
+                }
+                pos = item_end;
+            }
+
+            if (removed == 0) {
+                out.insert(out.end(), data.begin(), data.end());
+                return;
+            }
+            ctx.removed += removed;
+            if (kept == 0) {
+                return;
+            }
+
+            // Header and footer carry the same size, counting the items and the footer
+            const auto size = static_cast<std::uint32_t>(items.size() + ape_footer_size);
+            std::vector<unsigned char> new_footer(footer, footer + ape_footer_size);
+            put32le(new_footer.data() + 12, size);
+            put32le(new_footer.data() + 16, static_cast<std::uint32_t>(kept));
+            if (has_header) {
+                std::vector<unsigned char> new_header(data.begin(), data.begin() + ape_footer_size);
+                put32le(new_header.data() + 12, size);
+                put32le(new_header.data() + 16, static_cast<std::uint32_t>(kept));
+                out.insert(out.end(), new_header.begin(), new_header.end());
+            }
+            out.insert(out.end(), items.begin(), items.end());
+            out.insert(out.end(), new_footer.begin(), new_footer.end());
+        }
+
+        /**
+         * @brief Report the fields of a Lyrics3v2 tag, the whole tag goes if any of them is dropped
+         */
+        void rebuild_lyrics3(const file_io::byte_source& source, const mp3_tags::tag& t,
+                             std::vector<unsigned char>& out, tag_context& ctx) {
+            if (ctx.drop_all) {
+                ctx.removed++;
+                return;
+            }
+
+            std::vector<unsigned char> data(static_cast<std::size_t>(t.size));
+            source.read_exact(t.offset, data.data(), data.size());
+
+            // Fields follow "LYRICSBEGIN" as a three letter id, a five digit size and the text
+            bool dropped = false;
+            std::size_t pos = 11;
+            const std::size_t fields_end = data.size() - 15;
+            while (fields_end - pos >= 8) {
+                std::size_t size = 0;
+                bool digits = true;
+                for (std::size_t i = pos + 3; i < pos + 8; i++) {
+                    digits = digits && data[i] >= '0' && data[i] <= '9';
+                    size = size * 10 + (data[i] - '0');
+                }
+                if (!digits || size > fields_end - pos - 8) {
+                    break;
+                }
+                const std::string key = "Lyrics3." + std::string(data.begin() + static_cast<std::ptrdiff_t>(pos),
+                                                                 data.begin() + static_cast<std::ptrdiff_t>(pos + 3));
+                ctx.report(key, size > max_value_size ? "(" + std::to_string(size) + " bytes)"
+                                                      : decode_string(0, data.data() + pos + 8, size));
+                ctx.lyrics_count++;
+                dropped = dropped || ctx.dropping(key);
+                pos += 8 + size;
+            }
+
+            if (dropped) {
+                ctx.removed++;
+            } else {
+                out.insert(out.end(), data.begin(), data.end());
+            }
+        }
+
+        /**
+         * @brief Find the tags of a file and rebuild them
+         * @param source MP3 data
+         * @param ctx Decides what is dropped and collects what is seen
+         * @return Rebuilt head and tail tags
+         */
+        tag_plan plan_tags(const file_io::byte_source& source, tag_context& ctx) {
+            tag_plan plan;
+            plan.layout = mp3_tags::locate(source);
+
+            const std::size_t removed_before = ctx.removed;
+            for (const auto& t : plan.layout.head) {
+                rebuild_id3v2(source, t, plan.head, ctx);
+            }
+            plan.head_changed = ctx.removed != removed_before;
+
+            const std::size_t removed_in_head = ctx.removed;
+            const mp3_tags::tag* extended = nullptr;
+            for (const auto& t : plan.layout.tail) {
+                switch (t.kind) {
+                    case mp3_tags::tag_kind::ID3V1_EXTENDED:
+                        extended = &t;          // written together with the ID3v1 tag after it
+                        break;
+                    case mp3_tags::tag_kind::ID3V1:
+                        rebuild_id3v1(source, t, extended, plan.tail, ctx);
+                        extended = nullptr;
+                        break;
+                    case mp3_tags::tag_kind::APE:
+                        rebuild_ape(source, t, plan.tail, ctx);
+                        break;
+                    case mp3_tags::tag_kind::LYRICS3:
+                        rebuild_lyrics3(source, t, plan.tail, ctx);
+                        break;
+                    case mp3_tags::tag_kind::ID3V2:
+                        rebuild_id3v2(source, t, plan.tail, ctx);
+                        break;
+                }
+            }
+            plan.tail_changed = ctx.removed != removed_in_head;
+            return plan;
+        }
+
+        /**
+         * @brief Append an ID3v2.4 frame
+         */
+        void append_frame(std::vector<unsigned char>& tag, const std::string& id, const std::string& data) {
+            unsigned char header[10] = {};
+            std::memcpy(header, id.data(), 4);
+            mp3_tags::put_syncsafe(header + 4, static_cast<std::uint32_t>(data.size()));
+            tag.insert(tag.end(), header, header + sizeof(header));
+            tag.insert(tag.end(), data.begin(), data.end());
+        }
+
+        bool is_frame_id(const std::string& id) {
+            return id.size() == 4 && std::all_of(id.begin(), id.end(), [](char c) {
+                return (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+            });
+        }
+
+    }
+
+    mp3_processor_class::mp3_processor_class(const std::string& path,
+                                             file_handler::operation_type type,
+                                             file_handler::shared_options opts,
+                                             file_properties::file_type_probe probe,
+                                             file_handler::buffer_binding buffers)
+            : file_handler_class(path, type, std::move(opts), std::move(probe), buffers) {}
+
+    mp3_processor_class::~mp3_processor_class() = default;
+
+    file_handler::operation_result mp3_processor_class::check_prerequisites() {
+        // The header was read once when the file type was probed
+        if (file_header.size() < 2) {
+            return {false, "Failed to read file header", {}, {}};
+        }
+        if (!mp3_tags::looks_like_mp3(file_header.data(), file_header.size())) {
+            return {false, "File is not a valid MP3 file", {}, {}};
+        }
+        return {true, "MP3 file is valid", {}, {}};
+    }
+
+    file_handler::operation_result mp3_processor_class::read_metadata() {
+        file_handler::operation_result result;
+        result.success = true;
+        result.message = "Metadata successfully read";
+
+        try {
+            auto in = open_input();
+            std::map<std::string, std::string> found;
+            tag_context ctx;
+            ctx.found = &found;
+            ctx.warnings = &result.warnings;
+            plan_tags(*in, ctx);
+
+            for (const auto& [key, value] : found) {
+                result.metadata.set(key, value);
+            }
+
+            result.metadata.set("Total.ID3v2", std::to_string(ctx.id3v2_count));
+            result.metadata.set("Total.ID3v1", std::to_string(ctx.id3v1_count));
+            result.metadata.set("Total.APE", std::to_string(ctx.ape_count));
+            result.metadata.set("Total.Lyrics3", std::to_string(ctx.lyrics_count));
+
+        } catch (const std::exception& e) {
+            result.success = false;
+            result.message = "Exception: " + std::string(e.what());
+        }
+
+        return result;
+    }
+
+    void mp3_processor_class::rewrite(const std::function<bool(const std::string&)>& drop,
+                                      const std::vector<unsigned char>& new_head,
+                                      std::vector<std::string>& warnings) const {
+        auto in = open_input();
+        tag_context ctx;
+        ctx.drop = drop;
+        ctx.drop_all = !drop;
+        ctx.warnings = &warnings;
+        auto plan = plan_tags(*in, ctx);
+
+        if (!new_head.empty()) {
+            plan.head = new_head;
+            plan.head_changed = true;
+        }
+        commit_tags(std::move(in), plan);
+    }
+
+    void mp3_processor_class::commit_tags(std::unique_ptr<file_io::byte_source> source, tag_plan& plan) const {
+        const bool in_place = !in_memory() && get_output_path() == std::filesystem::path(file_path);
+        if (!plan.head_changed && !plan.tail_changed && in_place) {
+            return;
+        }
+        const auto& layout = plan.layout;
+
+        // Only tags after the audio change: cut the file at the audio end and append what is left of them
+        if (in_place && !plan.head_changed) {
+            source.reset();
+            commit_tail(layout.audio_end, plan.tail);
+            return;
+        }
+
+        // A single ID3v2 tag that did not grow is padded to its old size, so the audio stays where it is
+        const bool fits = layout.head.size() == 1 && !plan.head.empty() &&
+                          plan.head.size() <= layout.head.front().size &&
+                          (plan.head[5] & mp3_tags::id3v2_flag::FOOTER) == 0 &&
+                          (layout.head.front().size - 10) < (1u << 28);
+        if (in_place && fits) {
+            file_io::byte_patch patch {0, std::move(plan.head)};
+            patch.data.resize(static_cast<std::size_t>(layout.head.front().size), 0);
+            mp3_tags::put_syncsafe(patch.data.data() + 6, static_cast<std::uint32_t>(patch.data.size() - 10));
+            source.reset();
+            commit_patches({patch});
+            if (plan.tail_changed) {
+                commit_tail(layout.audio_end, plan.tail);
+            }
+            return;
+        }
+
+        auto out = open_output();
+        out->write(plan.head.data(), plan.head.size());
+        out->copy_from(*source, layout.audio_begin, layout.audio_end - layout.audio_begin);
+        out->write(plan.tail.data(), plan.tail.size());
+        source.reset();
+        out->commit();
+    }
+
+    /**
+     * @brief Remove the ID3v2, ID3v1, APE and Lyrics3 tags
+     *
+     * With selected properties only the matching frames, fields and items
+     * are removed, tags left empty are dropped.
+     */
+    file_handler::operation_result mp3_processor_class::clean_metadata() {
+        file_handler::operation_result result;
+        result.success = true;
+        result.message = has_selection() ? "Selected metadata successfully removed" : "Metadata successfully cleaned";
+
+        try {
+            std::function<bool(const std::string&)> drop;
+            if (has_selection()) {
+                drop = [this](const std::string& key) { return is_selected(key); };
+            }
+            rewrite(drop, {}, result.warnings);
+
+        } catch (const std::exception& e) {
+            result.success = false;
+            result.message = "Failed to clean metadata: " + std::string(e.what());
+            std::cerr << "Standard exception: " << e.what() << std::endl;
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief Replace all tags with an ID3v2.4 tag holding the values from the options
+     *
+     * "ID3v2.<frame>" keys for text frames, "ID3v2.TXXX:<description>",
+     * "ID3v2.COMM" and the common fields become UTF-8 frames. ID3v2.4 allows
+     * one frame per ID (per description for TXXX), so when several keys map to
+     * the same frame an "ID3v2." key wins over a common field, and among
+     * common fields the earlier one in the table wins, e.g. Artist over Author.
+     */
+    file_handler::operation_result mp3_processor_class::overwrite_metadata() {
+        file_handler::operation_result result;
+        result.success = true;
+        result.message = "Metadata successfully overwritten";
+
+        try {
+            static const std::pair<const char*, const char*> common_frames[] = {
+                {"Title", "TIT2"}, {"Artist", "TPE1"}, {"Author", "TPE1"}, {"Album", "TALB"},
+                {"Comment", "COMM"}, {"DateCreated", "TDRC"}, {"Year", "TDRC"}, {"Genre", "TCON"},
+                {"Copyright", "TCOP"}, {"Software", "TSSE"}
+            };
+
+            // Frame data by frame ID, or "TXXX:<description>", with the rank of the key that set it
+            std::map<std::string, std::pair<std::size_t, std::string>> frames;
+            for (const auto& [key, value] : options.overwrite_metadata) {
+                if (key.empty() || value.empty()) {
+                    continue;
+                }
+
+                std::string id;
+                std::string description;
+                std::size_t rank = 0;
+                const auto common = std::find_if(std::begin(common_frames), std::end(common_frames),
+                                                 [&key](const auto& frame) { return key == frame.first; });
+                if (key.compare(0, 11, "ID3v2.TXXX:") == 0) {
+                    id = "TXXX";
+                    description = key.substr(11);
+                } else if (key.compare(0, 6, "ID3v2.") == 0 && is_frame_id(key.substr(6)) &&
+                           (key[6] == 'T' || key.substr(6) == "COMM")) {
+                    id = key.substr(6);
+                } else if (common != std::end(common_frames)) {
+                    id = common->second;
+                    rank = 1 + static_cast<std::size_t>(common - std::begin(common_frames));
+                } else {
+                    result.warnings.push_back("Unsupported metadata key for MP3: " + key);
+                    continue;
+                }
+
+                // Encoding 3 is UTF-8, comments also carry a language and an empty description
+                std::string data(1, '\x03');
+                if (id == "COMM") {
+                    data += std::string("und") + '\0';
+                } else if (id == "TXXX") {
+                    data += description + '\0';
+                }
+                data += value;
+
+                const std::string frame_key = id == "TXXX" ? id + ":" + description : id;
+                const auto existing = frames.find(frame_key);
+                if (existing == frames.end() || rank < existing->second.first) {
+                    frames[frame_key] = {rank, std::move(data)};
+                }
+            }
+
+            std::vector<unsigned char> tag = {'I', 'D', '3', 4, 0, 0, 0, 0, 0, 0};
+            for (const auto& [frame_key, frame] : frames) {
+                append_frame(tag, frame_key.substr(0, 4), frame.second);
+            }
+            if (tag.size() == 10) {
+                tag.clear();
+            } else {
+                mp3_tags::put_syncsafe(tag.data() + 6, static_cast<std::uint32_t>(tag.size() - 10));
+            }
+
+            rewrite(nullptr, tag, result.warnings);
+
+        } catch (const std::exception& e) {
+            result.success = false;
+            result.message = "Failed to overwrite metadata: " + std::string(e.what());
+            std::cerr << "Standard exception: " << e.what() << std::endl;
+        }
+
+        return result;
+    }
+
+    file_handler::operation_result mp3_processor_class::export_metadata() {
+        // First read the metadata
+        auto result = read_metadata();
+        if (!result.success) {
+            return result;
+        }
+
+        try {
+            // Create output directory if needed
+            if (!options.output_directory.empty() && !std::filesystem::exists(options.output_directory)) {
+                std::filesystem::create_directories(options.output_directory);
+            }
+
+            // Create output file path
+            std::filesystem::path output_path;
+            if (options.output_directory.empty()) {
+                output_path = std::filesystem::path(file_path).parent_path() /
+                             (std::filesystem::path(file_path).stem().string() + "_metadata.json");
+            } else {
+                output_path = options.output_directory /
+                             (std::filesystem::path(file_path).stem().string() + "_metadata.json");
+            }
+
+            // Write to output file
+            std::ofstream out(output_path);
+            if (!out) {
+                result.success = false;
+                result.message = "Failed to create output file: " + output_path.string();
+                return result;
+            }
+
+            // Write in JSON format
+            out << "{\n";
+            bool first = true;
+            for (const auto& [key, value] : result.metadata) {
+                if (!first) out << ",\n";
+                // Escape JSON special characters in the value
+                std::string escaped_value(value);
+                size_t pos = 0;
+                while ((pos = escaped_value.find("\"", pos)) != std::string::npos) {
+                    escaped_value.replace(pos, 1, "\\\"");
+                    pos += 2;
+                }
+                out << "  \"" << key << "\": \"" << escaped_value << "\"";
+                first = false;
+            }
+            out << "\n}";
+
+            out.close();
+
+            result.message = "Metadata successfully exported to: " + output_path.string();
+
+        } catch (const std::exception& e) {
+            result.success = false;
+            result.message = "Failed to export metadata: " + std::string(e.what());
+        }
+
+        return result;
+    }
+
+    file_handler::operation_result mp3_processor_class::restore_metadata() {
+        file_handler::operation_result result;
+        result.success = false;
+        result.message = "Restore operation not implemented for MP3";
+
+        return result;
+    }
+
+}
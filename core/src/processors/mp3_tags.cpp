@@ -0,0 +1,216 @@
+/**
+ * @file mp3_tags.cpp
+ * @brief Implementation of MP3 tag location and parsing
+ */
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include "./processors/mp3_tags.h"
+
+namespace mp3_tags {
+
+    namespace {
+
+        constexpr std::uint64_t id3v1_size = 128;
+        constexpr std::uint64_t id3v1_extended_size = 227;
+        constexpr std::uint64_t ape_footer_size = 32;
+        constexpr std::uint32_t ape_has_header = 0x80000000u;
+
+        std::uint32_t get32le(const unsigned char* p) {
+            return static_cast<std::uint32_t>(p[0]) | (static_cast<std::uint32_t>(p[1]) << 8) |
+                   (static_cast<std::uint32_t>(p[2]) << 16) | (static_cast<std::uint32_t>(p[3]) << 24);
+        }
+
+        bool matches_at(const file_io::byte_source& source, std::uint64_t offset, const char* magic, std::size_t size) {
+            unsigned char buffer[16];
+            return source.read_at(offset, buffer, size) == size && std::memcmp(buffer, magic, size) == 0;
+        }
+
+        /**
+         * @brief Recognize one tag ending at end, so tags can be peeled off the tail one by one
+         * @return True if a tag was found, found is filled with it
+         */
+        bool tag_before(const file_io::byte_source& source, std::uint64_t begin, std::uint64_t end, tag& found) {
+            const std::uint64_t available = end - begin;
+            unsigned char buffer[ape_footer_size];
+
+            if (available >= id3v1_size && matches_at(source, end - id3v1_size, "TAG", 3)) {
+                found = {tag_kind::ID3V1, end - id3v1_size, id3v1_size};
+                return true;
+            }
+
+            if (available >= ape_footer_size && matches_at(source, end - ape_footer_size, "APETAGEX", 8)) {
+                source.read_exact(end - ape_footer_size, buffer, ape_footer_size);
+                const std::uint64_t size = get32le(buffer + 12) +
+                                           ((get32le(buffer + 20) & ape_has_header) != 0 ? ape_footer_size : 0);
+                if (size >= ape_footer_size && size <= available) {
+                    found = {tag_kind::APE, end - size, size};
+                    return true;
+                }
+            }
+
+            // Lyrics3v2 ends with a six digit size and "LYRICS200"
+            if (available >= 15 + 11 && matches_at(source, end - 9, "LYRICS200", 9)) {
+                source.read_exact(end - 15, buffer, 6);
+                std::uint64_t size = 0;
+                bool digits = true;
+                for (int i = 0; i < 6; i++) {
+                    digits = digits && buffer[i] >= '0' && buffer[i] <= '9';
+                    size = size * 10 + (buffer[i] - '0');
+                }
+                if (digits && size + 15 <= available && matches_at(source, end - 15 - size, "LYRICSBEGIN", 11)) {
+                    found = {tag_kind::LYRICS3, end - 15 - size, size + 15};
+                    return true;
+                }
+            }
+
+            // ID3v2.4 allows appending a tag with a footer
+            if (available >= 20 && matches_at(source, end - 10, "3DI", 3)) {
+                source.read_exact(end - 10, buffer, 10);
+                const std::uint64_t size = static_cast<std::uint64_t>(get_syncsafe(buffer + 6)) + 20;
+                if (size <= available && matches_at(source, end - size, "ID3", 3)) {
+                    found = {tag_kind::ID3V2, end - size, size};
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+    }
+
+    std::uint32_t get_syncsafe(const unsigned char* p) {
+        return (static_cast<std::uint32_t>(p[0] & 0x7F) << 21) | (static_cast<std::uint32_t>(p[1] & 0x7F) << 14) |
+               (static_cast<std::uint32_t>(p[2] & 0x7F) << 7) | (p[3] & 0x7F);
+    }
+
+    void put_syncsafe(unsigned char* p, std::uint32_t value) {
+        if (value >= (1u << 28)) {
+            throw std::invalid_argument("Value too large for a syncsafe integer");
+        }
+        p[0] = static_cast<unsigned char>((value >> 21) & 0x7F);
+        p[1] = static_cast<unsigned char>((value >> 14) & 0x7F);
+        p[2] = static_cast<unsigned char>((value >> 7) & 0x7F);
+        p[3] = static_cast<unsigned char>(value & 0x7F);
+    }
+
+    bool parse_id3v2_header(const unsigned char* data, id3v2_header& header) {
+        if (std::memcmp(data, "ID3", 3) != 0 || data[3] < 2 || data[3] > 4 || data[4] == 0xFF) {
+            return false;
+        }
+        if ((data[6] | data[7] | data[8] | data[9]) & 0x80) {
+            return false;
+        }
+        header.version = data[3];
+        header.flags = data[5];
+        header.size = get_syncsafe(data + 6);
+        return true;
+    }
+
+    bool looks_like_mp3(const unsigned char* data, std::size_t size) {
+        id3v2_header header {};
+        if (size >= 10 && parse_id3v2_header(data, header)) {
+            return true;
+        }
+        return size >= 2 && data[0] == 0xFF && (data[1] & 0xE0) == 0xE0;
+    }
+
+    tag_layout locate(const file_io::byte_source& source) {
+        tag_layout layout;
+        const std::uint64_t size = source.size();
+        unsigned char buffer[10];
+
+        std::uint64_t begin = 0;
+        while (size - begin >= 10) {
+            source.read_exact(begin, buffer, 10);
+            id3v2_header header {};
+            if (!parse_id3v2_header(buffer, header)) {
+                break;
+            }
+            const std::uint64_t tag_size = 10 + static_cast<std::uint64_t>(header.size) +
+                                           (header.version == 4 && (header.flags & id3v2_flag::FOOTER) != 0 ? 10 : 0);
+            if (tag_size > size - begin) {
+                throw std::runtime_error("Truncated ID3v2 tag at offset " + std::to_string(begin));
+            }
+            layout.head.push_back({tag_kind::ID3V2, begin, tag_size});
+            begin += tag_size;
+        }
+
+        std::uint64_t end = size;
+        tag found {};
+        while (end > begin && tag_before(source, begin, end, found)) {
+            layout.tail.push_back(found);
+            end = found.offset;
+
+            // The extension block precedes ID3v1 and is only valid together with it
+            if (found.kind == tag_kind::ID3V1 && end - begin >= id3v1_extended_size &&
+                matches_at(source, end - id3v1_extended_size, "TAG+", 4)) {
+                layout.tail.push_back({tag_kind::ID3V1_EXTENDED, end - id3v1_extended_size, id3v1_extended_size});
+                end -= id3v1_extended_size;
+            }
+        }
+        std::reverse(layout.tail.begin(), layout.tail.end());
+
+        layout.audio_begin = begin;
+        layout.audio_end = end;
+        return layout;
+    }
+
+    std::vector<unsigned char> remove_unsynchronisation(const unsigned char* data, std::size_t size) {
+        std::vector<unsigned char> decoded;
+        decoded.reserve(size);
+        for (std::size_t i = 0; i < size; i++) {
+            decoded.push_back(data[i]);
+            if (data[i] == 0xFF && i + 1 < size && data[i + 1] == 0x00) {
+                i++;
+            }
+        }
+        return decoded;
+    }
+
+    std::vector<id3v2_frame> id3v2_frames(const file_io::byte_source& body, std::uint64_t begin,
+                                          std::uint64_t end, unsigned version) {
+        std::vector<id3v2_frame> frames;
+        const std::size_t header_size = version == 2 ? 6 : 10;
+        const std::size_t id_size = version == 2 ? 3 : 4;
+        unsigned char header[10];
+
+        std::uint64_t offset = begin;
+        while (end - offset >= header_size) {
+            body.read_exact(offset, header, header_size);
+            // Padding starts with a zero byte where the next frame id would be
+            if (header[0] == 0) {
+                break;
+            }
+
+            id3v2_frame frame;
+            frame.id.assign(reinterpret_cast<const char*>(header), id_size);
+            frame.offset = offset;
+            frame.header_size = header_size;
+            if (version == 2) {
+                frame.size = (static_cast<std::uint64_t>(header[3]) << 16) | (header[4] << 8) | header[5];
+                frame.flags = 0;
+            } else if (version == 3) {
+                frame.size = (static_cast<std::uint64_t>(header[4]) << 24) | (header[5] << 16) |
+                             (header[6] << 8) | header[7];
+                frame.flags = static_cast<std::uint16_t>((header[8] << 8) | header[9]);
+            } else {
+                frame.size = get_syncsafe(header + 4);
+                frame.flags = static_cast<std::uint16_t>((header[8] << 8) | header[9]);
+            }
+
+            const bool valid_id = std::all_of(frame.id.begin(), frame.id.end(), [](char c) {
+                return (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9');
+            });
+            // Some writers leave garbage instead of zero padding, the frames end there
+            if (!valid_id || frame.size > end - offset - header_size) {
+                break;
+            }
+
+            frames.push_back(frame);
+            offset = frame.end();
+        }
+        return frames;
+    }
+
+}
@@ -0,0 +1,113 @@
+/**
+ * @file mp4_boxes.cpp
+ * @brief Implementation of box-level ISO base media parsing
+ */
+#include <cstring>
+#include <stdexcept>
+#include "./processors/mp4_boxes.h"
+
+namespace mp4_boxes {
+
+    std::uint32_t get32(const unsigned char* p) {
+        return (static_cast<std::uint32_t>(p[0]) << 24) | (static_cast<std::uint32_t>(p[1]) << 16) |
+               (static_cast<std::uint32_t>(p[2]) << 8) | p[3];
+    }
+
+    std::uint64_t get64(const unsigned char* p) {
+        return (static_cast<std::uint64_t>(get32(p)) << 32) | get32(p + 4);
+    }
+
+    void put32(unsigned char* p, std::uint32_t value) {
+        p[0] = static_cast<unsigned char>(value >> 24);
+        p[1] = static_cast<unsigned char>(value >> 16);
+        p[2] = static_cast<unsigned char>(value >> 8);
+        p[3] = static_cast<unsigned char>(value);
+    }
+
+    void put64(unsigned char* p, std::uint64_t value) {
+        put32(p, static_cast<std::uint32_t>(value >> 32));
+        put32(p + 4, static_cast<std::uint32_t>(value));
+    }
+
+    void walk(const file_io::byte_source& source, std::uint64_t begin, std::uint64_t end,
+              const std::function<void(const box&)>& callback) {
+        unsigned char header[16];
+
+        std::uint64_t offset = begin;
+        // Some writers pad container boxes with up to 7 zero bytes, too few for a box header
+        while (end - offset >= 8) {
+            source.read_exact(offset, header, 8);
+
+            box b;
+            b.offset = offset;
+            b.type.assign(reinterpret_cast<const char*>(header + 4), 4);
+            b.header_size = 8;
+            const std::uint32_t size32 = get32(header);
+            if (size32 == 1) {
+                if (end - offset < 16) {
+                    throw std::runtime_error("Truncated box header at offset " + std::to_string(offset));
+                }
+                source.read_exact(offset + 8, header + 8, 8);
+                b.header_size = 16;
+                b.size = get64(header + 8);
+            } else if (size32 == 0) {
+                b.size = end - offset;
+            } else {
+                b.size = size32;
+            }
+
+            if (b.size < b.header_size || b.size > end - offset) {
+                throw std::runtime_error("Invalid size of box " + b.type + " at offset " + std::to_string(offset));
+            }
+
+            callback(b);
+            offset += b.size;
+        }
+    }
+
+    std::uint64_t meta_children_offset(const file_io::byte_source& source, const box& meta) {
+        if (meta.data_size() < 8) {
+            return meta.data_offset();
+        }
+        // The version and flags of a full box are zero, a child box starts with a non-zero size
+        unsigned char head[4];
+        source.read_exact(meta.data_offset(), head, sizeof(head));
+        return get32(head) == 0 ? meta.data_offset() + 4 : meta.data_offset();
+    }
+
+    std::size_t append_header(std::vector<unsigned char>& out, const std::string& type, std::uint64_t data_size) {
+        const bool large = data_size > 0xFFFFFFFFull - 8;
+        const std::size_t header_size = large ? 16 : 8;
+        const std::size_t at = out.size();
+        out.resize(at + header_size);
+
+        put32(&out[at], large ? 1 : static_cast<std::uint32_t>(data_size + 8));
+        std::memcpy(&out[at + 4], type.data(), 4);
+        if (large) {
+            put64(&out[at + 8], data_size + 16);
+        }
+        return header_size;
+    }
+
+    void append_free(std::vector<unsigned char>& out, std::uint64_t size) {
+        if (size < 8) {
+            throw std::invalid_argument("A free box needs at least 8 bytes");
+        }
+        const std::size_t header_size = append_header(out, "free", size - 8);
+        if (header_size == 16) {
+            // Sizes needing a 64-bit header keep the requested total
+            put64(&out[out.size() - 8], size);
+        }
+        out.resize(out.size() + (size - header_size), 0);
+    }
+
+    void append_range(std::vector<unsigned char>& out, const file_io::byte_source& source,
+                      std::uint64_t offset, std::uint64_t size) {
+        const std::size_t at = out.size();
+        out.resize(at + size);
+        if (size > 0) {
+            source.read_exact(offset, &out[at], size);
+        }
+    }
+
+}
@@ -0,0 +1,967 @@
+/**
+ * @file mp4_processor.cpp
+ * @brief Implementation of the MP4 metadata processor
+ */
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <exiv2/exiv2.hpp>
+#include "./processors/mp4_processor.h"
+
+namespace mp4_processor {
+
+    namespace {
+
+        // Extended type of the uuid box Adobe uses for XMP in MP4 files
+        const unsigned char xmp_uuid[16] = {0xBE, 0x7A, 0xCF, 0xCB, 0x97, 0xA9, 0x42, 0xE8,
+                                            0x9C, 0x71, 0x99, 0x94, 0x91, 0xE3, 0xAF, 0xAC};
+
+        const std::string creation_key = "Movie.CreationTime";
+        const std::string modification_key = "Movie.ModificationTime";
+
+        // QuickTime times count seconds from 1904-01-01
+        constexpr std::uint64_t seconds_1904_to_1970 = 2082844800ull;
+
+        // Item values larger than this are cover art or similar, only their size is reported
+        constexpr std::uint64_t max_value_size = 64 * 1024;
+
+        /**
+         * @brief State shared while rebuilding the boxes of one file
+         */
+        struct edit_context {
+            std::function<bool(const std::string&)> drop;   // nullptr keeps every key
+            bool drop_all {false};                          // drop metadata boxes without looking inside
+            metadata_table::metadata_map* found {nullptr};  // receives the keys seen, if set
+            std::vector<std::string>* warnings {nullptr};
+            std::vector<std::size_t> chunk_tables;          // stco and co64 boxes of the box being rebuilt
+            std::size_t removed {0};
+            std::size_t tracks {0};
+            std::size_t user_data_count {0};
+            std::size_t item_count {0};
+            std::size_t xmp_count {0};
+
+            [[nodiscard]] bool dropping(const std::string& key) const {
+                return drop_all || (drop && drop(key));
+            }
+
+            void report(const std::string& key, const std::string& value) const {
+                if (found != nullptr) {
+                    found->set(key, value);
+                }
+            }
+        };
+
+        /**
+         * @brief Get the key name of an atom type, QuickTime's 0xA9 prefix becomes "©"
+         */
+        std::string display_type(const std::string& type) {
+            if (!type.empty() && static_cast<unsigned char>(type[0]) == 0xA9) {
+                return "\xC2\xA9" + type.substr(1);
+            }
+            return type;
+        }
+
+        /**
+         * @brief Inverse of display_type
+         */
+        std::string atom_type(const std::string& name) {
+            if (name.compare(0, 2, "\xC2\xA9") == 0) {
+                return "\xA9" + name.substr(2);
+            }
+            return name;
+        }
+
+        /**
+         * @brief Get data as text, or a size note if it is binary
+         */
+        std::string describe(const unsigned char* data, std::size_t size) {
+            while (size > 0 && data[size - 1] == 0) {
+                size--;
+            }
+            for (std::size_t i = 0; i < size; i++) {
+                if (data[i] < 0x20 && data[i] != '\t' && data[i] != '\n' && data[i] != '\r') {
+                    return "(" + std::to_string(size) + " bytes)";
+                }
+            }
+            return {reinterpret_cast<const char*>(data), size};
+        }
+
+        std::vector<unsigned char> read_data(const file_io::byte_source& source, const mp4_boxes::box& b) {
+            std::vector<unsigned char> data;
+            mp4_boxes::append_range(data, source, b.data_offset(), b.data_size());
+            return data;
+        }
+
+        /**
+         * @brief Decode a QuickTime text atom, a list of (length, language, text) entries
+         */
+        std::string quicktime_text(const std::vector<unsigned char>& data) {
+            std::string text;
+            std::size_t pos = 0;
+            while (data.size() - pos >= 4) {
+                const std::size_t length = (static_cast<std::size_t>(data[pos]) << 8) | data[pos + 1];
+                if (length > data.size() - pos - 4) {
+                    break;
+                }
+                if (!text.empty()) {
+                    text += "; ";
+                }
+                text += describe(data.data() + pos + 4, length);
+                pos += 4 + length;
+            }
+            if (pos != data.size() || data.empty()) {
+                // Not a text atom, e.g. vendor specific binary data
+                return describe(data.data(), data.size());
+            }
+            return text;
+        }
+
+        /**
+         * @brief Decode the data boxes of an item list entry
+         */
+        std::string item_value(const file_io::byte_source& source, const mp4_boxes::box& item) {
+            std::string value;
+            mp4_boxes::walk(source, item.data_offset(), item.end(), [&](const mp4_boxes::box& child) {
+                if (child.type != "data" || child.data_size() < 8) {
+                    return;
+                }
+                if (!value.empty()) {
+                    value += "; ";
+                }
+                if (child.data_size() > max_value_size + 8) {
+                    value += "(" + std::to_string(child.data_size() - 8) + " bytes)";
+                    return;
+                }
+
+                const auto data = read_data(source, child);
+                const std::uint32_t kind = mp4_boxes::get32(data.data()) & 0xFFFFFF;
+                const unsigned char* content = data.data() + 8;
+                const std::size_t size = data.size() - 8;
+
+                if ((kind == 21 || kind == 22) && size >= 1 && size <= 8) {
+                    // Big-endian signed (21) or unsigned (22) integer
+                    std::uint64_t number = 0;
+                    for (std::size_t i = 0; i < size; i++) {
+                        number = (number << 8) | content[i];
+                    }
+                    if (kind == 21 && size < 8 && (content[0] & 0x80) != 0) {
+                        number |= ~0ull << (size * 8);
+                    }
+                    value += kind == 21 ? std::to_string(static_cast<std::int64_t>(number)) : std::to_string(number);
+                } else if (kind == 1) {
+                    value.append(reinterpret_cast<const char*>(content), size);
+                } else {
+                    value += describe(content, size);
+                }
+            });
+            return value;
+        }
+
+        /**
+         * @brief Get the name of a freeform "----" item from its name box
+         */
+        std::string freeform_name(const file_io::byte_source& source, const mp4_boxes::box& item) {
+            std::string name;
+            mp4_boxes::walk(source, item.data_offset(), item.end(), [&](const mp4_boxes::box& child) {
+                if (child.type == "name" && child.data_size() > 4) {
+                    const auto data = read_data(source, child);
+                    name.assign(reinterpret_cast<const char*>(data.data()) + 4, data.size() - 4);
+                }
+            });
+            return name.empty() ? "----" : name;
+        }
+
+        /**
+         * @brief Read the key names of a QuickTime keys box, item types in ilst are 1-based indexes into it
+         */
+        std::vector<std::string> read_keys(const file_io::byte_source& source, const mp4_boxes::box& keys) {
+            std::vector<std::string> names;
+            const auto data = read_data(source, keys);
+            if (data.size() < 8) {
+                return names;
+            }
+            const std::uint32_t count = mp4_boxes::get32(data.data() + 4);
+            std::size_t pos = 8;
+            for (std::uint32_t i = 0; i < count && data.size() - pos >= 8; i++) {
+                const std::size_t size = mp4_boxes::get32(data.data() + pos);
+                if (size < 8 || size > data.size() - pos) {
+                    break;
+                }
+                names.emplace_back(reinterpret_cast<const char*>(data.data()) + pos + 8, size - 8);
+                pos += size;
+            }
+            return names;
+        }
+
+        std::string format_time(std::uint64_t seconds) {
+            // Days since 1970-01-01 to a civil date, valid for the whole range of the field
+            const std::int64_t since_1970 = static_cast<std::int64_t>(seconds) - static_cast<std::int64_t>(seconds_1904_to_1970);
+            std::int64_t days = since_1970 / 86400;
+            std::int64_t rest = since_1970 % 86400;
+            if (rest < 0) {
+                rest += 86400;
+                days--;
+            }
+            days += 719468;
+            const std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+            const std::int64_t day_of_era = days - era * 146097;
+            const std::int64_t year_of_era = (day_of_era - day_of_era / 1460 + day_of_era / 36524 - day_of_era / 146096) / 365;
+            const std::int64_t day_of_year = day_of_era - (365 * year_of_era + year_of_era / 4 - year_of_era / 100);
+            const std::int64_t mp = (5 * day_of_year + 2) / 153;
+            const std::int64_t day = day_of_year - (153 * mp + 2) / 5 + 1;
+            const std::int64_t month = mp < 10 ? mp + 3 : mp - 9;
+            const std::int64_t year = year_of_era + era * 400 + (month <= 2 ? 1 : 0);
+
+            char text[48];
+            std::snprintf(text, sizeof(text), "%04lld-%02lld-%02lld %02lld:%02lld:%02lld",
+                          static_cast<long long>(year), static_cast<long long>(month), static_cast<long long>(day),
+                          static_cast<long long>(rest / 3600), static_cast<long long>(rest / 60 % 60),
+                          static_cast<long long>(rest % 60));
+            return text;
+        }
+
+        /**
+         * @brief Store the size of a box whose content has been appended after its header
+         */
+        void finish_box(std::vector<unsigned char>& out, std::size_t start) {
+            const std::size_t size = out.size() - start;
+            if (size > std::numeric_limits<std::uint32_t>::max()) {
+                throw std::runtime_error("Rebuilt box exceeds 4 GB");
+            }
+            mp4_boxes::put32(&out[start], static_cast<std::uint32_t>(size));
+        }
+
+        /**
+         * @brief Report the times of a copied mvhd, tkhd or mdhd box and zero them if selected
+         *
+         * Track and media headers carry the same times as the movie header,
+         * they are cleared with it so the recording time does not survive.
+         */
+        void clear_times(std::vector<unsigned char>& out, std::size_t start, const mp4_boxes::box& b,
+                         edit_context& ctx) {
+            const std::size_t size = out.size() - start - b.header_size;
+            unsigned char* data = &out[start + b.header_size];
+            if (size < 4) {
+                return;
+            }
+            const std::size_t width = data[0] == 1 ? 8 : 4;
+            if (size < 4 + 2 * width) {
+                return;
+            }
+
+            for (int i = 0; i < 2; i++) {
+                unsigned char* field = data + 4 + i * width;
+                const std::uint64_t value = width == 8 ? mp4_boxes::get64(field) : mp4_boxes::get32(field);
+                if (value == 0) {
+                    continue;
+                }
+                const std::string& key = i == 0 ? creation_key : modification_key;
+                if (b.type == "mvhd") {
+                    ctx.report(key, format_time(value));
+                }
+                if (ctx.dropping(key)) {
+                    std::memset(field, 0, width);
+                    ctx.removed++;
+                }
+            }
+        }
+
+        /**
+         * @brief Report the properties of an XMP packet and rebuild it without the selected ones
+         * @param source Data holding the box
+         * @param b udta/XMP_ box or uuid box
+         * @param packet_offset Offset of the packet, after the uuid of a uuid box
+         * @param out Receives the box unless it is dropped
+         */
+        void rebuild_xmp(const file_io::byte_source& source, const mp4_boxes::box& b, std::uint64_t packet_offset,
+                         std::vector<unsigned char>& out, edit_context& ctx) {
+            if (ctx.drop_all) {
+                ctx.removed++;
+                return;
+            }
+
+            std::string packet(static_cast<std::size_t>(b.end() - packet_offset), '\0');
+            if (!packet.empty()) {
+                source.read_exact(packet_offset, packet.data(), packet.size());
+            }
+
+            Exiv2::XmpData xmp_data;
+            if (Exiv2::XmpParser::decode(xmp_data, packet) != 0) {
+                if (ctx.warnings != nullptr) {
+                    ctx.warnings->push_back("Malformed XMP packet at offset " + std::to_string(b.offset));
+                }
+                mp4_boxes::append_range(out, source, b.offset, b.size);
+                return;
+            }
+
+            std::size_t removed = 0;
+            for (auto it = xmp_data.begin(); it != xmp_data.end();) {
+                const std::string key = "XMP." + it->key();
+                ctx.report(key, it->toString());
+                ctx.xmp_count++;
+                if (ctx.dropping(key)) {
+                    it = xmp_data.erase(it);
+                    removed++;
+                } else {
+                    ++it;
+                }
+            }
+
+            if (removed == 0) {
+                mp4_boxes::append_range(out, source, b.offset, b.size);
+                return;
+            }
+            ctx.removed += removed;
+            if (xmp_data.empty()) {
+                return;
+            }
+
+            std::string new_packet;
+            if (Exiv2::XmpParser::encode(new_packet, xmp_data) != 0) {
+                throw std::runtime_error("Failed to encode XMP packet");
+            }
+            const std::size_t start = out.size();
+            mp4_boxes::append_header(out, b.type, 0);
+            mp4_boxes::append_range(out, source, b.data_offset(), packet_offset - b.data_offset());
+            out.insert(out.end(), new_packet.begin(), new_packet.end());
+            finish_box(out, start);
+        }
+
+        bool is_xmp_uuid(const file_io::byte_source& source, const mp4_boxes::box& b) {
+            if (b.type != "uuid" || b.data_size() < sizeof(xmp_uuid)) {
+                return false;
+            }
+            unsigned char id[sizeof(xmp_uuid)];
+            source.read_exact(b.data_offset(), id, sizeof(id));
+            return std::memcmp(id, xmp_uuid, sizeof(id)) == 0;
+        }
+
+        /**
+         * @brief Rebuild a meta box without the selected item list entries
+         *
+         * The box is dropped when its item list ends up empty. Other children
+         * (handler, keys) are kept as they are.
+         */
+        void rebuild_meta(const file_io::byte_source& source, const mp4_boxes::box& meta, const std::string& prefix,
+                          std::vector<unsigned char>& out, edit_context& ctx) {
+            if (ctx.drop_all) {
+                ctx.removed++;
+                return;
+            }
+
+            const std::uint64_t children = mp4_boxes::meta_children_offset(source, meta);
+            std::vector<std::string> keys;
+            mp4_boxes::walk(source, children, meta.end(), [&](const mp4_boxes::box& child) {
+                if (child.type == "keys") {
+                    keys = read_keys(source, child);
+                }
+            });
+
+            const std::size_t start = out.size();
+            mp4_boxes::append_header(out, meta.type, 0);
+            mp4_boxes::append_range(out, source, meta.data_offset(), children - meta.data_offset());
+
+            std::size_t kept = 0;
+            std::size_t removed = 0;
+            mp4_boxes::walk(source, children, meta.end(), [&](const mp4_boxes::box& child) {
+                if (child.type != "ilst") {
+                    mp4_boxes::append_range(out, source, child.offset, child.size);
+                    return;
+                }
+
+                const std::size_t list_start = out.size();
+                mp4_boxes::append_header(out, child.type, 0);
+                mp4_boxes::walk(source, child.data_offset(), child.end(), [&](const mp4_boxes::box& item) {
+                    std::string key;
+                    unsigned char type_bytes[4];
+                    std::memcpy(type_bytes, item.type.data(), 4);
+                    const std::uint32_t index = mp4_boxes::get32(type_bytes);
+                    if (!keys.empty() && index >= 1 && index <= keys.size()) {
+                        key = prefix + "QuickTime." + keys[index - 1];
+                    } else if (item.type == "----") {
+                        key = prefix + "iTunes." + freeform_name(source, item);
+                    } else {
+                        key = prefix + "iTunes." + display_type(item.type);
+                    }
+                    if (ctx.found != nullptr) {
+                        ctx.report(key, item_value(source, item));
+                    }
+                    ctx.item_count++;
+
+                    if (ctx.dropping(key)) {
+                        removed++;
+                    } else {
+                        mp4_boxes::append_range(out, source, item.offset, item.size);
+                        kept++;
+                    }
+                });
+                finish_box(out, list_start);
+            });
+
+            ctx.removed += removed;
+            if (removed > 0 && kept == 0) {
+                out.resize(start);
+                return;
+            }
+            finish_box(out, start);
+        }
+
+        /**
+         * @brief Rebuild a udta box without the selected atoms, dropping it when nothing is left
+         */
+        void rebuild_user_data(const file_io::byte_source& source, const mp4_boxes::box& udta,
+                               const std::string& prefix, std::vector<unsigned char>& out, edit_context& ctx) {
+            if (ctx.drop_all) {
+                ctx.removed++;
+                return;
+            }
+
+            const std::size_t start = out.size();
+            const std::size_t removed_before = ctx.removed;
+            mp4_boxes::append_header(out, udta.type, 0);
+
+            mp4_boxes::walk(source, udta.data_offset(), udta.end(), [&](const mp4_boxes::box& child) {
+                if (child.type == "meta") {
+                    rebuild_meta(source, child, prefix, out, ctx);
+                    return;
+                }
+                if (child.type == "XMP_") {
+                    rebuild_xmp(source, child, child.data_offset(), out, ctx);
+                    return;
+                }
+
+                const std::string key = prefix + "UserData." + display_type(child.type);
+                if (ctx.found != nullptr) {
+                    ctx.report(key, child.data_size() > max_value_size
+                                        ? "(" + std::to_string(child.data_size()) + " bytes)"
+                                        : quicktime_text(read_data(source, child)));
+                }
+                ctx.user_data_count++;
+
+                if (ctx.dropping(key)) {
+                    ctx.removed++;
+                } else {
+                    mp4_boxes::append_range(out, source, child.offset, child.size);
+                }
+            });
+
+            if (ctx.removed != removed_before && out.size() == start + 8) {
+                out.resize(start);
+                return;
+            }
+            finish_box(out, start);
+        }
+
+        void rebuild_box(const file_io::byte_source& source, const mp4_boxes::box& b, const std::string& prefix,
+                         std::vector<unsigned char>& out, edit_context& ctx);
+
+        /**
+         * @brief Rebuild a container box child by child
+         * @param extra Boxes appended after the children, nullptr for none
+         */
+        void rebuild_container(const file_io::byte_source& source, const mp4_boxes::box& b, const std::string& prefix,
+                               std::vector<unsigned char>& out, edit_context& ctx,
+                               const std::vector<unsigned char>* extra = nullptr) {
+            const std::size_t start = out.size();
+            mp4_boxes::append_header(out, b.type, 0);
+            mp4_boxes::walk(source, b.data_offset(), b.end(), [&](const mp4_boxes::box& child) {
+                rebuild_box(source, child, prefix, out, ctx);
+            });
+            if (extra != nullptr) {
+                out.insert(out.end(), extra->begin(), extra->end());
+            }
+            finish_box(out, start);
+        }
+
+        void rebuild_box(const file_io::byte_source& source, const mp4_boxes::box& b, const std::string& prefix,
+                         std::vector<unsigned char>& out, edit_context& ctx) {
+            if (b.type == "trak") {
+                ctx.tracks++;
+                rebuild_container(source, b, "Track" + std::to_string(ctx.tracks) + ".", out, ctx);
+            } else if (b.type == "mdia" || b.type == "minf" || b.type == "stbl") {
+                rebuild_container(source, b, prefix, out, ctx);
+            } else if (b.type == "udta") {
+                rebuild_user_data(source, b, prefix, out, ctx);
+            } else if (b.type == "meta") {
+                rebuild_meta(source, b, prefix, out, ctx);
+            } else if (is_xmp_uuid(source, b)) {
+                rebuild_xmp(source, b, b.data_offset() + sizeof(xmp_uuid), out, ctx);
+            } else {
+                const std::size_t start = out.size();
+                if (b.type == "stco" || b.type == "co64") {
+                    ctx.chunk_tables.push_back(start);
+                }
+                mp4_boxes::append_range(out, source, b.offset, b.size);
+                if (b.type == "mvhd" || b.type == "tkhd" || b.type == "mdhd") {
+                    clear_times(out, start, b, ctx);
+                }
+            }
+        }
+
+        /**
+         * @brief Top-level boxes of a file and the rebuilt ones among them
+         */
+        struct edit_plan {
+            std::vector<mp4_boxes::box> boxes;
+            std::vector<box_edit> edits;
+        };
+
+        /**
+         * @brief Rebuild moov and the top-level metadata boxes
+         *
+         * moov is read into memory once, the other boxes are only read if they
+         * hold metadata. mdat is never read.
+         *
+         * @param extra_user_data udta box appended to moov, empty for none
+         */
+        edit_plan plan_edits(const file_io::byte_source& source, edit_context& ctx,
+                             const std::vector<unsigned char>& extra_user_data) {
+            edit_plan plan;
+            mp4_boxes::walk(source, 0, source.size(), [&](const mp4_boxes::box& b) {
+                plan.boxes.push_back(b);
+                const std::size_t removed_before = ctx.removed;
+                box_edit edit;
+                edit.original = b;
+
+                if (b.type == "moov") {
+                    std::vector<unsigned char> moov;
+                    mp4_boxes::append_range(moov, source, b.offset, b.size);
+                    const file_io::memory_source moov_source(moov.data(), moov.size());
+                    mp4_boxes::box local = b;
+                    local.offset = 0;
+
+                    ctx.chunk_tables.clear();
+                    rebuild_container(moov_source, local, "", edit.data, ctx,
+                                      extra_user_data.empty() ? nullptr : &extra_user_data);
+                    edit.chunk_tables = std::move(ctx.chunk_tables);
+                    ctx.chunk_tables.clear();
+                    edit.changed = ctx.removed != removed_before || !extra_user_data.empty();
+                    plan.edits.push_back(std::move(edit));
+                } else if (b.type == "udta" || b.type == "meta" || is_xmp_uuid(source, b)) {
+                    rebuild_box(source, b, "", edit.data, ctx);
+                    edit.changed = ctx.removed != removed_before;
+                    if (edit.changed) {
+                        plan.edits.push_back(std::move(edit));
+                    }
+                }
+            });
+            return plan;
+        }
+
+        /**
+         * @brief Add a shift to every entry of a stco or co64 box
+         * @param data Rebuilt box holding the table
+         * @param at Offset of the table box in data
+         * @param shift_of Shift for a chunk at a given offset of the input
+         */
+        void shift_chunk_offsets(std::vector<unsigned char>& data, std::size_t at,
+                                 const std::function<std::int64_t(std::uint64_t)>& shift_of) {
+            const std::uint32_t size32 = mp4_boxes::get32(&data[at]);
+            const std::size_t header_size = size32 == 1 ? 16 : 8;
+            const std::uint64_t box_size = size32 == 1 ? mp4_boxes::get64(&data[at + 8]) : size32;
+            const bool wide = std::memcmp(&data[at + 4], "co64", 4) == 0;
+            const std::size_t width = wide ? 8 : 4;
+            if (box_size < header_size + 8) {
+                return;
+            }
+
+            unsigned char* table = &data[at + header_size];
+            const std::uint32_t count = mp4_boxes::get32(table + 4);
+            if ((box_size - header_size - 8) / width < count) {
+                throw std::runtime_error("Truncated chunk offset table");
+            }
+
+            for (std::uint32_t i = 0; i < count; i++) {
+                unsigned char* field = table + 8 + static_cast<std::size_t>(i) * width;
+                const std::uint64_t offset = wide ? mp4_boxes::get64(field) : mp4_boxes::get32(field);
+                const std::uint64_t moved = offset + static_cast<std::uint64_t>(shift_of(offset));
+                if (wide) {
+                    mp4_boxes::put64(field, moved);
+                } else if (moved > std::numeric_limits<std::uint32_t>::max()) {
+                    throw std::runtime_error("Chunk offsets no longer fit the stco table");
+                } else {
+                    mp4_boxes::put32(field, static_cast<std::uint32_t>(moved));
+                }
+            }
+        }
+
+    }
+
+    mp4_processor_class::mp4_processor_class(const std::string& path,
+                                             file_handler::operation_type type,
+                                             file_handler::shared_options opts,
+                                             file_properties::file_type_probe probe,
+                                             file_handler::buffer_binding buffers)
+            : file_handler_class(path, type, std::move(opts), std::move(probe), buffers) {}
+
+    mp4_processor_class::~mp4_processor_class() = default;
+
+    file_handler::operation_result mp4_processor_class::check_prerequisites() {
+        // The header was read once when the file type was probed
+        if (file_header.size() < 8) {
+            return {false, "Failed to read file header", {}, {}};
+        }
+        // Old QuickTime files start with moov, mdat or padding instead of ftyp
+        const std::string first(reinterpret_cast<const char*>(file_header.data()) + 4, 4);
+        if (first != "ftyp" && first != "moov" && first != "mdat" && first != "free" &&
+            first != "skip" && first != "wide" && first != "pnot") {
+            return {false, "File is not a valid MP4 or MOV file", {}, {}};
+        }
+        return {true, "MP4 file is valid", {}, {}};
+    }
+
+    file_handler::operation_result mp4_processor_class::read_metadata() {
+        file_handler::operation_result result;
+        result.success = true;
+        result.message = "Metadata successfully read";
+
+        try {
+            auto in = open_input();
+            edit_context ctx;
+            ctx.found = &result.metadata;
+            ctx.warnings = &result.warnings;
+            const auto plan = plan_edits(*in, ctx, {});
+
+            if (std::none_of(plan.boxes.begin(), plan.boxes.end(),
+                             [](const mp4_boxes::box& b) { return b.type == "moov"; })) {
+                result.warnings.push_back("No moov box found");
+            }
+
+            result.metadata.set("Total.UserData", std::to_string(ctx.user_data_count));
+            result.metadata.set("Total.Items", std::to_string(ctx.item_count));
+            result.metadata.set("Total.XMP", std::to_string(ctx.xmp_count));
+
+        } catch (const Exiv2::Error& e) {
+            result.success = false;
+            result.message = "Failed to read metadata: " + std::string(e.what());
+        } catch (const std::exception& e) {
+            result.success = false;
+            result.message = "Exception: " + std::string(e.what());
+        }
+
+        return result;
+    }
+
+    void mp4_processor_class::rewrite(const std::function<bool(const std::string&)>& drop,
+                                      const std::vector<unsigned char>& extra_user_data,
+                                      std::vector<std::string>& warnings) const {
+        auto in = open_input();
+        edit_context ctx;
+        ctx.drop = drop;
+        ctx.drop_all = !drop;
+        ctx.warnings = &warnings;
+        auto plan = plan_edits(*in, ctx, extra_user_data);
+
+        if (!extra_user_data.empty() && plan.edits.empty()) {
+            throw std::runtime_error("No moov box found");
+        }
+        commit_edits(std::move(in), plan.boxes, plan.edits);
+    }
+
+    void mp4_processor_class::commit_edits(std::unique_ptr<file_io::byte_source> source,
+                                           const std::vector<mp4_boxes::box>& boxes,
+                                           std::vector<box_edit>& edits) const {
+        const bool in_place = !in_memory() && get_output_path() == std::filesystem::path(file_path);
+        const bool changed = std::any_of(edits.begin(), edits.end(), [](const box_edit& e) { return e.changed; });
+        if (!changed && in_place) {
+            return;
+        }
+
+        std::uint64_t media_end = 0;
+        bool fragmented = false;
+        for (const auto& b : boxes) {
+            if (b.type == "mdat") {
+                media_end = std::max(media_end, b.end());
+            }
+            fragmented = fragmented || b.type == "moof";
+        }
+
+        // Space a rebuilt box may take in place, a free box right after it is reused as padding
+        const auto space_of = [&boxes](const box_edit& e) {
+            const auto next = std::find_if(boxes.begin(), boxes.end(),
+                                           [&e](const mp4_boxes::box& b) { return b.offset == e.original.end(); });
+            const bool padding_follows = next != boxes.end() && (next->type == "free" || next->type == "skip");
+            return e.original.size + (padding_follows ? next->size : 0);
+        };
+
+        std::uint64_t first_changed = std::numeric_limits<std::uint64_t>::max();
+        bool fits = true;
+        for (const auto& e : edits) {
+            if (!e.changed) {
+                continue;
+            }
+            first_changed = std::min(first_changed, e.original.offset);
+            const std::uint64_t space = space_of(e);
+            fits = fits && e.data.size() <= space && (e.data.size() == space || space - e.data.size() >= 8);
+        }
+
+        const auto find_edit = [&edits](const mp4_boxes::box& b) -> box_edit* {
+            for (auto& e : edits) {
+                if (e.original.offset == b.offset) {
+                    return &e;
+                }
+            }
+            return nullptr;
+        };
+
+        // Nothing before the end of the media data changes: cut the file there and append the new boxes
+        if (changed && first_changed >= media_end) {
+            std::vector<unsigned char> tail;
+            for (const auto& b : boxes) {
+                if (b.offset < first_changed) {
+                    continue;
+                }
+                const box_edit* e = find_edit(b);
+                if (e != nullptr && e->changed) {
+                    tail.insert(tail.end(), e->data.begin(), e->data.end());
+                } else {
+                    mp4_boxes::append_range(tail, *source, b.offset, b.size);
+                }
+            }
+            source.reset();
+            commit_tail(first_changed, tail);
+            return;
+        }
+
+        // Boxes that did not grow are padded to their old size, so no chunk moves
+        if (changed && fits && (in_place || fragmented)) {
+            std::vector<file_io::byte_patch> patches;
+            for (auto& e : edits) {
+                if (!e.changed) {
+                    continue;
+                }
+                const std::uint64_t space = space_of(e);
+                file_io::byte_patch patch {e.original.offset, std::move(e.data)};
+                if (patch.data.size() < space) {
+                    mp4_boxes::append_free(patch.data, space - patch.data.size());
+                }
+                patches.push_back(std::move(patch));
+            }
+            source.reset();
+            commit_patches(patches);
+            return;
+        }
+        if (changed && fragmented) {
+            throw std::runtime_error("Metadata before the media data of a fragmented file cannot grow");
+        }
+
+        // Copy the file and move every chunk by the size difference of the boxes before it
+        std::vector<std::pair<std::uint64_t, std::int64_t>> shifts;
+        std::int64_t delta = 0;
+        for (const auto& b : boxes) {
+            shifts.emplace_back(b.offset, delta);
+            if (const box_edit* e = find_edit(b)) {
+                delta += static_cast<std::int64_t>(e->data.size()) - static_cast<std::int64_t>(b.size);
+            }
+        }
+        const auto shift_of = [&shifts](std::uint64_t offset) -> std::int64_t {
+            auto it = std::upper_bound(shifts.begin(), shifts.end(), offset,
+                                       [](std::uint64_t value, const std::pair<std::uint64_t, std::int64_t>& shift) {
+                                           return value < shift.first;
+                                       });
+            return it == shifts.begin() ? 0 : std::prev(it)->second;
+        };
+        if (std::any_of(shifts.begin(), shifts.end(), [](const auto& shift) { return shift.second != 0; })) {
+            for (auto& e : edits) {
+                for (const std::size_t at : e.chunk_tables) {
+                    shift_chunk_offsets(e.data, at, shift_of);
+                }
+            }
+        }
+
+        auto out = open_output();
+        for (const auto& b : boxes) {
+            if (const box_edit* e = find_edit(b)) {
+                out->write(e->data.data(), e->data.size());
+            } else {
+                out->copy_from(*source, b.offset, b.size);
+            }
+        }
+        source.reset();
+        out->commit();
+    }
+
+    /**
+     * @brief Remove the udta, meta and XMP boxes and the movie times
+     *
+     * With selected properties only the matching atoms, items and XMP
+     * properties are removed, boxes left empty are dropped.
+     */
+    file_handler::operation_result mp4_processor_class::clean_metadata() {
+        file_handler::operation_result result;
+        result.success = true;
+        result.message = has_selection() ? "Selected metadata successfully removed" : "Metadata successfully cleaned";
+
+        try {
+            std::function<bool(const std::string&)> drop;
+            if (has_selection()) {
+                drop = [this](const std::string& key) { return is_selected(key); };
+            }
+            rewrite(drop, {}, result.warnings);
+
+        } catch (const Exiv2::Error& e) {
+            result.success = false;
+            result.message = "Failed to clean metadata: " + std::string(e.what());
+            std::cerr << "Exiv2 error: " << e.what() << std::endl;
+        } catch (const std::exception& e) {
+            result.success = false;
+            result.message = "Failed to clean metadata: " + std::string(e.what());
+            std::cerr << "Standard exception: " << e.what() << std::endl;
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief Replace all metadata with a udta box holding the values from the options
+     *
+     * "UserData.<atom>" keys and the common fields become QuickTime text
+     * atoms, "XMP." keys an XMP_ atom.
+     */
+    file_handler::operation_result mp4_processor_class::overwrite_metadata() {
+        file_handler::operation_result result;
+        result.success = true;
+        result.message = "Metadata successfully overwritten";
+
+        try {
+            static const std::pair<const char*, const char*> common_atoms[] = {
+                {"Title", "\xA9nam"}, {"Author", "\xA9" "aut"}, {"Description", "\xA9" "des"},
+                {"Copyright", "\xA9" "cpy"}, {"Software", "\xA9swr"}, {"Comment", "\xA9" "cmt"},
+                {"DateCreated", "\xA9" "day"}, {"Location", "\xA9xyz"}
+            };
+
+            std::vector<std::pair<std::string, std::string>> atoms;
+            Exiv2::XmpData xmp_data;
+            for (const auto& [key, value] : options.overwrite_metadata) {
+                if (key.empty() || value.empty()) {
+                    continue;
+                }
+
+                const auto common = std::find_if(std::begin(common_atoms), std::end(common_atoms),
+                                                 [&key](const auto& atom) { return key == atom.first; });
+                if (key.compare(0, 9, "UserData.") == 0 && atom_type(key.substr(9)).size() == 4) {
+                    atoms.emplace_back(atom_type(key.substr(9)), value);
+                } else if (key.compare(0, 4, "XMP.") == 0) {
+                    xmp_data[key.substr(4)] = value;
+                } else if (common != std::end(common_atoms)) {
+                    atoms.emplace_back(common->second, value);
+                } else {
+                    result.warnings.push_back("Unsupported metadata key for MP4: " + key);
+                }
+            }
+
+            std::vector<unsigned char> user_data;
+            if (!atoms.empty() || !xmp_data.empty()) {
+                mp4_boxes::append_header(user_data, "udta", 0);
+                for (const auto& [type, value] : atoms) {
+                    if (static_cast<unsigned char>(type[0]) == 0xA9 && value.size() <= 0xFFFF) {
+                        // Text atom with one entry, language code 0x55C4 is "und"
+                        const unsigned char entry[4] = {static_cast<unsigned char>(value.size() >> 8),
+                                                        static_cast<unsigned char>(value.size()), 0x55, 0xC4};
+                        mp4_boxes::append_header(user_data, type, sizeof(entry) + value.size());
+                        user_data.insert(user_data.end(), entry, entry + sizeof(entry));
+                    } else {
+                        mp4_boxes::append_header(user_data, type, value.size());
+                    }
+                    user_data.insert(user_data.end(), value.begin(), value.end());
+                }
+                if (!xmp_data.empty()) {
+                    std::string packet;
+                    if (Exiv2::XmpParser::encode(packet, xmp_data) != 0) {
+                        throw std::runtime_error("Failed to encode XMP packet");
+                    }
+                    mp4_boxes::append_header(user_data, "XMP_", packet.size());
+                    user_data.insert(user_data.end(), packet.begin(), packet.end());
+                }
+                finish_box(user_data, 0);
+            }
+
+            rewrite(nullptr, user_data, result.warnings);
+
+        } catch (const Exiv2::Error& e) {
+            result.success = false;
+            result.message = "Failed to overwrite metadata: " + std::string(e.what());
+            std::cerr << "Exiv2 error: " << e.what() << std::endl;
+        } catch (const std::exception& e) {
+            result.success = false;
+            result.message = "Failed to overwrite metadata: " + std::string(e.what());
+            std::cerr << "Standard exception: " << e.what() << std::endl;
+        }
+
+        return result;
+    }
+
+    file_handler::operation_result mp4_processor_class::export_metadata() {
+        // First read the metadata
+        auto result = read_metadata();
+        if (!result.success) {
+            return result;
+        }
+
+        try {
+            // Create output directory if needed
+            if (!options.output_directory.empty() && !std::filesystem::exists(options.output_directory)) {
+                std::filesystem::create_directories(options.output_directory);
+            }
+
+            // Create output file path
+            std::filesystem::path output_path;
+            if (options.output_directory.empty()) {
+                output_path = std::filesystem::path(file_path).parent_path() /
+                             (std::filesystem::path(file_path).stem().string() + "_metadata.json");
+            } else {
+                output_path = options.output_directory /
+                             (std::filesystem::path(file_path).stem().string() + "_metadata.json");
+            }
+
+            // Write to output file
+            std::ofstream out(output_path);
+            if (!out) {
+                result.success = false;
+                result.message = "Failed to create output file: " + output_path.string();
+                return result;
+            }
+
+            // Write in JSON format
+            out << "{\n";
+            bool first = true;
+            for (const auto& [key, value] : result.metadata) {
+                if (!first) out << ",\n";
+                // Escape JSON special characters in the value
+                std::string escaped_value(value);
+                size_t pos = 0;
+                while ((pos = escaped_value.find("\"", pos)) != std::string::npos) {
+                    escaped_value.replace(pos, 1, "\\\"");
+                    pos += 2;
+                }
+                out << "  \"" << key << "\": \"" << escaped_value << "\"";
+                first = false;
+            }
+            out << "\n}";
+
+            out.close();
+
+            result.message = "Metadata successfully exported to: " + output_path.string();
+
+        } catch (const std::exception& e) {
+            result.success = false;
+            result.message = "Failed to export metadata: " + std::string(e.what());
+        }
+
+        return result;
+    }
+
+    file_handler::operation_result mp4_processor_class::restore_metadata() {
+        file_handler::operation_result result;
+        result.success = false;
+        result.message = "Restore operation not implemented for MP4";
+
+        return result;
+    }
+
+}
@@ -0,0 +1,358 @@
+/**
+ * @file ooxml_package.cpp
+ * @brief Implementation of OOXML package access
+ */
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include <pugixml.hpp>
+#include "./processors/ooxml_package.h"
+
+namespace ooxml_package {
+
+    namespace {
+
+        const std::string content_types_part = "[Content_Types].xml";
+        const std::string package_relationships_part = "_rels/.rels";
+
+        std::string lower(std::string text) {
+            std::transform(text.begin(), text.end(), text.begin(),
+                           [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+            return text;
+        }
+
+        bool ends_with(const std::string& text, const std::string& suffix) {
+            return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+        }
+
+        /**
+         * @brief Get the relationship part of a part, "word/document.xml" has "word/_rels/document.xml.rels"
+         */
+        std::string relationships_of(const std::string& part_name) {
+            const auto slash = part_name.rfind('/');
+            const std::string directory = slash == std::string::npos ? "" : part_name.substr(0, slash + 1);
+            const std::string file = slash == std::string::npos ? part_name : part_name.substr(slash + 1);
+            return directory + "_rels/" + file + ".rels";
+        }
+
+        std::string save(const pugi::xml_document& document) {
+            std::stringstream stream;
+            document.save(stream);
+            return stream.str();
+        }
+
+    }
+
+    std::string resolve_target(const std::string& relationships_part, const std::string& target) {
+        std::string path;
+        if (!target.empty() && target[0] == '/') {
+            path = target.substr(1);
+        } else {
+            // "dir/_rels/x.rels" describes "dir/x", relative targets start from "dir/"
+            const auto rels = relationships_part.rfind("_rels/");
+            path = (rels == std::string::npos ? std::string() : relationships_part.substr(0, rels)) + target;
+        }
+
+        std::vector<std::string> segments;
+        std::size_t begin = 0;
+        while (begin <= path.size()) {
+            const auto end = std::min(path.find('/', begin), path.size());
+            const std::string segment = path.substr(begin, end - begin);
+            if (segment == "..") {
+                if (!segments.empty()) {
+                    segments.pop_back();
+                }
+            } else if (!segment.empty() && segment != ".") {
+                segments.push_back(segment);
+            }
+            begin = end + 1;
+        }
+
+        std::string resolved;
+        for (const auto& segment : segments) {
+            if (!resolved.empty()) {
+                resolved += '/';
+            }
+            resolved += segment;
+        }
+        return resolved;
+    }
+
+    package_class::~package_class() {
+        close();
+    }
+
+    bool package_class::open(std::unique_ptr<file_io::byte_source> data) {
+        close();
+        input = std::move(data);
+
+        zip_error_t error;
+        zip_error_init(&error);
+        zip_source_t* source = zip_source_buffer_create(input->get_data(), input->size(), 0, &error);
+        if (!source) {
+            std::cerr << "Failed to create ZIP source: " << zip_error_strerror(&error) << std::endl;
+            zip_error_fini(&error);
+            input.reset();
+            return false;
+        }
+
+        archive = zip_open_from_source(source, 0, &error);
+        if (!archive) {
+            std::cerr << "Failed to open ZIP archive: " << zip_error_strerror(&error) << std::endl;
+            zip_error_fini(&error);
+            zip_source_free(source);
+            input.reset();
+            return false;
+        }
+        zip_error_fini(&error);
+
+        // Rewrites copy entries by their raw location, which libzip does not expose
+        try {
+            directory = zip_entries::read_directory(*input);
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to read ZIP central directory: " << e.what() << std::endl;
+            close();
+            return false;
+        }
+
+        // Index the central directory once so part lookups do not scan it again
+        const zip_int64_t num_entries = zip_get_num_entries(archive, 0);
+        entry_index.reserve(static_cast<size_t>(num_entries));
+        entry_names.reserve(static_cast<size_t>(num_entries));
+        for (zip_int64_t i = 0; i < num_entries; i++) {
+            const char* name = zip_get_name(archive, static_cast<zip_uint64_t>(i), 0);
+            if (name) {
+                entry_index.emplace(name, static_cast<zip_uint64_t>(i));
+                entry_names.emplace_back(name);
+            }
+        }
+
+        // Content types decide what a part is, whatever path the format gives it
+        std::string content;
+        pugi::xml_document types;
+        if (!read_part(content_types_part, content) || !types.load_string(content.c_str())) {
+            std::cerr << "Failed to read " << content_types_part << std::endl;
+            close();
+            return false;
+        }
+        for (pugi::xml_node node : types.document_element().children()) {
+            const std::string name = node.name();
+            if (name == "Default") {
+                defaults[lower(node.attribute("Extension").value())] = node.attribute("ContentType").value();
+            } else if (name == "Override") {
+                std::string part_name = node.attribute("PartName").value();
+                if (!part_name.empty() && part_name[0] == '/') {
+                    part_name.erase(0, 1);
+                }
+                overrides[part_name] = node.attribute("ContentType").value();
+            }
+        }
+
+        return true;
+    }
+
+    void package_class::close() {
+        if (archive) {
+            zip_discard(archive);
+            archive = nullptr;
+        }
+        input.reset();
+        directory.clear();
+        entry_index.clear();
+        entry_names.clear();
+        overrides.clear();
+        defaults.clear();
+    }
+
+    bool package_class::read_part(const std::string& part_name, std::string& content) const {
+        content.clear();
+        if (!archive) {
+            return false;
+        }
+
+        const auto entry = entry_index.find(part_name);
+        if (entry == entry_index.end()) {
+            return false;
+        }
+
+        // Stored and deflated parts are inflated straight from the input, so reads do not queue on libzip
+        if (entry->second < directory.size() && directory[entry->second].name == part_name &&
+            zip_entries::can_read(directory[entry->second])) {
+            try {
+                content = zip_entries::read_entry(*input, directory[entry->second]);
+            } catch (const std::exception& e) {
+                std::cerr << "Failed to read file in archive: " << part_name << ", " << e.what() << std::endl;
+                content.clear();
+                return false;
+            }
+            return !content.empty();
+        }
+
+        std::lock_guard<std::mutex> lock(read_mutex);
+        zip_file* file = zip_fopen_index(archive, entry->second, 0);
+        if (!file) {
+            std::cerr << "Failed to open file in archive: " << part_name << std::endl;
+            return false;
+        }
+
+        // Size the output from the central directory entry
+        zip_stat_t stat;
+        zip_stat_init(&stat);
+        if (zip_stat_index(archive, entry->second, 0, &stat) == 0 && (stat.valid & ZIP_STAT_SIZE)) {
+            content.reserve(static_cast<size_t>(stat.size));
+        }
+
+        const int buffer_size = 8192;
+        char buffer[buffer_size];
+        zip_int64_t bytes_read;
+        while ((bytes_read = zip_fread(file, buffer, buffer_size)) > 0) {
+            content.append(buffer, bytes_read);
+        }
+
+        zip_fclose(file);
+
+        return bytes_read == 0 && !content.empty();
+    }
+
+    std::string package_class::content_type(const std::string& part_name) const {
+        if (const auto it = overrides.find(part_name); it != overrides.end()) {
+            return it->second;
+        }
+        const auto dot = part_name.rfind('.');
+        if (dot != std::string::npos && part_name.find('/', dot) == std::string::npos) {
+            if (const auto it = defaults.find(lower(part_name.substr(dot + 1))); it != defaults.end()) {
+                return it->second;
+            }
+        }
+        return {};
+    }
+
+    std::vector<std::string> package_class::parts_of_type(const std::string& type) const {
+        std::vector<std::string> parts;
+        for (const auto& name : entry_names) {
+            if (content_type(name) == type) {
+                parts.push_back(name);
+            }
+        }
+        return parts;
+    }
+
+    std::vector<std::string> package_class::package_relationships(const std::string& type) const {
+        std::vector<std::string> targets;
+        std::string content;
+        pugi::xml_document relationships;
+        if (!read_part(package_relationships_part, content) || !relationships.load_string(content.c_str())) {
+            return targets;
+        }
+        for (pugi::xml_node node : relationships.document_element().children("Relationship")) {
+            if (type == node.attribute("Type").value() &&
+                std::string(node.attribute("TargetMode").value()) != "External") {
+                const std::string part = resolve_target(package_relationships_part, node.attribute("Target").value());
+                if (has_part(part)) {
+                    targets.push_back(part);
+                }
+            }
+        }
+        return targets;
+    }
+
+    void package_class::remove_parts(package_edit& edit, const std::set<std::string>& part_names) const {
+        if (part_names.empty()) {
+            return;
+        }
+
+        std::set<std::string> removed;
+        for (const auto& part_name : part_names) {
+            if (has_part(part_name)) {
+                edit.remove_part(part_name);
+                removed.insert(part_name);
+            }
+            // The relationships of a removed part go with it
+            const std::string own_relationships = relationships_of(part_name);
+            if (has_part(own_relationships)) {
+                edit.remove_part(own_relationships);
+                removed.insert(own_relationships);
+            }
+        }
+
+        std::string content;
+        pugi::xml_document types;
+        if (read_part(content_types_part, content) && types.load_string(content.c_str())) {
+            std::vector<pugi::xml_node> stale;
+            for (pugi::xml_node node : types.document_element().children("Override")) {
+                std::string part_name = node.attribute("PartName").value();
+                if (!part_name.empty() && part_name[0] == '/') {
+                    part_name.erase(0, 1);
+                }
+                if (part_names.count(part_name) > 0) {
+                    stale.push_back(node);
+                }
+            }
+            for (pugi::xml_node node : stale) {
+                types.document_element().remove_child(node);
+            }
+            if (!stale.empty()) {
+                edit.replace_part(content_types_part, save(types));
+            }
+        }
+
+        // Relationship parts are small, each one is checked for targets that are gone
+        for (const auto& name : entry_names) {
+            if (!ends_with(name, ".rels") || removed.count(name) > 0) {
+                continue;
+            }
+            pugi::xml_document relationships;
+            if (!read_part(name, content) || !relationships.load_string(content.c_str())) {
+                continue;
+            }
+            std::vector<pugi::xml_node> stale;
+            for (pugi::xml_node node : relationships.document_element().children("Relationship")) {
+                if (std::string(node.attribute("TargetMode").value()) != "External" &&
+                    part_names.count(resolve_target(name, node.attribute("Target").value())) > 0) {
+                    stale.push_back(node);
+                }
+            }
+            for (pugi::xml_node node : stale) {
+                relationships.document_element().remove_child(node);
+            }
+            if (!stale.empty()) {
+                edit.replace_part(name, save(relationships));
+            }
+        }
+    }
+
+    void package_class::write_to(file_io::byte_sink& out, const package_edit& edit,
+                                 const zip_entries::write_options& options) {
+        if (!archive) {
+            throw std::runtime_error("Package archive is not open");
+        }
+
+        try {
+            if (edit.empty()) {
+                out.copy_from(*input, 0, input->size());
+            } else {
+                zip_entries::rewrite(*input, directory, edit.get_replacements(), edit.get_removals(), out, options);
+            }
+        } catch (...) {
+            close();
+            throw;
+        }
+
+        // The mapping has to be released before the file is replaced
+        close();
+    }
+
+    void package_edit::replace_part(const std::string& part_name, std::string content) {
+        removals.erase(part_name);
+        replacements[part_name] = std::move(content);
+    }
+
+    void package_edit::remove_part(const std::string& part_name) {
+        replacements.erase(part_name);
+        removals.insert(part_name);
+    }
+
+}
@@ -0,0 +1,797 @@
+/**
+ * @file ooxml_processor.cpp
+ * @brief Implementation of the shared OOXML processor
+ */
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <utility>
+#include "./base/thread_pool.h"
+#include "./processors/jpeg_segments.h"
+#include "./processors/ooxml_processor.h"
+#include "./processors/png_chunks.h"
+
+namespace ooxml_processor {
+
+    namespace {
+
+        const std::string comment_authors_key = "Comments.Authors";
+        const std::string thumbnail_key = "Package.Thumbnail";
+
+        /**
+         * @brief Break a time down to UTC without the shared buffer of std::gmtime, batches run in parallel
+         */
+        std::tm utc_time(std::time_t time) {
+            std::tm tm_utc {};
+#ifdef _WIN32
+            gmtime_s(&tm_utc, &time);
+#else
+            gmtime_r(&time, &tm_utc);
+#endif
+            return tm_utc;
+        }
+
+        /**
+         * @brief Part naming people, with the element and attributes that hold who they are
+         */
+        struct people_part {
+            const char* content_type;
+            const char* element;                        // local name, without the namespace prefix
+            std::vector<std::string> attributes;        // local names, the first one is the display name
+            bool removable;                             // optional part, removed as a whole
+        };
+
+        // Empty attribute lists mean the name is the text of the element
+        const people_part people_parts[] = {
+            {"application/vnd.openxmlformats-officedocument.wordprocessingml.comments+xml",
+             "comment", {"author", "initials"}, false},
+            {"application/vnd.openxmlformats-officedocument.wordprocessingml.people+xml",
+             "person", {"author"}, true},
+            {"application/vnd.openxmlformats-officedocument.spreadsheetml.comments+xml",
+             "author", {}, false},
+            {"application/vnd.ms-excel.person+xml",
+             "person", {"displayName", "userId", "providerId"}, false},
+            {"application/vnd.openxmlformats-officedocument.presentationml.commentAuthors+xml",
+             "cmAuthor", {"name", "initials"}, false},
+            {"application/vnd.ms-powerpoint.authors+xml",
+             "author", {"name", "initials", "userId", "providerId"}, false}
+        };
+
+        // Embedded images handled by the standalone stripping engines
+        const char* const image_types[] = {"image/jpeg", "image/png"};
+
+        /**
+         * @brief Sink collecting output in a string, the form package_edit takes parts in
+         */
+        class string_sink : public file_io::byte_sink {
+        public:
+            void write(const void* data, std::size_t length) override {
+                content.append(static_cast<const char*>(data), length);
+            }
+
+            std::string content;
+        };
+
+        /**
+         * @brief Image part after stripping
+         */
+        struct scrubbed_image {
+            std::string content;
+            std::size_t removed {0};
+            std::string error;
+            std::vector<std::string> warnings;
+        };
+
+        const char* local_name(const char* name) {
+            const char* colon = std::strchr(name, ':');
+            return colon != nullptr ? colon + 1 : name;
+        }
+
+        std::string save(const pugi::xml_document& document) {
+            std::stringstream stream;
+            document.save(stream);
+            return stream.str();
+        }
+
+        bool load(const ooxml_package::package_class& package, const std::string& part_name,
+                  pugi::xml_document& document) {
+            std::string content;
+            return package.read_part(part_name, content) && document.load_string(content.c_str());
+        }
+
+        /**
+         * @brief Call visit for every element of the part that names a person
+         */
+        void for_each_person(pugi::xml_node node, const people_part& part,
+                             const std::function<void(pugi::xml_node)>& visit) {
+            for (pugi::xml_node child : node.children()) {
+                if (child.type() != pugi::node_element) {
+                    continue;
+                }
+                if (std::strcmp(local_name(child.name()), part.element) == 0) {
+                    visit(child);
+                }
+                for_each_person(child, part, visit);
+            }
+        }
+
+        /**
+         * @brief Find an attribute by its local name
+         */
+        pugi::xml_attribute find_attribute(pugi::xml_node node, const std::string& name) {
+            for (pugi::xml_attribute attribute : node.attributes()) {
+                if (name == local_name(attribute.name())) {
+                    return attribute;
+                }
+            }
+            return {};
+        }
+
+        /**
+         * @brief Create an empty core properties document
+         * @return Root element of the properties
+         */
+        pugi::xml_node new_core_properties(pugi::xml_document& document) {
+            pugi::xml_node decl = document.append_child(pugi::node_declaration);
+            decl.append_attribute("version") = "1.0";
+            decl.append_attribute("encoding") = "UTF-8";
+            decl.append_attribute("standalone") = "yes";
+
+            pugi::xml_node props = document.append_child("cp:coreProperties");
+            // Add necessary namespaces
+            props.append_attribute("xmlns:cp") = "http://schemas.openxmlformats.org/package/2006/metadata/core-properties";
+            props.append_attribute("xmlns:dc") = "http://purl.org/dc/elements/1.1/";
+            props.append_attribute("xmlns:dcterms") = "http://purl.org/dc/terms/";
+            props.append_attribute("xmlns:dcmitype") = "http://purl.org/dc/dcmitype/";
+            props.append_attribute("xmlns:xsi") = "http://www.w3.org/2001/XMLSchema-instance";
+            return props;
+        }
+
+        /**
+         * @brief Create an empty extended properties document
+         * @return Root element of the properties
+         */
+        pugi::xml_node new_extended_properties(pugi::xml_document& document) {
+            pugi::xml_node decl = document.append_child(pugi::node_declaration);
+            decl.append_attribute("version") = "1.0";
+            decl.append_attribute("encoding") = "UTF-8";
+            decl.append_attribute("standalone") = "yes";
+
+            pugi::xml_node props = document.append_child("Properties");
+            props.append_attribute("xmlns") = "http://schemas.openxmlformats.org/officeDocument/2006/extended-properties";
+            props.append_attribute("xmlns:vt") = "http://schemas.openxmlformats.org/officeDocument/2006/docPropsVTypes";
+            return props;
+        }
+
+    }
+
+    ooxml_processor_class::ooxml_processor_class(const std::string& path,
+                                                 file_handler::operation_type type,
+                                                 file_handler::shared_options opts,
+                                                 file_properties::file_type_probe probe,
+                                                 file_handler::buffer_binding buffers)
+            : file_handler_class(path, type, std::move(opts), std::move(probe), buffers), package_loaded(false) {
+        try {
+            // Initialize XML documents
+            core_xml = std::make_unique<pugi::xml_document>();
+            app_xml = std::make_unique<pugi::xml_document>();
+
+            // libzip reads the archive from a shared read-only mapping instead of its own file buffers
+            if (!package.open(map_input())) {
+                return;
+            }
+
+            // The property parts are found by content type, packages without them are still valid
+            const auto core_parts = package.parts_of_type(ooxml_package::content_type::CORE_PROPERTIES);
+            const auto app_parts = package.parts_of_type(ooxml_package::content_type::EXTENDED_PROPERTIES);
+            core_part = core_parts.empty() ? std::string() : core_parts.front();
+            app_part = app_parts.empty() ? std::string() : app_parts.front();
+
+            const bool core_ok = core_part.empty() || load(package, core_part, *core_xml);
+            const bool app_ok = app_part.empty() || load(package, app_part, *app_xml);
+            if (core_ok && app_ok) {
+                package_loaded = true;
+            } else {
+                std::cerr << "Failed to parse XML: " << (core_ok ? app_part : core_part) << std::endl;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Exception in ooxml_processor constructor: " << e.what() << std::endl;
+        }
+    }
+
+    ooxml_processor_class::~ooxml_processor_class() {
+        package.close();
+    }
+
+    file_handler::operation_result ooxml_processor_class::check_prerequisites() {
+        // The header was read once when the file type was probed
+        if (file_header.empty()) {
+            return {false, "Failed to open file", {}, {}};
+        }
+
+        // Check if it's a ZIP file (PK signature)
+        if (file_header.size() >= 4 && file_header[0] == 'P' && file_header[1] == 'K' &&
+            file_header[2] == 0x03 && file_header[3] == 0x04) {
+
+            // The main part decides the format, whatever the file is called
+            for (const auto& type : main_content_types()) {
+                if (!package.parts_of_type(type).empty()) {
+                    return {true, std::string(format_name()) + " file is valid", {}, {}};
+                }
+            }
+            return {false, std::string("File is a ZIP but not a valid ") + format_name(), {}, {}};
+        }
+
+        return {false, std::string("File is not a valid ") + format_name(), {}, {}};
+    }
+
+    file_handler::operation_result ooxml_processor_class::read_metadata() {
+        file_handler::operation_result result;
+        result.success = true;
+        result.message = "Metadata successfully read";
+
+        try {
+            if (!package_loaded) {
+                result.success = false;
+                result.message = std::string(format_name()) + " document not properly loaded";
+                return result;
+            }
+
+            // Read core and app properties
+            const auto read_properties = [&result](const pugi::xml_document& document, const char* prefix) {
+                int count = 0;
+                for (pugi::xml_node node : document.document_element().children()) {
+                    const std::string_view key = node.name();
+                    const std::string_view value = node.text().get();
+                    if (!key.empty()) {
+                        count++;
+                    }
+                    if (!key.empty() && !value.empty()) {
+                        result.metadata.set(prefix, key, value);
+                    }
+                }
+                return count;
+            };
+            const int core_count = read_properties(*core_xml, "Core.");
+            const int app_count = read_properties(*app_xml, "App.");
+
+            // Custom properties hold their value in a single typed child
+            int custom_count = 0;
+            for (const auto& part : package.parts_of_type(ooxml_package::content_type::CUSTOM_PROPERTIES)) {
+                pugi::xml_document custom;
+                if (!load(package, part, custom)) {
+                    result.warnings.push_back("Failed to parse XML: " + part);
+                    continue;
+                }
+                for (pugi::xml_node node : custom.document_element().children()) {
+                    const std::string_view name = node.attribute("name").value();
+                    if (!name.empty()) {
+                        result.metadata.set("Custom.", name, node.first_child().text().get());
+                        custom_count++;
+                    }
+                }
+            }
+
+            // Comment authors and people, each name listed once
+            std::vector<std::string> authors;
+            std::set<std::string> seen;
+            for (const auto& people : people_parts) {
+                for (const auto& part : package.parts_of_type(people.content_type)) {
+                    pugi::xml_document document;
+                    if (!load(package, part, document)) {
+                        result.warnings.push_back("Failed to parse XML: " + part);
+                        continue;
+                    }
+                    for_each_person(document, people, [&](pugi::xml_node node) {
+                        const std::string name = people.attributes.empty()
+                            ? node.text().get()
+                            : find_attribute(node, people.attributes.front()).value();
+                        if (!name.empty() && seen.insert(name).second) {
+                            authors.push_back(name);
+                        }
+                    });
+                }
+            }
+            if (!authors.empty()) {
+                std::string joined;
+                for (const auto& name : authors) {
+                    joined += (joined.empty() ? "" : "; ") + name;
+                }
+                result.metadata.set(comment_authors_key, joined);
+            }
+
+            const auto thumbnails = package.package_relationships(ooxml_package::relationship_type::THUMBNAIL);
+            if (!thumbnails.empty()) {
+                result.metadata.set(thumbnail_key, thumbnails.front());
+            }
+
+            // Add summary counts
+            if (!core_part.empty()) {
+                result.metadata.set("Total.Core", std::to_string(core_count));
+            }
+            if (!app_part.empty()) {
+                result.metadata.set("Total.App", std::to_string(app_count));
+            }
+            result.metadata.set("Total.Custom", std::to_string(custom_count));
+            result.metadata.set("Total.Authors", std::to_string(authors.size()));
+
+        } catch (const std::exception& e) {
+            result.success = false;
+            result.message = "Exception while reading metadata: " + std::string(e.what());
+        }
+
+        return result;
+    }
+
+    void ooxml_processor_class::strip_package_metadata(const std::function<bool(const std::string&)>& drop,
+                                                       ooxml_package::package_edit& edit) const {
+        std::set<std::string> removals;
+
+        // Custom properties go as a part, or one by one when only some are selected
+        for (const auto& part : package.parts_of_type(ooxml_package::content_type::CUSTOM_PROPERTIES)) {
+            pugi::xml_document custom;
+            if (!drop) {
+                removals.insert(part);
+                continue;
+            }
+            if (!load(package, part, custom)) {
+                continue;
+            }
+            std::vector<pugi::xml_node> selected;
+            std::size_t remaining = 0;
+            for (pugi::xml_node node : custom.document_element().children()) {
+                const std::string name = node.attribute("name").value();
+                if (!name.empty() && drop("Custom." + name)) {
+                    selected.push_back(node);
+                } else {
+                    remaining++;
+                }
+            }
+            for (pugi::xml_node node : selected) {
+                node.parent().remove_child(node);
+            }
+            if (remaining == 0) {
+                removals.insert(part);
+            } else if (!selected.empty()) {
+                edit.replace_part(part, save(custom));
+            }
+        }
+
+        // Comments keep their place, only the names of their authors are cleared
+        if (!drop || drop(comment_authors_key)) {
+            for (const auto& people : people_parts) {
+                for (const auto& part : package.parts_of_type(people.content_type)) {
+                    pugi::xml_document document;
+                    if (people.removable) {
+                        removals.insert(part);
+                        continue;
+                    }
+                    if (!load(package, part, document)) {
+                        continue;
+                    }
+                    bool changed = false;
+                    for_each_person(document, people, [&](pugi::xml_node node) {
+                        if (people.attributes.empty()) {
+                            changed = changed || !node.text().empty();
+                            node.text().set("");
+                            return;
+                        }
+                        for (const auto& name : people.attributes) {
+                            pugi::xml_attribute attribute = find_attribute(node, name);
+                            if (attribute && *attribute.value() != '\0') {
+                                attribute.set_value("");
+                                changed = true;
+                            }
+                        }
+                    });
+                    if (changed) {
+                        edit.replace_part(part, save(document));
+                    }
+                }
+            }
+        }
+
+        if (!drop || drop(thumbnail_key)) {
+            for (const auto& part : package.package_relationships(ooxml_package::relationship_type::THUMBNAIL)) {
+                removals.insert(part);
+            }
+        }
+
+        package.remove_parts(edit, removals);
+    }
+
+    bool ooxml_processor_class::clean_selected_image(const std::string& part_name, const std::string& data,
+                                                     std::string& cleaned, std::vector<std::string>& warnings) const {
+        std::vector<unsigned char> output;
+        file_handler::buffer_binding image;
+        image.data = reinterpret_cast<const unsigned char*>(data.data());
+        image.size = data.size();
+        image.output = &output;
+
+        auto handler = file_handler::create_buffer_handler(part_name, image, file_handler::operation_type::CLEAN,
+                                                           options_holder);
+        if (!handler) {
+            return false;
+        }
+        auto result = handler->execute_operation();
+        warnings = std::move(result.warnings);
+        if (!result.success) {
+            throw std::runtime_error(result.message);
+        }
+        if (output.empty() ||
+            (output.size() == data.size() && std::memcmp(output.data(), data.data(), data.size()) == 0)) {
+            return false;
+        }
+        cleaned.assign(reinterpret_cast<const char*>(output.data()), output.size());
+        return true;
+    }
+
+    void ooxml_processor_class::scrub_media(ooxml_package::package_edit& edit,
+                                            std::vector<std::string>& warnings) const {
+        std::vector<std::string> images;
+        for (const char* type : image_types) {
+            for (const auto& part : package.parts_of_type(type)) {
+                if (!edit.removes(part)) {
+                    images.push_back(part);
+                }
+            }
+        }
+
+        std::vector<scrubbed_image> scrubbed(images.size());
+        const auto scrub = [&](std::size_t i) {
+            std::string data;
+            if (!package.read_part(images[i], data)) {
+                scrubbed[i].error = "Failed to read embedded image: " + images[i];
+                return;
+            }
+            try {
+                // A selection goes through the image processors, so it applies to the keys they report
+                if (has_selection()) {
+                    scrubbed[i].removed = clean_selected_image(images[i], data, scrubbed[i].content,
+                                                               scrubbed[i].warnings) ? 1 : 0;
+                    return;
+                }
+
+                // The signature decides the engine, the content type of a part can be wrong
+                const auto* bytes = reinterpret_cast<const unsigned char*>(data.data());
+                file_io::memory_source source(bytes, data.size());
+                string_sink sink;
+                if (png_chunks::has_signature(bytes, data.size())) {
+                    scrubbed[i].removed = png_chunks::strip(source, sink);
+                } else if (data.size() >= 2 && bytes[0] == 0xFF && bytes[1] == 0xD8) {
+                    scrubbed[i].removed = jpeg_segments::strip(source, sink);
+                }
+                if (scrubbed[i].removed > 0) {
+                    scrubbed[i].content = std::move(sink.content);
+                }
+            } catch (const std::exception& e) {
+                scrubbed[i].error = "Failed to clean embedded image " + images[i] + ": " + e.what();
+            }
+        };
+
+        // Inflating and stripping both run on the workers, read_part takes no lock for deflated parts
+        if (options.worker_pool && images.size() > 1) {
+            options.worker_pool->parallel_for(images.size(), scrub);
+        } else {
+            for (std::size_t i = 0; i < images.size(); i++) {
+                scrub(i);
+            }
+        }
+
+        for (std::size_t i = 0; i < images.size(); i++) {
+            for (auto& warning : scrubbed[i].warnings) {
+                warnings.push_back(images[i] + ": " + warning);
+            }
+            if (!scrubbed[i].error.empty()) {
+                warnings.push_back(scrubbed[i].error);
+            } else if (scrubbed[i].removed > 0) {
+                edit.replace_part(images[i], std::move(scrubbed[i].content));
+            }
+        }
+    }
+
+    file_handler::operation_result ooxml_processor_class::clean_metadata() {
+        file_handler::operation_result result;
+        result.success = true;
+        result.message = "Metadata successfully cleaned";
+
+        try {
+            if (!package_loaded) {
+                result.success = false;
+                result.message = std::string(format_name()) + " document not properly loaded";
+                return result;
+            }
+
+            if (has_selection()) {
+                return clean_selected_metadata();
+            }
+
+            // Replace core and app properties with their minimal required structure
+            ooxml_package::package_edit edit;
+            if (!core_part.empty()) {
+                pugi::xml_document clean_core_xml;
+                new_core_properties(clean_core_xml);
+                edit.replace_part(core_part, save(clean_core_xml));
+            }
+            if (!app_part.empty()) {
+                pugi::xml_document clean_app_xml;
+                new_extended_properties(clean_app_xml);
+                edit.replace_part(app_part, save(clean_app_xml));
+            }
+            strip_package_metadata(nullptr, edit);
+            scrub_media(edit, result.warnings);
+
+            // Update the package with a single archive rewrite
+            if (!commit_edit(edit)) {
+                result.success = false;
+                result.message = std::string("Failed to update XML files in ") + format_name();
+                return result;
+            }
+
+        } catch (const std::exception& e) {
+            result.success = false;
+            result.message = "Exception while cleaning metadata: " + std::string(e.what());
+        }
+
+        return result;
+    }
+
+    file_handler::operation_result ooxml_processor_class::clean_selected_metadata() {
+        // Drop the selected property elements, everything else in both parts stays as it is
+        auto remove_selected = [this](pugi::xml_document& document, const std::string& prefix) {
+            std::vector<pugi::xml_node> selected;
+            for (pugi::xml_node node : document.document_element().children()) {
+                const std::string key = node.name();
+                if (!key.empty() && is_selected(prefix + key)) {
+                    selected.push_back(node);
+                }
+            }
+            for (pugi::xml_node node : selected) {
+                node.parent().remove_child(node);
+            }
+            return !selected.empty();
+        };
+
+        ooxml_package::package_edit edit;
+        if (!core_part.empty() && remove_selected(*core_xml, "Core.")) {
+            edit.replace_part(core_part, save(*core_xml));
+        }
+        if (!app_part.empty() && remove_selected(*app_xml, "App.")) {
+            edit.replace_part(app_part, save(*app_xml));
+        }
+        strip_package_metadata([this](const std::string& key) { return is_selected(key); }, edit);
+        std::vector<std::string> warnings;
+        scrub_media(edit, warnings);
+
+        // Nothing selected is present, the file is left as it is
+        if (edit.empty() && !in_memory() && get_output_path() == std::filesystem::path(file_path)) {
+            return {true, "No selected metadata found", std::move(warnings), {}};
+        }
+
+        if (!commit_edit(edit)) {
+            return {false, std::string("Failed to update XML files in ") + format_name(), std::move(warnings), {}};
+        }
+        return {true, "Selected metadata successfully removed", std::move(warnings), {}};
+    }
+
+    file_handler::operation_result ooxml_processor_class::overwrite_metadata() {
+        file_handler::operation_result result;
+        result.success = true;
+        result.message = "Metadata successfully overwritten";
+
+        try {
+            if (!package_loaded) {
+                result.success = false;
+                result.message = std::string(format_name()) + " document not properly loaded";
+                return result;
+            }
+
+            // Create new XML documents with clean structure
+            pugi::xml_document new_core_xml;
+            pugi::xml_node core_props = new_core_properties(new_core_xml);
+
+            pugi::xml_document new_app_xml;
+            pugi::xml_node app_props = new_extended_properties(new_app_xml);
+
+            // Add metadata from options
+            auto& metadata = options.overwrite_metadata;
+            for (const auto& [key, value] : metadata) {
+                if (key.empty() || value.empty()) {
+                    continue;
+                }
+
+                // Handle common metadata fields
+                if (key == "Title") {
+                    core_props.append_child("dc:title").text().set(value.c_str());
+                }
+                else if (key == "Subject") {
+                    core_props.append_child("dc:subject").text().set(value.c_str());
+                }
+                else if (key == "Author" || key == "Creator") {
+                    core_props.append_child("dc:creator").text().set(value.c_str());
+                }
+                else if (key == "Description") {
+                    core_props.append_child("dc:description").text().set(value.c_str());
+                }
+                else if (key == "Keywords") {
+                    core_props.append_child("cp:keywords").text().set(value.c_str());
+                }
+                else if (key == "Category") {
+                    core_props.append_child("cp:category").text().set(value.c_str());
+                }
+                else if (key == "LastModifiedBy") {
+                    core_props.append_child("cp:lastModifiedBy").text().set(value.c_str());
+                }
+                // Application specific properties
+                else if (key == "Application") {
+                    app_props.append_child("Application").text().set(value.c_str());
+                }
+                else if (key == "Company") {
+                    app_props.append_child("Company").text().set(value.c_str());
+                }
+                else if (key == "Manager") {
+                    app_props.append_child("Manager").text().set(value.c_str());
+                }
+                // Handle prefixed properties
+                else if (key.substr(0, 5) == "Core.") {
+                    std::string node_name = key.substr(5);
+                    core_props.append_child(node_name.c_str()).text().set(value.c_str());
+                }
+                else if (key.substr(0, 4) == "App.") {
+                    std::string node_name = key.substr(4);
+                    app_props.append_child(node_name.c_str()).text().set(value.c_str());
+                }
+            }
+
+            // Add creation and modification time, in UTC as the W3CDTF 'Z' suffix says
+            auto now = std::time(nullptr);
+            std::tm tm_now = utc_time(now);
+            char time_str[64];
+            std::strftime(time_str, sizeof(time_str), "%Y-%m-%dT%H:%M:%SZ", &tm_now);
+
+            // Only add times if not already set
+            if (!core_props.child("dcterms:created")) {
+                pugi::xml_node created = core_props.append_child("dcterms:created");
+                created.text().set(time_str);
+                created.append_attribute("xsi:type") = "dcterms:W3CDTF";
+            }
+
+            if (!core_props.child("dcterms:modified")) {
+                pugi::xml_node modified = core_props.append_child("dcterms:modified");
+                modified.text().set(time_str);
+                modified.append_attribute("xsi:type") = "dcterms:W3CDTF";
+            }
+
+            // A part the package does not reference would be ignored by every reader
+            ooxml_package::package_edit edit;
+            if (!core_part.empty()) {
+                edit.replace_part(core_part, save(new_core_xml));
+            } else {
+                result.warnings.push_back(std::string("No core properties part in ") + format_name());
+            }
+            if (!app_part.empty()) {
+                edit.replace_part(app_part, save(new_app_xml));
+            } else {
+                result.warnings.push_back(std::string("No extended properties part in ") + format_name());
+            }
+            strip_package_metadata(nullptr, edit);
+            scrub_media(edit, result.warnings);
+
+            // Update the package with a single archive rewrite
+            if (!commit_edit(edit)) {
+                result.success = false;
+                result.message = std::string("Failed to update XML files in ") + format_name();
+                return result;
+            }
+
+        } catch (const std::exception& e) {
+            result.success = false;
+            result.message = "Exception while overwriting metadata: " + std::string(e.what());
+        }
+
+        return result;
+    }
+
+    file_handler::operation_result ooxml_processor_class::export_metadata() {
+        // First read the metadata
+        auto result = read_metadata();
+        if (!result.success) {
+            return result;
+        }
+
+        try {
+            // Create output directory if needed
+            if (!options.output_directory.empty() && !std::filesystem::exists(options.output_directory)) {
+                std::filesystem::create_directories(options.output_directory);
+            }
+
+            // Create output file path
+            std::filesystem::path output_path;
+            if (options.output_directory.empty()) {
+                output_path = std::filesystem::path(file_path).parent_path() /
+                             (std::filesystem::path(file_path).stem().string() + "_metadata.json");
+            } else {
+                output_path = options.output_directory /
+                             (std::filesystem::path(file_path).stem().string() + "_metadata.json");
+            }
+
+            // Write to output file
+            std::ofstream out(output_path);
+            if (!out) {
+                result.success = false;
+                result.message = "Failed to create output file: " + output_path.string();
+                return result;
+            }
+
+            // Write in JSON format
+            out << "{\n";
+            bool first = true;
+            for (const auto& [key, value] : result.metadata) {
+                if (!first) out << ",\n";
+                // Escape JSON special characters in the value
+                std::string escaped_value(value);
+                size_t pos = 0;
+                while ((pos = escaped_value.find("\"", pos)) != std::string::npos) {
+                    escaped_value.replace(pos, 1, "\\\"");
+                    pos += 2;
+                }
+                out << "  \"" << key << "\": \"" << escaped_value << "\"";
+                first = false;
+            }
+            out << "\n}";
+
+            out.close();
+
+            result.message = "Metadata successfully exported to: " + output_path.string();
+
+        } catch (const std::exception& e) {
+            result.success = false;
+            result.message = "Failed to export metadata: " + std::string(e.what());
+        }
+
+        return result;
+    }
+
+    file_handler::operation_result ooxml_processor_class::restore_metadata() {
+        // Restore operation not implemented
+        file_handler::operation_result result;
+        result.success = false;
+        result.message = std::string("Restore operation not implemented for ") + format_name();
+        return result;
+    }
+
+    bool ooxml_processor_class::commit_edit(const ooxml_package::package_edit& edit) {
+        if (!package.is_open()) {
+            std::cerr << format_name() << " archive is not open" << std::endl;
+            return false;
+        }
+
+        // Replaced parts are deflated on the shared workers, the entries are still written in order
+        zip_entries::write_options zip_options;
+        zip_options.compression_level = options.compression_level;
+        zip_options.workers = options.worker_pool.get();
+
+        // An unchanged package still has to be copied when the output is not the file itself
+        const bool copy_unchanged = in_memory() || get_output_path() != std::filesystem::path(file_path);
+        bool written = true;
+        if (!edit.empty() || copy_unchanged) {
+            try {
+                auto out = open_output();
+                package.write_to(*out, edit, zip_options);
+                out->commit();
+            } catch (const std::exception& e) {
+                std::cerr << "Failed to write " << format_name() << " file: " << e.what() << std::endl;
+                written = false;
+            }
+        }
+
+        package.close();
+        return written;
+    }
+
+}
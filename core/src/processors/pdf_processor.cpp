@@ -4,18 +4,38 @@
 #include <iostream>
 #include <filesystem>
 #include <fstream>
+#include <set>
+#include <vector>
 #include "./processors/pdf_processor.h"
 
 namespace pdf_processor {
 
     pdf_processor_class::pdf_processor_class(const std::string& path,
                                              file_handler::operation_type type,
-                                             const file_handler::operation_options& opts)
-             : file_handler_class(path, type, opts),pdf_loaded(false) {
+                                             file_handler::shared_options opts,
+                                             file_properties::file_type_probe probe,
+                                             file_handler::buffer_binding buffers)
+             : file_handler_class(path, type, std::move(opts), std::move(probe), buffers),pdf_loaded(false) {
+        // Reading and cleaning only need the trailer, Info and the catalog
+        if ((type == file_handler::operation_type::READ || type == file_handler::operation_type::EXPORT ||
+             type == file_handler::operation_type::CLEAN) && open_structure()) {
+            return;
+        }
+        load_document();
+    }
+
+    pdf_processor_class::~pdf_processor_class() = default;
+
+    void pdf_processor_class::load_document() {
         try {
+            // PoDoFo reads through a span device over a shared read-only mapping of the file
+            input_map = map_input();
+            auto device = std::make_shared<PoDoFo::SpanStreamDevice>(PoDoFo::bufferview(
+                reinterpret_cast<const char*>(input_map->get_data()), static_cast<size_t>(input_map->size())));
+
             // load pdf file
             pdf_document = std::make_unique<PoDoFo::PdfMemDocument>();
-            pdf_document->Load(file_path.c_str());
+            pdf_document->Load(device);
             pdf_loaded = true;
         } catch (const PoDoFo::PdfError& e) {
             std::cerr << "Failed to load PDF document: " << e.what() << std::endl;
@@ -24,9 +44,153 @@ namespace pdf_processor {
         }
     }
 
-    pdf_processor_class::~pdf_processor_class() = default;
+    /**
+     * @brief Serialise the document and atomically replace the file or output buffer with it
+     *
+     * Saving straight to the path would truncate the file while it is mapped.
+     */
+    void pdf_processor_class::save_document() {
+        std::string buffer;
+        PoDoFo::StringStreamDevice device(buffer);
+        pdf_document->Save(device, PoDoFo::PdfSaveOptions::None);
+
+        auto out = open_output();
+        out->write(buffer.data(), buffer.size());
+
+        // The mapping has to be released before the file is replaced
+        pdf_document.reset();
+        input_map.reset();
+        pdf_loaded = false;
+        out->commit();
+    }
+
+    /**
+     * @brief Open the document through its cross-reference data only
+     *
+     * Encrypted documents are left to PoDoFo, their strings need the key.
+     *
+     * @return False if the structure could not be parsed, the caller then loads the whole document
+     */
+    bool pdf_processor_class::open_structure() {
+        try {
+            pdf_input = open_input();
+            pdf_reader = std::make_unique<pdf_structure::pdf_reader_class>(*pdf_input);
+            if (!pdf_reader->is_encrypted()) {
+                return true;
+            }
+        } catch (const std::exception& e) {
+            std::cerr << "Failed to parse PDF structure, loading the whole document: " << e.what() << std::endl;
+        }
+        pdf_reader.reset();
+        pdf_input.reset();
+        return false;
+    }
+
+    file_handler::operation_result pdf_processor_class::read_structure_metadata() {
+        file_handler::operation_result result;
+        result.success = true;
+        result.message = "Metadata successfully read";
+
+        const pdf_structure::value& trailer = pdf_reader->get_trailer();
+
+        if (const pdf_structure::value* info_ref = trailer.find("Info")) {
+            const pdf_structure::value info = pdf_reader->resolve(*info_ref);
+            if (info.is_dictionary()) {
+                auto read_string = [this, &result, &info](const char* key, const char* result_key) {
+                    if (const pdf_structure::value* entry = info.find(key)) {
+                        const pdf_structure::value resolved = pdf_reader->resolve(*entry);
+                        if (resolved.is_string()) {
+                            result.metadata.set(result_key, pdf_structure::decode_text_string(resolved.text));
+                        }
+                    }
+                };
+
+                read_string("Title", "Title");
+                read_string("Author", "Author");
+                read_string("Subject", "Subject");
+                read_string("Keywords", "Keywords");
+                read_string("Creator", "Creator");
+                read_string("Producer", "Producer");
+                read_string("CreationDate", "CreationDate");
+                read_string("ModDate", "ModificationDate");
+            }
+        }
+
+        const pdf_structure::value* root_ref = trailer.find("Root");
+        if (root_ref == nullptr) {
+            throw std::runtime_error("Trailer has no /Root");
+        }
+        const pdf_structure::value catalog = pdf_reader->resolve(*root_ref);
+        if (!catalog.is_dictionary()) {
+            throw std::runtime_error("Catalog is not a dictionary");
+        }
+        if (catalog.find("Metadata") != nullptr) {
+            result.metadata.set("HasXMPMetadata", "true");
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief Remove Info and XMP by copying the reachable objects into a new file
+     *
+     * Untouched objects and all streams are copied byte for byte, only the
+     * catalog, the cross-reference table and the trailer are written anew.
+     * With a selection only the selected Info entries are dropped, which
+     * rewrites the Info dictionary instead of the trailer.
+     */
+    file_handler::operation_result pdf_processor_class::clean_structure() {
+        const pdf_structure::value& trailer = pdf_reader->get_trailer();
+        const pdf_structure::value* root = trailer.find("Root");
+        if (root == nullptr || !root->is_reference()) {
+            throw std::runtime_error("Trailer has no /Root reference");
+        }
+
+        pdf_structure::rewrite_plan plan;
+        if (!has_selection()) {
+            plan.removed_trailer_keys.insert("Info");
+            plan.removed_keys[root->object_number].insert("Metadata");
+        } else {
+            if (const pdf_structure::value* info_ref = trailer.find("Info")) {
+                const pdf_structure::value info = pdf_reader->resolve(*info_ref);
+                std::set<std::string> keys;
+                for (const auto& entry : info.entries) {
+                    // Keys are matched by the names read_metadata reports them under
+                    if (is_selected(entry.first == "ModDate" ? "ModificationDate" : entry.first)) {
+                        keys.insert(entry.first);
+                    }
+                }
+                if (!keys.empty()) {
+                    if (!info_ref->is_reference()) {
+                        throw std::runtime_error("Info is not an indirect object");
+                    }
+                    plan.removed_keys[info_ref->object_number] = std::move(keys);
+                }
+            }
+            if (is_selected("HasXMPMetadata")) {
+                plan.removed_keys[root->object_number].insert("Metadata");
+            }
+
+            // Nothing selected is present, the file is left as it is
+            if (plan.removed_keys.empty() && !in_memory() && get_output_path() == std::filesystem::path(file_path)) {
+                return {true, "No selected metadata found", {}, {}};
+            }
+        }
+
+        auto out = open_output();
+        pdf_structure::write_copy(*pdf_reader, *out, plan);
+
+        pdf_reader.reset();
+        pdf_input.reset();
+        out->commit();
+
+        return {true, has_selection() ? "Selected metadata successfully removed" : "Metadata successfully cleaned", {}, {}};
+    }
 
     file_handler::operation_result pdf_processor_class::check_prerequisites() {
+        if (pdf_reader) {
+            return {true, "", {}, {}};
+        }
         if (!pdf_loaded) {
             return {false, "Failed to load PDF document", {}, {}};
         }
@@ -34,6 +198,20 @@ namespace pdf_processor {
     }
 
     file_handler::operation_result pdf_processor_class::read_metadata() {
+        if (pdf_reader) {
+            try {
+                return read_structure_metadata();
+            } catch (const std::exception& e) {
+                std::cerr << "Failed to read PDF structure, loading the whole document: " << e.what() << std::endl;
+                pdf_reader.reset();
+                pdf_input.reset();
+                load_document();
+                if (!pdf_loaded) {
+                    return {false, "Failed to load PDF document", {}, {}};
+                }
+            }
+        }
+
         file_handler::operation_result result;
         result.success = true;
         result.message = "Metadata successfully read";
@@ -55,7 +233,7 @@ namespace pdf_processor {
                     if (infoDictionary.HasKey(PoDoFo::PdfName(key))) {
                         PoDoFo::PdfObject* keyObj = infoDictionary.FindKey(PoDoFo::PdfName(key));
                         if (keyObj != nullptr && keyObj->IsString()) {
-                            result.metadata[key] = keyObj->GetString().GetString();
+                            result.metadata.set(key, keyObj->GetString().GetString());
                         }
                     }
                 };
@@ -73,7 +251,7 @@ namespace pdf_processor {
                         PoDoFo::PdfObject* dateObj = infoDictionary.FindKey(PoDoFo::PdfName(key));
                         if (dateObj != nullptr && dateObj->IsString()) {
                             // 尝试解析 PDF 日期格式字符串
-                            result.metadata[resultKey] = dateObj->GetString().GetString();
+                            result.metadata.set(resultKey, dateObj->GetString().GetString());
                         }
                     }
                 };
@@ -87,7 +265,7 @@ namespace pdf_processor {
             PoDoFo::PdfDictionary& catalogDict = pdf_document->GetCatalog().GetDictionary();
             if (catalogDict.HasKey(PoDoFo::PdfName("Metadata"))) {
                 PoDoFo::PdfObject* metadataObj = catalogDict.FindKey(PoDoFo::PdfName("Metadata"));
-                result.metadata["HasXMPMetadata"] = "true";
+                result.metadata.set("HasXMPMetadata", "true");
 
                 // 如果需要，可以提取 XMP 内容
                 if (metadataObj != nullptr && metadataObj->HasStream()) {
@@ -109,25 +287,58 @@ namespace pdf_processor {
     }
 
     file_handler::operation_result pdf_processor_class::clean_metadata() {
+        if (pdf_reader) {
+            try {
+                return clean_structure();
+            } catch (const std::exception& e) {
+                std::cerr << "Failed to copy PDF structure, loading the whole document: " << e.what() << std::endl;
+                pdf_reader.reset();
+                pdf_input.reset();
+                load_document();
+                if (!pdf_loaded) {
+                    return {false, "Failed to load PDF document", {}, {}};
+                }
+            }
+        }
+
         file_handler::operation_result result;
         result.success = true;
         result.message = "Metadata successfully cleaned";
 
         try {
             // 获取 Info 字典对象
-            if (pdf_document->GetTrailer().GetDictionary().HasKey(PoDoFo::PdfName("Info"))) {
-                // 在 PoDoFo 0.10.4 中移除 Info 键
-                pdf_document->GetTrailer().GetDictionary().RemoveKey(PoDoFo::PdfName("Info"));
+            PoDoFo::PdfDictionary& trailerDict = pdf_document->GetTrailer().GetDictionary();
+            if (trailerDict.HasKey(PoDoFo::PdfName("Info"))) {
+                if (!has_selection()) {
+                    // 在 PoDoFo 0.10.4 中移除 Info 键
+                    trailerDict.RemoveKey(PoDoFo::PdfName("Info"));
+                } else {
+                    // Only drop the selected entries, under the names read_metadata reports
+                    PoDoFo::PdfObject* infoObj = trailerDict.FindKey(PoDoFo::PdfName("Info"));
+                    if (infoObj != nullptr && infoObj->IsDictionary()) {
+                        PoDoFo::PdfDictionary& infoDictionary = infoObj->GetDictionary();
+                        std::vector<PoDoFo::PdfName> selected;
+                        for (const auto& pair : infoDictionary) {
+                            const std::string key(pair.first.GetString());
+                            if (is_selected(key == "ModDate" ? "ModificationDate" : key)) {
+                                selected.push_back(pair.first);
+                            }
+                        }
+                        for (const auto& key : selected) {
+                            infoDictionary.RemoveKey(key);
+                        }
+                    }
+                }
             }
 
             // 移除 XMP 元数据
             PoDoFo::PdfDictionary& catalogDict = pdf_document->GetCatalog().GetDictionary();
-            if (catalogDict.HasKey(PoDoFo::PdfName("Metadata"))) {
+            if (catalogDict.HasKey(PoDoFo::PdfName("Metadata")) && (!has_selection() || is_selected("HasXMPMetadata"))) {
                 catalogDict.RemoveKey(PoDoFo::PdfName("Metadata"));
             }
 
             // 保存文档
-            pdf_document->Save(file_path.c_str(), PoDoFo::PdfSaveOptions::None);// to be fixed to ::Clean
+            save_document();
 
         } catch (const PoDoFo::PdfError& e) {
             result.success = false;
@@ -171,9 +382,10 @@ namespace pdf_processor {
             auto& metadata = options.overwrite_metadata;
 
             auto setDictString = [&metadata, &infoDictionary](const std::string& key) {
-                if (metadata.find(key) != metadata.end()) {
+                const auto it = metadata.find(key);
+                if (it != metadata.end()) {
                     infoDictionary.AddKey(PoDoFo::PdfName(key),
-                                         PoDoFo::PdfString(metadata[key]));
+                                         PoDoFo::PdfString(it->second));
                 }
             };
 
@@ -185,7 +397,7 @@ namespace pdf_processor {
             setDictString("Producer");
 
             // 保存文档
-            pdf_document->Save(file_path.c_str(), PoDoFo::PdfSaveOptions::None);
+            save_document();
 
         } catch (const PoDoFo::PdfError& e) {
             result.success = false;
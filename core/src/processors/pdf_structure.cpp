@@ -0,0 +1,1208 @@
+/**
+ * @file pdf_structure.cpp
+ * @brief Implementation of the lightweight PDF reader and copy writer
+ */
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <stdexcept>
+#include <zlib.h>
+#include "./processors/pdf_structure.h"
+
+namespace pdf_structure {
+
+    namespace {
+
+        constexpr int max_nesting = 256;
+
+        /**
+         * @brief Thrown when a value runs past the end of the current read window
+         */
+        struct need_more {};
+
+        bool is_whitespace(unsigned char c) {
+            return c == 0 || c == '\t' || c == '\n' || c == '\f' || c == '\r' || c == ' ';
+        }
+
+        bool is_delimiter(unsigned char c) {
+            return c == '(' || c == ')' || c == '<' || c == '>' || c == '[' || c == ']' ||
+                   c == '{' || c == '}' || c == '/' || c == '%';
+        }
+
+        bool is_regular(unsigned char c) {
+            return !is_whitespace(c) && !is_delimiter(c);
+        }
+
+        bool is_digits(const std::string& token) {
+            return !token.empty() && std::all_of(token.begin(), token.end(), [](char c) {
+                return c >= '0' && c <= '9';
+            });
+        }
+
+        int hex_digit(unsigned char c) {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            return -1;
+        }
+
+        /**
+         * @brief Parser over a window of bytes
+         *
+         * If the window does not reach the end of the data, running out of bytes
+         * throws need_more so the caller can retry with a larger window.
+         */
+        class parser {
+        public:
+            parser(const unsigned char* data, std::size_t size, std::uint64_t base, bool complete)
+                : data(data), size(size), base(base), complete(complete) {}
+
+            std::size_t pos {0};
+
+            unsigned char at(std::size_t index) const {
+                if (index >= size) {
+                    more();
+                }
+                return data[index];
+            }
+
+            void skip_whitespace() {
+                while (true) {
+                    if (pos >= size) {
+                        if (complete) return;
+                        throw need_more{};
+                    }
+                    if (is_whitespace(data[pos])) {
+                        pos++;
+                    } else if (data[pos] == '%') {
+                        while (pos < size && data[pos] != '\r' && data[pos] != '\n') {
+                            pos++;
+                        }
+                    } else {
+                        return;
+                    }
+                }
+            }
+
+            std::string read_token() {
+                const std::size_t start = pos;
+                while (true) {
+                    if (pos >= size) {
+                        if (complete) break;
+                        throw need_more{};
+                    }
+                    if (!is_regular(data[pos])) break;
+                    pos++;
+                }
+                return {reinterpret_cast<const char*>(data + start), pos - start};
+            }
+
+            bool try_keyword(const char* keyword) {
+                skip_whitespace();
+                const std::size_t saved = pos;
+                if (read_token() == keyword) {
+                    return true;
+                }
+                pos = saved;
+                return false;
+            }
+
+            std::uint64_t read_unsigned() {
+                skip_whitespace();
+                const std::string token = read_token();
+                if (!is_digits(token) || token.size() > 19) {
+                    throw std::runtime_error("Expected an integer at offset " + std::to_string(base + pos));
+                }
+                return std::strtoull(token.c_str(), nullptr, 10);
+            }
+
+            value parse_value(int depth = 0) {
+                if (depth > max_nesting) {
+                    throw std::runtime_error("PDF objects nested too deeply");
+                }
+
+                skip_whitespace();
+                value result;
+                result.begin = base + pos;
+
+                const unsigned char c = at(pos);
+                if (c == '/') {
+                    pos++;
+                    result.type = value::kind::NAME;
+                    result.text = read_name();
+                } else if (c == '(') {
+                    result.type = value::kind::STRING;
+                    result.text = read_literal_string();
+                } else if (c == '<' && at(pos + 1) == '<') {
+                    pos += 2;
+                    result.type = value::kind::DICTIONARY;
+                    while (true) {
+                        skip_whitespace();
+                        if (at(pos) == '>') {
+                            if (at(pos + 1) != '>') {
+                                throw std::runtime_error("Malformed dictionary at offset " + std::to_string(base + pos));
+                            }
+                            pos += 2;
+                            break;
+                        }
+                        value key = parse_value(depth + 1);
+                        if (key.type != value::kind::NAME) {
+                            throw std::runtime_error("Dictionary key is not a name at offset " + std::to_string(key.begin));
+                        }
+                        value entry = parse_value(depth + 1);
+                        result.entries.emplace_back(std::move(key.text), std::move(entry));
+                    }
+                } else if (c == '<') {
+                    result.type = value::kind::STRING;
+                    result.text = read_hex_string();
+                } else if (c == '[') {
+                    pos++;
+                    result.type = value::kind::ARRAY;
+                    while (true) {
+                        skip_whitespace();
+                        if (at(pos) == ']') {
+                            pos++;
+                            break;
+                        }
+                        result.items.push_back(parse_value(depth + 1));
+                    }
+                } else {
+                    const std::string token = read_token();
+                    if (token.empty()) {
+                        throw std::runtime_error("Unexpected character in PDF data at offset " + std::to_string(base + pos));
+                    }
+                    if (token == "true" || token == "false") {
+                        result.type = value::kind::BOOLEAN;
+                        result.text = token;
+                    } else if (token == "null") {
+                        result.type = value::kind::NULL_VALUE;
+                    } else if (std::strchr("0123456789+-.", token[0]) != nullptr) {
+                        result.type = value::kind::NUMBER;
+                        result.text = token;
+                        if (is_digits(token)) {
+                            try_reference(result);
+                        }
+                    } else {
+                        throw std::runtime_error("Unexpected token \"" + token + "\" at offset " + std::to_string(result.begin));
+                    }
+                }
+
+                result.end = base + pos;
+                return result;
+            }
+
+        private:
+            [[noreturn]] void more() const {
+                if (complete) {
+                    throw std::runtime_error("Unexpected end of PDF data");
+                }
+                throw need_more{};
+            }
+
+            /**
+             * @brief Turn "n g R" into a reference, the position is restored if it is not one
+             */
+            void try_reference(value& number) {
+                const std::size_t saved = pos;
+                skip_whitespace();
+                if (pos < size && data[pos] >= '0' && data[pos] <= '9') {
+                    const std::string generation = read_token();
+                    skip_whitespace();
+                    if (is_digits(generation) && pos < size && data[pos] == 'R') {
+                        pos++;
+                        if (pos >= size && !complete) {
+                            throw need_more{};
+                        }
+                        if (pos >= size || !is_regular(data[pos])) {
+                            number.type = value::kind::REFERENCE;
+                            number.object_number = static_cast<std::uint32_t>(std::strtoul(number.text.c_str(), nullptr, 10));
+                            number.generation = static_cast<std::uint32_t>(std::strtoul(generation.c_str(), nullptr, 10));
+                            number.text.clear();
+                            return;
+                        }
+                    }
+                }
+                pos = saved;
+            }
+
+            std::string read_name() {
+                std::string name;
+                while (true) {
+                    if (pos >= size) {
+                        if (complete) break;
+                        throw need_more{};
+                    }
+                    const unsigned char c = data[pos];
+                    if (!is_regular(c)) break;
+                    if (c == '#') {
+                        const int high = hex_digit(at(pos + 1));
+                        const int low = hex_digit(at(pos + 2));
+                        if (high >= 0 && low >= 0) {
+                            name += static_cast<char>(high * 16 + low);
+                            pos += 3;
+                            continue;
+                        }
+                    }
+                    name += static_cast<char>(c);
+                    pos++;
+                }
+                return name;
+            }
+
+            std::string read_literal_string() {
+                pos++;
+                std::string text;
+                int nesting = 1;
+                while (true) {
+                    const unsigned char c = at(pos++);
+                    if (c == '\\') {
+                        const unsigned char escaped = at(pos++);
+                        switch (escaped) {
+                            case 'n': text += '\n'; break;
+                            case 'r': text += '\r'; break;
+                            case 't': text += '\t'; break;
+                            case 'b': text += '\b'; break;
+                            case 'f': text += '\f'; break;
+                            case '\r':
+                                // Line continuation
+                                if (at(pos) == '\n') pos++;
+                                break;
+                            case '\n':
+                                break;
+                            default:
+                                if (escaped >= '0' && escaped <= '7') {
+                                    int code = escaped - '0';
+                                    for (int i = 0; i < 2 && at(pos) >= '0' && at(pos) <= '7'; i++) {
+                                        code = code * 8 + (at(pos++) - '0');
+                                    }
+                                    text += static_cast<char>(code & 0xFF);
+                                } else {
+                                    text += static_cast<char>(escaped);
+                                }
+                        }
+                    } else if (c == '(') {
+                        nesting++;
+                        text += '(';
+                    } else if (c == ')') {
+                        if (--nesting == 0) break;
+                        text += ')';
+                    } else if (c == '\r') {
+                        // End-of-line markers inside strings read as a single LF
+                        if (at(pos) == '\n') pos++;
+                        text += '\n';
+                    } else {
+                        text += static_cast<char>(c);
+                    }
+                }
+                return text;
+            }
+
+            std::string read_hex_string() {
+                pos++;
+                std::string text;
+                int pending = -1;
+                while (true) {
+                    const unsigned char c = at(pos++);
+                    if (c == '>') break;
+                    if (is_whitespace(c)) continue;
+                    const int digit = hex_digit(c);
+                    if (digit < 0) {
+                        throw std::runtime_error("Invalid hex string at offset " + std::to_string(base + pos - 1));
+                    }
+                    if (pending < 0) {
+                        pending = digit;
+                    } else {
+                        text += static_cast<char>(pending * 16 + digit);
+                        pending = -1;
+                    }
+                }
+                if (pending >= 0) {
+                    text += static_cast<char>(pending * 16);
+                }
+                return text;
+            }
+
+            const unsigned char* data;
+            std::size_t size;
+            std::uint64_t base;
+            bool complete;
+        };
+
+        /**
+         * @brief Run a parse function over a window of the source, growing the window until it fits
+         */
+        template<typename Func>
+        auto parse_at(const file_io::byte_source& source, std::uint64_t offset, std::size_t window, Func func) {
+            const std::uint64_t total = source.size();
+            if (offset >= total) {
+                throw std::runtime_error("Offset " + std::to_string(offset) + " is beyond the end of the file");
+            }
+
+            std::vector<unsigned char> buffer;
+            while (true) {
+                const auto available = static_cast<std::size_t>(std::min<std::uint64_t>(window, total - offset));
+                buffer.resize(available);
+                source.read_exact(offset, buffer.data(), available);
+
+                parser p(buffer.data(), available, offset, offset + available == total);
+                try {
+                    return func(p);
+                } catch (const need_more&) {
+                    window *= 4;
+                }
+            }
+        }
+
+        std::vector<unsigned char> inflate_data(const std::vector<unsigned char>& input) {
+            z_stream stream {};
+            if (inflateInit(&stream) != Z_OK) {
+                throw std::runtime_error("Failed to initialise zlib");
+            }
+
+            std::vector<unsigned char> output(std::max<std::size_t>(input.size() * 4, 4096));
+            stream.next_in = const_cast<Bytef*>(input.data());
+            stream.avail_in = static_cast<uInt>(input.size());
+
+            while (true) {
+                if (stream.total_out == output.size()) {
+                    output.resize(output.size() * 2);
+                }
+                stream.next_out = output.data() + stream.total_out;
+                stream.avail_out = static_cast<uInt>(output.size() - stream.total_out);
+
+                const int status = inflate(&stream, Z_NO_FLUSH);
+                if (status == Z_STREAM_END) {
+                    break;
+                }
+                // Tolerate streams that end without the zlib trailer
+                if (status == Z_BUF_ERROR && stream.avail_in == 0) {
+                    break;
+                }
+                if (status != Z_OK && status != Z_BUF_ERROR) {
+                    inflateEnd(&stream);
+                    throw std::runtime_error("Corrupt FlateDecode stream");
+                }
+            }
+
+            output.resize(stream.total_out);
+            inflateEnd(&stream);
+            return output;
+        }
+
+        long long parameter(const value* params, const char* key, long long fallback) {
+            if (params == nullptr || !params->is_dictionary()) {
+                return fallback;
+            }
+            const value* entry = params->find(key);
+            return entry != nullptr && entry->type == value::kind::NUMBER ? entry->as_integer() : fallback;
+        }
+
+        /**
+         * @brief Undo PNG row predictors
+         */
+        std::vector<unsigned char> apply_predictor(std::vector<unsigned char> data, const value* params) {
+            const long long predictor = parameter(params, "Predictor", 1);
+            if (predictor == 1) {
+                return data;
+            }
+            if (predictor < 10) {
+                throw std::runtime_error("Unsupported TIFF predictor");
+            }
+
+            const long long colors = parameter(params, "Colors", 1);
+            const long long bits = parameter(params, "BitsPerComponent", 8);
+            const long long columns = parameter(params, "Columns", 1);
+            if (colors < 1 || bits < 1 || columns < 1 || colors * bits * columns > (1LL << 32)) {
+                throw std::runtime_error("Invalid predictor parameters");
+            }
+
+            const auto pixel_bytes = static_cast<std::size_t>(std::max<long long>(1, colors * bits / 8));
+            const auto row_bytes = static_cast<std::size_t>((colors * bits * columns + 7) / 8);
+
+            std::vector<unsigned char> output;
+            output.reserve(data.size());
+            std::vector<unsigned char> previous(row_bytes, 0);
+            std::vector<unsigned char> row(row_bytes);
+
+            for (std::size_t pos = 0; pos + 1 + row_bytes <= data.size(); pos += 1 + row_bytes) {
+                const unsigned char filter = data[pos];
+                std::copy(data.begin() + static_cast<std::ptrdiff_t>(pos + 1),
+                          data.begin() + static_cast<std::ptrdiff_t>(pos + 1 + row_bytes), row.begin());
+
+                for (std::size_t i = 0; i < row_bytes; i++) {
+                    const int left = i >= pixel_bytes ? row[i - pixel_bytes] : 0;
+                    const int up = previous[i];
+                    const int up_left = i >= pixel_bytes ? previous[i - pixel_bytes] : 0;
+                    switch (filter) {
+                        case 0: break;
+                        case 1: row[i] = static_cast<unsigned char>(row[i] + left); break;
+                        case 2: row[i] = static_cast<unsigned char>(row[i] + up); break;
+                        case 3: row[i] = static_cast<unsigned char>(row[i] + (left + up) / 2); break;
+                        case 4: {
+                            const int estimate = left + up - up_left;
+                            const int distance_left = std::abs(estimate - left);
+                            const int distance_up = std::abs(estimate - up);
+                            const int distance_up_left = std::abs(estimate - up_left);
+                            int predicted = up_left;
+                            if (distance_left <= distance_up && distance_left <= distance_up_left) {
+                                predicted = left;
+                            } else if (distance_up <= distance_up_left) {
+                                predicted = up;
+                            }
+                            row[i] = static_cast<unsigned char>(row[i] + predicted);
+                            break;
+                        }
+                        default:
+                            throw std::runtime_error("Invalid PNG predictor row filter");
+                    }
+                }
+
+                output.insert(output.end(), row.begin(), row.end());
+                previous.swap(row);
+            }
+            return output;
+        }
+
+        std::uint64_t read_field(const unsigned char* data, long long width) {
+            std::uint64_t result = 0;
+            for (long long i = 0; i < width; i++) {
+                result = (result << 8) | data[i];
+            }
+            return result;
+        }
+
+        void append_utf8(std::string& out, std::uint32_t code_point) {
+            if (code_point < 0x80) {
+                out += static_cast<char>(code_point);
+            } else if (code_point < 0x800) {
+                out += static_cast<char>(0xC0 | (code_point >> 6));
+                out += static_cast<char>(0x80 | (code_point & 0x3F));
+            } else if (code_point < 0x10000) {
+                out += static_cast<char>(0xE0 | (code_point >> 12));
+                out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (code_point & 0x3F));
+            } else {
+                out += static_cast<char>(0xF0 | (code_point >> 18));
+                out += static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (code_point & 0x3F));
+            }
+        }
+
+        // PDFDocEncoding code points that differ from Latin-1
+        const std::uint16_t pdf_doc_low[8] = {0x02D8, 0x02C7, 0x02C6, 0x02D9, 0x02DD, 0x02DB, 0x02DA, 0x02DC};
+        const std::uint16_t pdf_doc_high[33] = {
+            0x2022, 0x2020, 0x2021, 0x2026, 0x2014, 0x2013, 0x0192, 0x2044, 0x2039, 0x203A, 0x2212,
+            0x2030, 0x201E, 0x201C, 0x201D, 0x2018, 0x2019, 0x201A, 0x2122, 0xFB01, 0xFB02, 0x0141,
+            0x0152, 0x0160, 0x0178, 0x017D, 0x0131, 0x0142, 0x0153, 0x0161, 0x017E, 0xFFFD, 0x20AC
+        };
+
+    }
+
+    // value
+
+    const value* value::find(const std::string& key) const {
+        for (const auto& [name, entry] : entries) {
+            if (name == key) {
+                return &entry;
+            }
+        }
+        return nullptr;
+    }
+
+    long long value::as_integer() const {
+        if (type == kind::NUMBER) {
+            char* end = nullptr;
+            const long long result = std::strtoll(text.c_str(), &end, 10);
+            if (end != nullptr && *end == '\0') {
+                return result;
+            }
+        }
+        throw std::runtime_error("Expected an integer in PDF data");
+    }
+
+    // pdf_reader_class
+
+    pdf_reader_class::pdf_reader_class(const file_io::byte_source& source) : source(source) {
+        startxref = find_startxref();
+        read_xref_chain(startxref);
+    }
+
+    std::uint32_t pdf_reader_class::get_size() const {
+        const value* size = trailer.find("Size");
+        if (size == nullptr) {
+            throw std::runtime_error("Trailer has no /Size");
+        }
+        return static_cast<std::uint32_t>(size->as_integer());
+    }
+
+    std::uint64_t pdf_reader_class::find_startxref() const {
+        static const std::string keyword = "startxref";
+        const std::uint64_t total = source.size();
+        const auto tail = static_cast<std::size_t>(std::min<std::uint64_t>(total, 2048));
+
+        std::vector<unsigned char> buffer(tail);
+        source.read_exact(total - tail, buffer.data(), tail);
+
+        const auto found = std::find_end(buffer.begin(), buffer.end(), keyword.begin(), keyword.end());
+        if (found == buffer.end()) {
+            throw std::runtime_error("No startxref found");
+        }
+
+        const auto start = static_cast<std::size_t>(found - buffer.begin()) + keyword.size();
+        parser p(buffer.data() + start, buffer.size() - start, total - tail + start, true);
+        return p.read_unsigned();
+    }
+
+    void pdf_reader_class::read_xref_chain(std::uint64_t offset) {
+        std::set<std::uint64_t> visited;
+        bool newest = true;
+
+        while (visited.insert(offset).second) {
+            const bool is_table = parse_at(source, offset, 64, [](parser& p) {
+                return p.try_keyword("xref");
+            });
+
+            value section_trailer = is_table ? read_xref_table(offset) : read_xref_stream(offset);
+
+            // Hybrid files list compressed objects in an extra cross-reference stream
+            if (is_table) {
+                if (const value* extra = section_trailer.find("XRefStm")) {
+                    read_xref_stream(static_cast<std::uint64_t>(extra->as_integer()));
+                }
+            }
+
+            const value* previous = section_trailer.find("Prev");
+            const std::uint64_t next = previous != nullptr ? static_cast<std::uint64_t>(previous->as_integer()) : 0;
+
+            if (newest) {
+                trailer = std::move(section_trailer);
+                newest = false;
+            }
+            if (previous == nullptr) {
+                break;
+            }
+            offset = next;
+        }
+    }
+
+    value pdf_reader_class::read_xref_table(std::uint64_t offset) {
+        std::uint64_t position = offset + parse_at(source, offset, 64, [](parser& p) {
+            p.try_keyword("xref");
+            return p.pos;
+        });
+
+        while (true) {
+            bool at_trailer = false;
+            xref_section section;
+            std::uint64_t entries_offset = 0;
+
+            parse_at(source, position, 256, [&](parser& p) {
+                if (p.try_keyword("trailer")) {
+                    at_trailer = true;
+                } else {
+                    section.first = static_cast<std::uint32_t>(p.read_unsigned());
+                    section.count = static_cast<std::uint32_t>(p.read_unsigned());
+                    p.skip_whitespace();
+                }
+                entries_offset = position + p.pos;
+                return 0;
+            });
+
+            if (at_trailer) {
+                position = entries_offset;
+                break;
+            }
+
+            if (section.count > 0) {
+                // Entries are 20 bytes, some writers drop the space before a one-byte EOL
+                unsigned char entry[20];
+                const std::size_t available = source.read_at(entries_offset, entry, sizeof(entry));
+                if (available < 19) {
+                    throw std::runtime_error("Truncated cross-reference table");
+                }
+                const bool full_size = entry[18] == ' ' || (entry[18] == '\r' && available == 20 && entry[19] == '\n');
+                section.entry_size = full_size ? 20 : 19;
+            }
+
+            const std::uint64_t table_size = static_cast<std::uint64_t>(section.count) * section.entry_size;
+            if (entries_offset + table_size > source.size()) {
+                throw std::runtime_error("Cross-reference table runs past the end of the file");
+            }
+
+            section.table_offset = entries_offset;
+            position = entries_offset + table_size;
+            if (section.count > 0) {
+                sections.push_back(std::move(section));
+            }
+        }
+
+        value dictionary = parse_at(source, position, 4096, [](parser& p) {
+            return p.parse_value();
+        });
+        if (!dictionary.is_dictionary()) {
+            throw std::runtime_error("Trailer is not a dictionary");
+        }
+        return dictionary;
+    }
+
+    value pdf_reader_class::read_xref_stream(std::uint64_t offset) {
+        indirect_object object = load_object_at(offset);
+        if (!object.has_stream || !object.object.is_dictionary()) {
+            throw std::runtime_error("Cross-reference stream expected at offset " + std::to_string(offset));
+        }
+
+        const value& dictionary = object.object;
+        const value* widths = dictionary.find("W");
+        if (widths == nullptr || widths->items.size() != 3) {
+            throw std::runtime_error("Cross-reference stream has no valid /W");
+        }
+        long long w[3];
+        for (int i = 0; i < 3; i++) {
+            w[i] = widths->items[i].as_integer();
+            if (w[i] < 0 || w[i] > 8) {
+                throw std::runtime_error("Cross-reference stream has no valid /W");
+            }
+        }
+        const auto row_size = static_cast<std::size_t>(w[0] + w[1] + w[2]);
+        if (row_size == 0) {
+            throw std::runtime_error("Cross-reference stream has no valid /W");
+        }
+
+        std::vector<std::pair<long long, long long>> index;
+        if (const value* ranges = dictionary.find("Index")) {
+            for (std::size_t i = 0; i + 1 < ranges->items.size(); i += 2) {
+                index.emplace_back(ranges->items[i].as_integer(), ranges->items[i + 1].as_integer());
+            }
+        } else {
+            const value* size = dictionary.find("Size");
+            if (size == nullptr) {
+                throw std::runtime_error("Cross-reference stream has no /Size");
+            }
+            index.emplace_back(0, size->as_integer());
+        }
+
+        const std::vector<unsigned char> data = read_stream(object);
+        std::size_t position = 0;
+
+        for (const auto& [first, count] : index) {
+            if (first < 0 || count < 0) {
+                throw std::runtime_error("Invalid cross-reference stream /Index");
+            }
+
+            xref_section section;
+            section.first = static_cast<std::uint32_t>(first);
+            for (long long i = 0; i < count && position + row_size <= data.size(); i++) {
+                const unsigned char* row = data.data() + position;
+                position += row_size;
+
+                // A missing type field means type 1
+                const std::uint64_t type = w[0] == 0 ? 1 : read_field(row, w[0]);
+                xref_entry entry;
+                entry.offset = read_field(row + w[0], w[1]);
+                entry.generation = static_cast<std::uint32_t>(read_field(row + w[0] + w[1], w[2]));
+                entry.type = type == 1 ? xref_entry::kind::IN_USE
+                           : type == 2 ? xref_entry::kind::COMPRESSED
+                           : xref_entry::kind::FREE;
+                section.entries.push_back(entry);
+            }
+
+            section.count = static_cast<std::uint32_t>(section.entries.size());
+            if (section.count > 0) {
+                sections.push_back(std::move(section));
+            }
+        }
+
+        return dictionary;
+    }
+
+    xref_entry pdf_reader_class::read_table_entry(const xref_section& section, std::uint32_t number) const {
+        const std::uint64_t offset = section.table_offset + static_cast<std::uint64_t>(number - section.first) * section.entry_size;
+        unsigned char buffer[20];
+        const std::size_t available = source.read_at(offset, buffer, section.entry_size);
+
+        parser p(buffer, available, offset, true);
+        xref_entry entry;
+        entry.offset = p.read_unsigned();
+        entry.generation = static_cast<std::uint32_t>(p.read_unsigned());
+        p.skip_whitespace();
+        entry.type = p.read_token() == "n" ? xref_entry::kind::IN_USE : xref_entry::kind::FREE;
+        return entry;
+    }
+
+    bool pdf_reader_class::find_entry(std::uint32_t number, xref_entry& entry) const {
+        for (const auto& section : sections) {
+            if (number < section.first || number - section.first >= section.count) {
+                continue;
+            }
+
+            const xref_entry candidate = section.entries.empty()
+                ? read_table_entry(section, number)
+                : section.entries[number - section.first];
+
+            // Objects of hybrid files are marked free in the table and listed in the stream
+            if (candidate.type != xref_entry::kind::FREE) {
+                entry = candidate;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    indirect_object pdf_reader_class::get_object(std::uint32_t number) const {
+        xref_entry entry;
+        if (!find_entry(number, entry)) {
+            throw std::runtime_error("Object " + std::to_string(number) + " not found");
+        }
+
+        if (entry.type == xref_entry::kind::COMPRESSED) {
+            return load_compressed_object(number, entry);
+        }
+
+        indirect_object object = load_object_at(entry.offset);
+        if (object.number != number) {
+            throw std::runtime_error("Cross-reference entry of object " + std::to_string(number) +
+                                     " points to object " + std::to_string(object.number));
+        }
+        return object;
+    }
+
+    value pdf_reader_class::resolve(const value& val) const {
+        if (!val.is_reference()) {
+            return val;
+        }
+
+        xref_entry entry;
+        if (!find_entry(val.object_number, entry)) {
+            value null_value;
+            null_value.type = value::kind::NULL_VALUE;
+            return null_value;
+        }
+        return get_object(val.object_number).object;
+    }
+
+    indirect_object pdf_reader_class::load_object_at(std::uint64_t offset) const {
+        indirect_object object = parse_at(source, offset, 4096, [offset](parser& p) {
+            indirect_object result;
+            result.begin = offset;
+            result.number = static_cast<std::uint32_t>(p.read_unsigned());
+            result.generation = static_cast<std::uint32_t>(p.read_unsigned());
+            if (!p.try_keyword("obj")) {
+                throw std::runtime_error("Missing obj keyword at offset " + std::to_string(offset));
+            }
+
+            result.object = p.parse_value();
+            if (p.try_keyword("stream")) {
+                // The keyword is followed by CRLF or LF, a lone CR is tolerated
+                if (p.at(p.pos) == '\r') p.pos++;
+                if (p.at(p.pos) == '\n') p.pos++;
+                result.has_stream = true;
+                result.stream_offset = offset + p.pos;
+            } else {
+                if (!p.try_keyword("endobj")) {
+                    throw std::runtime_error("Missing endobj keyword at offset " + std::to_string(offset + p.pos));
+                }
+                result.end = offset + p.pos;
+            }
+            return result;
+        });
+
+        if (object.has_stream) {
+            if (!object.object.is_dictionary()) {
+                throw std::runtime_error("Stream without a dictionary at offset " + std::to_string(offset));
+            }
+            object.stream_length = stream_length(object.object);
+            object.end = find_stream_end(object.stream_offset + object.stream_length);
+        }
+        return object;
+    }
+
+    std::uint64_t pdf_reader_class::stream_length(const value& dictionary) const {
+        const value* length = dictionary.find("Length");
+        if (length == nullptr) {
+            throw std::runtime_error("Stream has no /Length");
+        }
+        if (!length->is_reference()) {
+            return static_cast<std::uint64_t>(length->as_integer());
+        }
+
+        if (length_depth > 4) {
+            throw std::runtime_error("Circular /Length reference");
+        }
+        length_depth++;
+        try {
+            const value resolved = resolve(*length);
+            length_depth--;
+            return static_cast<std::uint64_t>(resolved.as_integer());
+        } catch (...) {
+            length_depth--;
+            throw;
+        }
+    }
+
+    std::uint64_t pdf_reader_class::find_stream_end(std::uint64_t offset) const {
+        if (offset > source.size()) {
+            throw std::runtime_error("Stream runs past the end of the file");
+        }
+        if (offset == source.size()) {
+            throw std::runtime_error("Missing endstream keyword");
+        }
+
+        return parse_at(source, offset, 256, [offset](parser& p) {
+            if (!p.try_keyword("endstream")) {
+                throw std::runtime_error("Stream /Length does not match the endstream keyword at offset " +
+                                         std::to_string(offset));
+            }
+            if (!p.try_keyword("endobj")) {
+                throw std::runtime_error("Missing endobj keyword at offset " + std::to_string(offset + p.pos));
+            }
+            return offset + p.pos;
+        });
+    }
+
+    indirect_object pdf_reader_class::load_compressed_object(std::uint32_t number, const xref_entry& entry) const {
+        const auto stream_number = static_cast<std::uint32_t>(entry.offset);
+
+        std::shared_ptr<const object_stream> stream;
+        auto cached = object_streams.find(stream_number);
+        if (cached != object_streams.end()) {
+            stream = cached->second;
+        } else {
+            xref_entry container;
+            if (!find_entry(stream_number, container) || container.type != xref_entry::kind::IN_USE) {
+                throw std::runtime_error("Object stream " + std::to_string(stream_number) + " not found");
+            }
+
+            const indirect_object container_object = load_object_at(container.offset);
+            const value* first = container_object.object.find("First");
+            const value* count = container_object.object.find("N");
+            if (!container_object.has_stream || first == nullptr || count == nullptr) {
+                throw std::runtime_error("Object " + std::to_string(stream_number) + " is not an object stream");
+            }
+
+            auto decoded = std::make_shared<object_stream>();
+            decoded->data = read_stream(container_object);
+            decoded->first = static_cast<std::size_t>(first->as_integer());
+            decoded->count = static_cast<std::size_t>(count->as_integer());
+            stream = decoded;
+            object_streams.emplace(stream_number, stream);
+        }
+
+        if (entry.generation >= stream->count) {
+            throw std::runtime_error("Object stream index out of range for object " + std::to_string(number));
+        }
+
+        parser header(stream->data.data(), stream->data.size(), 0, true);
+        std::uint64_t object_offset = 0;
+        for (std::uint32_t i = 0; i <= entry.generation; i++) {
+            const std::uint64_t object_number = header.read_unsigned();
+            object_offset = header.read_unsigned();
+            if (i == entry.generation && object_number != number) {
+                throw std::runtime_error("Object stream does not contain object " + std::to_string(number));
+            }
+        }
+
+        const std::uint64_t position = stream->first + object_offset;
+        if (position >= stream->data.size()) {
+            throw std::runtime_error("Object stream offset out of range for object " + std::to_string(number));
+        }
+
+        parser body(stream->data.data(), stream->data.size(), 0, true);
+        body.pos = static_cast<std::size_t>(position);
+
+        indirect_object object;
+        object.number = number;
+        object.object = body.parse_value();
+        object.compressed = true;
+        object.container = stream_number;
+        return object;
+    }
+
+    std::string pdf_reader_class::read_raw(const indirect_object& object, const value& val) const {
+        if (val.end < val.begin) {
+            throw std::runtime_error("Invalid value span");
+        }
+
+        if (object.compressed) {
+            const auto stream = object_streams.find(object.container);
+            if (stream == object_streams.end() || val.end > stream->second->data.size()) {
+                throw std::runtime_error("Object stream of object " + std::to_string(object.number) + " is not loaded");
+            }
+            const auto* data = reinterpret_cast<const char*>(stream->second->data.data());
+            return {data + val.begin, static_cast<std::size_t>(val.end - val.begin)};
+        }
+
+        std::string raw(static_cast<std::size_t>(val.end - val.begin), '\0');
+        source.read_exact(val.begin, raw.data(), raw.size());
+        return raw;
+    }
+
+    std::vector<unsigned char> pdf_reader_class::read_stream(const indirect_object& object) const {
+        if (!object.has_stream) {
+            throw std::runtime_error("Object " + std::to_string(object.number) + " has no stream");
+        }
+
+        std::vector<unsigned char> data(static_cast<std::size_t>(object.stream_length));
+        source.read_exact(object.stream_offset, data.data(), data.size());
+
+        const value filter = resolve(object.object.find("Filter") != nullptr ? *object.object.find("Filter") : value{});
+        const value params = resolve(object.object.find("DecodeParms") != nullptr ? *object.object.find("DecodeParms") : value{});
+
+        std::vector<const value*> filters;
+        std::vector<const value*> filter_params;
+        if (filter.type == value::kind::NAME) {
+            filters.push_back(&filter);
+            filter_params.push_back(&params);
+        } else if (filter.type == value::kind::ARRAY) {
+            for (std::size_t i = 0; i < filter.items.size(); i++) {
+                filters.push_back(&filter.items[i]);
+                filter_params.push_back(params.type == value::kind::ARRAY && i < params.items.size() ? &params.items[i] : nullptr);
+            }
+        }
+
+        for (std::size_t i = 0; i < filters.size(); i++) {
+            const std::string& name = filters[i]->text;
+            if (name != "FlateDecode" && name != "Fl") {
+                throw std::runtime_error("Unsupported stream filter: " + name);
+            }
+            data = apply_predictor(inflate_data(data), filter_params[i]);
+        }
+        return data;
+    }
+
+    namespace {
+
+        // Trailer keys that describe the old cross-reference data
+        const std::set<std::string> structural_trailer_keys = {
+            "Size", "Prev", "XRefStm", "Type", "W", "Index", "Filter", "DecodeParms", "Length", "DL"
+        };
+
+        void collect_references(const value& val, std::vector<std::uint32_t>& references) {
+            switch (val.type) {
+                case value::kind::REFERENCE:
+                    references.push_back(val.object_number);
+                    break;
+                case value::kind::ARRAY:
+                    for (const auto& item : val.items) {
+                        collect_references(item, references);
+                    }
+                    break;
+                case value::kind::DICTIONARY:
+                    for (const auto& [key, entry] : val.entries) {
+                        collect_references(entry, references);
+                    }
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        std::string encode_name(const std::string& name) {
+            static const char digits[] = "0123456789ABCDEF";
+            std::string encoded = "/";
+            for (const char c : name) {
+                const auto byte = static_cast<unsigned char>(c);
+                if (byte < 0x21 || byte > 0x7E || byte == '#' || is_delimiter(byte)) {
+                    encoded += '#';
+                    encoded += digits[byte >> 4];
+                    encoded += digits[byte & 0x0F];
+                } else {
+                    encoded += c;
+                }
+            }
+            return encoded;
+        }
+
+        std::string write_dictionary(const pdf_reader_class& reader, const indirect_object& object,
+                                     const value& dictionary, const std::set<std::string>& removed) {
+            std::string text = "<<";
+            for (const auto& [key, entry] : dictionary.entries) {
+                if (removed.count(key) > 0) {
+                    continue;
+                }
+                text += encode_name(key);
+                text += ' ';
+                text += reader.read_raw(object, entry);
+            }
+            text += ">>";
+            return text;
+        }
+
+        std::string pdf_header(const file_io::byte_source& source) {
+            const auto size = static_cast<std::size_t>(std::min<std::uint64_t>(source.size(), 1024));
+            std::string head(size, '\0');
+            source.read_exact(0, head.data(), size);
+
+            const std::size_t start = head.find("%PDF-");
+            if (start == std::string::npos) {
+                return "%PDF-1.4";
+            }
+            const std::size_t end = head.find_first_of("\r\n", start);
+            return head.substr(start, end == std::string::npos ? std::string::npos : end - start);
+        }
+
+        std::string xref_row(std::uint64_t offset, std::uint32_t generation, char type) {
+            char row[21];
+            std::snprintf(row, sizeof(row), "%010llu %05u %c \n",
+                          static_cast<unsigned long long>(offset), generation, type);
+            return {row, 20};
+        }
+
+    }
+
+    std::size_t write_copy(const pdf_reader_class& reader, file_io::byte_sink& sink, const rewrite_plan& plan) {
+        const value& trailer = reader.get_trailer();
+        const file_io::byte_source& source = reader.get_source();
+        const std::uint32_t size = reader.get_size();
+
+        // Collect the objects reachable from the kept trailer entries
+        std::vector<std::uint32_t> pending;
+        for (const auto& [key, entry] : trailer.entries) {
+            if (structural_trailer_keys.count(key) == 0 && plan.removed_trailer_keys.count(key) == 0) {
+                collect_references(entry, pending);
+            }
+        }
+
+        std::vector<bool> visited(size, false);
+        std::vector<indirect_object> objects;
+        while (!pending.empty()) {
+            const std::uint32_t number = pending.back();
+            pending.pop_back();
+
+            xref_entry entry;
+            if (number == 0 || number >= size || visited[number] || !reader.find_entry(number, entry)) {
+                continue;
+            }
+            visited[number] = true;
+
+            indirect_object object = reader.get_object(number);
+            if (object.compressed && reader.is_encrypted()) {
+                throw std::runtime_error("Cannot unpack object streams of encrypted documents");
+            }
+
+            const auto removed = plan.removed_keys.find(number);
+            if (removed != plan.removed_keys.end() && object.object.is_dictionary()) {
+                for (const auto& [key, child] : object.object.entries) {
+                    if (removed->second.count(key) == 0) {
+                        collect_references(child, pending);
+                    }
+                }
+            } else {
+                collect_references(object.object, pending);
+                // Only the span is needed to copy the object
+                object.object.items = {};
+                object.object.entries = {};
+            }
+            objects.push_back(std::move(object));
+        }
+
+        // Keep the source order so the copy reads the file sequentially
+        std::sort(objects.begin(), objects.end(), [](const indirect_object& a, const indirect_object& b) {
+            if (a.compressed != b.compressed) return !a.compressed;
+            if (a.compressed) return a.container != b.container ? a.container < b.container : a.number < b.number;
+            return a.begin < b.begin;
+        });
+
+        std::uint64_t position = 0;
+        auto emit = [&sink, &position](const std::string& text) {
+            sink.write(text.data(), text.size());
+            position += text.size();
+        };
+        auto copy = [&sink, &source, &position](std::uint64_t offset, std::uint64_t length) {
+            sink.copy_from(source, offset, length);
+            position += length;
+        };
+
+        emit(pdf_header(source) + "\n%\xE2\xE3\xCF\xD3\n");
+
+        std::map<std::uint32_t, std::pair<std::uint64_t, std::uint32_t>> offsets;
+        for (const auto& object : objects) {
+            offsets[object.number] = {position, object.generation};
+            const std::string header = std::to_string(object.number) + " " + std::to_string(object.generation) + " obj\n";
+
+            const auto removed = plan.removed_keys.find(object.number);
+            if (removed != plan.removed_keys.end() && object.object.is_dictionary()) {
+                emit(header + write_dictionary(reader, object, object.object, removed->second));
+                if (object.has_stream) {
+                    emit("\nstream\n");
+                    copy(object.stream_offset, object.stream_length);
+                    emit("\nendstream");
+                }
+                emit("\nendobj\n");
+            } else if (object.compressed) {
+                emit(header + reader.read_raw(object, object.object) + "\nendobj\n");
+            } else {
+                copy(object.begin, object.end - object.begin);
+                emit("\n");
+            }
+        }
+
+        // Cross-reference table with one subsection per run of consecutive objects
+        const std::uint64_t xref_offset = position;
+        std::string xref = "xref\n0 1\n" + xref_row(0, 65535, 'f');
+        for (auto it = offsets.begin(); it != offsets.end();) {
+            auto run_end = it;
+            std::uint32_t count = 0;
+            while (run_end != offsets.end() && run_end->first == it->first + count) {
+                ++run_end;
+                count++;
+            }
+            xref += std::to_string(it->first) + " " + std::to_string(count) + "\n";
+            for (; it != run_end; ++it) {
+                xref += xref_row(it->second.first, it->second.second, 'n');
+            }
+        }
+        emit(xref);
+
+        const std::uint32_t new_size = offsets.empty() ? 1 : offsets.rbegin()->first + 1;
+        std::string trailer_text = "trailer\n<</Size " + std::to_string(new_size);
+        for (const auto& [key, entry] : trailer.entries) {
+            if (structural_trailer_keys.count(key) > 0 || plan.removed_trailer_keys.count(key) > 0) {
+                continue;
+            }
+            trailer_text += encode_name(key) + " " + reader.read_raw(indirect_object{}, entry);
+        }
+        trailer_text += ">>\nstartxref\n" + std::to_string(xref_offset) + "\n%%EOF\n";
+        emit(trailer_text);
+
+        return objects.size();
+    }
+
+    std::string decode_text_string(const std::string& raw) {
+        std::string out;
+
+        if (raw.size() >= 2 && static_cast<unsigned char>(raw[0]) == 0xFE && static_cast<unsigned char>(raw[1]) == 0xFF) {
+            for (std::size_t i = 2; i + 1 < raw.size(); i += 2) {
+                std::uint32_t unit = (static_cast<unsigned char>(raw[i]) << 8) | static_cast<unsigned char>(raw[i + 1]);
+                if (unit >= 0xD800 && unit < 0xDC00 && i + 3 < raw.size()) {
+                    const std::uint32_t low = (static_cast<unsigned char>(raw[i + 2]) << 8) | static_cast<unsigned char>(raw[i + 3]);
+                    if (low >= 0xDC00 && low < 0xE000) {
+                        unit = 0x10000 + ((unit - 0xD800) << 10) + (low - 0xDC00);
+                        i += 2;
+                    }
+                }
+                append_utf8(out, unit);
+            }
+            return out;
+        }
+
+        if (raw.size() >= 3 && raw.compare(0, 3, "\xEF\xBB\xBF") == 0) {
+            return raw.substr(3);
+        }
+
+        for (const char c : raw) {
+            const auto byte = static_cast<unsigned char>(c);
+            if (byte >= 0x18 && byte <= 0x1F) {
+                append_utf8(out, pdf_doc_low[byte - 0x18]);
+            } else if (byte >= 0x80 && byte <= 0xA0) {
+                append_utf8(out, pdf_doc_high[byte - 0x80]);
+            } else {
+                append_utf8(out, byte);
+            }
+        }
+        return out;
+    }
+
+}
@@ -0,0 +1,168 @@
+/**
+ * @file png_chunks.cpp
+ * @brief Implementation of chunk-level PNG parsing and stripping
+ */
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <zlib.h>
+#include "./processors/png_chunks.h"
+
+namespace png_chunks {
+
+    namespace {
+
+        const unsigned char signature[signature_size] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+        // The PNG specification limits chunk lengths to 2^31 - 1
+        constexpr std::uint32_t max_chunk_length = 0x7FFFFFFF;
+
+        std::uint32_t get32(const unsigned char* p) {
+            return (static_cast<std::uint32_t>(p[0]) << 24) | (static_cast<std::uint32_t>(p[1]) << 16) |
+                   (static_cast<std::uint32_t>(p[2]) << 8) | p[3];
+        }
+
+        void put32(unsigned char* p, std::uint32_t value) {
+            p[0] = static_cast<unsigned char>(value >> 24);
+            p[1] = static_cast<unsigned char>(value >> 16);
+            p[2] = static_cast<unsigned char>(value >> 8);
+            p[3] = static_cast<unsigned char>(value);
+        }
+
+        bool is_type_char(unsigned char c) {
+            return (c >= 'A' && c <= 'Z') || (c >= 'a' && c <= 'z');
+        }
+
+    }
+
+    bool has_signature(const unsigned char* data, std::size_t size) {
+        return size >= signature_size && std::memcmp(data, signature, signature_size) == 0;
+    }
+
+    bool is_metadata(const chunk& c) {
+        return c.type == "tEXt" || c.type == "zTXt" || c.type == "iTXt" || c.type == "eXIf" || c.type == "tIME";
+    }
+
+    std::uint64_t walk(const file_io::byte_source& source, const std::function<void(const chunk&)>& callback) {
+        const std::uint64_t size = source.size();
+        unsigned char buffer[signature_size];
+
+        if (source.read_at(0, buffer, signature_size) != signature_size || !has_signature(buffer, signature_size)) {
+            throw std::runtime_error("Missing PNG signature");
+        }
+
+        std::uint64_t offset = signature_size;
+        while (offset < size) {
+            if (source.read_at(offset, buffer, 8) != 8) {
+                throw std::runtime_error("Truncated PNG chunk header at offset " + std::to_string(offset));
+            }
+
+            chunk c;
+            c.length = get32(buffer);
+            c.type.assign(reinterpret_cast<const char*>(buffer + 4), 4);
+            c.offset = offset;
+            c.data_offset = offset + 8;
+            if (c.length > max_chunk_length || !is_type_char(buffer[4]) || !is_type_char(buffer[5]) ||
+                !is_type_char(buffer[6]) || !is_type_char(buffer[7])) {
+                throw std::runtime_error("Invalid PNG chunk at offset " + std::to_string(offset));
+            }
+            if (c.size() > size - offset) {
+                throw std::runtime_error("Truncated PNG chunk " + c.type + " at offset " + std::to_string(offset));
+            }
+
+            callback(c);
+            offset += c.size();
+            if (c.type == "IEND") {
+                return offset;
+            }
+        }
+
+        return size;
+    }
+
+    std::uint32_t chunk_crc(const std::string& type, const unsigned char* data, std::size_t size) {
+        uLong crc = crc32(0L, Z_NULL, 0);
+        crc = crc32(crc, reinterpret_cast<const Bytef*>(type.data()), 4);
+        // zlib takes 32-bit lengths, feed large chunks in pieces
+        while (size > 0) {
+            const auto piece = static_cast<uInt>(std::min<std::size_t>(size, 1u << 30));
+            crc = crc32(crc, data, piece);
+            data += piece;
+            size -= piece;
+        }
+        return static_cast<std::uint32_t>(crc);
+    }
+
+    void write_chunk(file_io::byte_sink& sink, const std::string& type, const unsigned char* data, std::size_t size) {
+        if (type.size() != 4 || size > max_chunk_length) {
+            throw std::invalid_argument("Invalid PNG chunk " + type);
+        }
+        unsigned char header[8];
+        put32(header, static_cast<std::uint32_t>(size));
+        std::memcpy(header + 4, type.data(), 4);
+        unsigned char trailer[4];
+        put32(trailer, chunk_crc(type, data, size));
+
+        sink.write(header, sizeof(header));
+        if (size > 0) {
+            sink.write(data, size);
+        }
+        sink.write(trailer, sizeof(trailer));
+    }
+
+    std::size_t rewrite(const file_io::byte_source& source, file_io::byte_sink& sink,
+                        const std::function<chunk_action(const chunk&, std::vector<unsigned char>&)>& edit,
+                        const std::function<void(file_io::byte_sink&)>& insert) {
+        // Adjacent chunks that are kept are copied as one range, starting with the signature
+        std::uint64_t run_start = 0;
+        std::uint64_t run_end = signature_size;
+        std::size_t edited = 0;
+        bool inserted = !insert;
+        std::vector<unsigned char> replacement;
+
+        const auto flush_run = [&]() {
+            if (run_end > run_start) {
+                sink.copy_from(source, run_start, run_end - run_start);
+            }
+        };
+
+        walk(source, [&](const chunk& c) {
+            if (!inserted && (c.type == "IDAT" || c.type == "IEND")) {
+                flush_run();
+                insert(sink);
+                inserted = true;
+                run_start = c.offset;
+                run_end = c.offset;
+            }
+            const chunk_action action = c.type == "IEND" ? chunk_action::KEEP : edit(c, replacement);
+            if (action != chunk_action::KEEP) {
+                edited++;
+                flush_run();
+                if (action == chunk_action::REPLACE) {
+                    write_chunk(sink, c.type, replacement.data(), replacement.size());
+                }
+                run_start = c.offset + c.size();
+                run_end = run_start;
+                replacement.clear();
+                return;
+            }
+            if (c.offset != run_end) {
+                flush_run();
+                run_start = c.offset;
+            }
+            run_end = c.offset + c.size();
+        });
+
+        flush_run();
+        return edited;
+    }
+
+    std::size_t strip(const file_io::byte_source& source, file_io::byte_sink& sink,
+                      const std::function<bool(const chunk&)>& remove,
+                      const std::function<void(file_io::byte_sink&)>& insert) {
+        return rewrite(source, sink, [&remove](const chunk& c, std::vector<unsigned char>&) {
+            return remove(c) ? chunk_action::REMOVE : chunk_action::KEEP;
+        }, insert);
+    }
+
+}
@@ -0,0 +1,605 @@
+/**
+ * @file png_processor.cpp
+ * @brief Implementation of the PNG metadata processor
+ */
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <stdexcept>
+#include <exiv2/exiv2.hpp>
+#include <zlib.h>
+#include "./processors/png_processor.h"
+#include "./processors/tiff_ifd.h"
+
+namespace png_processor {
+
+    namespace {
+
+        const std::string xmp_keyword = "XML:com.adobe.xmp";
+        const std::string time_key = "Time.LastModified";
+
+        // Text chunks are tiny, anything inflating beyond this is not worth reporting
+        constexpr std::size_t max_text_size = 16 * 1024 * 1024;
+
+        /**
+         * @brief Decoded content of a tEXt, zTXt or iTXt chunk
+         */
+        struct text_chunk {
+            std::string keyword;
+            std::string text;       // UTF-8
+        };
+
+        std::vector<unsigned char> read_chunk(const file_io::byte_source& source, const png_chunks::chunk& c) {
+            std::vector<unsigned char> data(c.length);
+            if (c.length > 0) {
+                source.read_exact(c.data_offset, data.data(), data.size());
+            }
+            return data;
+        }
+
+        std::string latin1_to_utf8(const unsigned char* data, std::size_t size) {
+            std::string text;
+            text.reserve(size);
+            for (std::size_t i = 0; i < size; i++) {
+                if (data[i] < 0x80) {
+                    text += static_cast<char>(data[i]);
+                } else {
+                    text += static_cast<char>(0xC0 | (data[i] >> 6));
+                    text += static_cast<char>(0x80 | (data[i] & 0x3F));
+                }
+            }
+            return text;
+        }
+
+        std::string inflate_text(const unsigned char* data, std::size_t size) {
+            z_stream stream {};
+            if (inflateInit(&stream) != Z_OK) {
+                throw std::runtime_error("Failed to initialise zlib");
+            }
+            stream.next_in = const_cast<Bytef*>(data);
+            stream.avail_in = static_cast<uInt>(size);
+
+            std::string text;
+            unsigned char buffer[16384];
+            int status = Z_OK;
+            while (status != Z_STREAM_END) {
+                stream.next_out = buffer;
+                stream.avail_out = sizeof(buffer);
+                status = inflate(&stream, Z_NO_FLUSH);
+                if (status != Z_OK && status != Z_STREAM_END) {
+                    inflateEnd(&stream);
+                    throw std::runtime_error("Corrupt compressed PNG text");
+                }
+                text.append(reinterpret_cast<const char*>(buffer), sizeof(buffer) - stream.avail_out);
+                if (text.size() > max_text_size) {
+                    inflateEnd(&stream);
+                    throw std::runtime_error("Compressed PNG text is too large");
+                }
+                if (status == Z_OK && stream.avail_in == 0 && stream.avail_out != 0) {
+                    break;
+                }
+            }
+            inflateEnd(&stream);
+            return text;
+        }
+
+        /**
+         * @brief Decode a text chunk
+         * @return False if the chunk is not a text chunk or is malformed, corrupt compressed text included
+         */
+        bool decode_text(const png_chunks::chunk& c, const std::vector<unsigned char>& data, text_chunk& out) {
+            const auto* begin = data.data();
+            const auto* end = begin + data.size();
+            const auto* keyword_end = std::find(begin, end, 0);
+            if (keyword_end == end || keyword_end == begin) {
+                return false;
+            }
+            out.keyword = latin1_to_utf8(begin, static_cast<std::size_t>(keyword_end - begin));
+            const auto* p = keyword_end + 1;
+
+            if (c.type == "tEXt") {
+                out.text = latin1_to_utf8(p, static_cast<std::size_t>(end - p));
+                return true;
+            }
+            if (c.type == "zTXt") {
+                // Compression method byte, 0 is the only one defined
+                if (p == end || *p != 0) {
+                    return false;
+                }
+                std::string raw;
+                try {
+                    raw = inflate_text(p + 1, static_cast<std::size_t>(end - p - 1));
+                } catch (const std::runtime_error&) {
+                    return false;
+                }
+                out.text = latin1_to_utf8(reinterpret_cast<const unsigned char*>(raw.data()), raw.size());
+                return true;
+            }
+            if (c.type == "iTXt") {
+                if (end - p < 2) {
+                    return false;
+                }
+                const bool compressed = p[0] != 0;
+                p += 2;
+                // Language tag and translated keyword are not reported
+                for (int field = 0; field < 2; field++) {
+                    p = std::find(p, end, 0);
+                    if (p == end) {
+                        return false;
+                    }
+                    p++;
+                }
+                if (!compressed) {
+                    out.text.assign(reinterpret_cast<const char*>(p), static_cast<std::size_t>(end - p));
+                    return true;
+                }
+                try {
+                    out.text = inflate_text(p, static_cast<std::size_t>(end - p));
+                } catch (const std::runtime_error&) {
+                    return false;
+                }
+                return true;
+            }
+            return false;
+        }
+
+        std::string format_time(const std::vector<unsigned char>& data) {
+            if (data.size() != 7) {
+                return {};
+            }
+            char text[32];
+            std::snprintf(text, sizeof(text), "%04u-%02u-%02u %02u:%02u:%02u",
+                          (static_cast<unsigned>(data[0]) << 8) | data[1], data[2], data[3], data[4], data[5], data[6]);
+            return text;
+        }
+
+        /**
+         * @brief Check if a keyword can be stored, 1 to 79 Latin-1 characters without surrounding spaces
+         */
+        bool valid_keyword(const std::string& keyword) {
+            if (keyword.empty() || keyword.size() > 79 || keyword.front() == ' ' || keyword.back() == ' ') {
+                return false;
+            }
+            return std::all_of(keyword.begin(), keyword.end(), [](char c) {
+                const auto u = static_cast<unsigned char>(c);
+                return u >= 0x20 && u < 0x7F;
+            });
+        }
+
+        /**
+         * @brief Build a text chunk, tEXt for ASCII values and uncompressed iTXt for anything else
+         */
+        void write_text(file_io::byte_sink& sink, const std::string& keyword, const std::string& text) {
+            const bool ascii = std::all_of(text.begin(), text.end(), [](char c) {
+                return static_cast<unsigned char>(c) < 0x80;
+            });
+
+            std::vector<unsigned char> data(keyword.begin(), keyword.end());
+            data.push_back(0);
+            if (!ascii) {
+                // Compression flag, method, empty language tag and translated keyword
+                data.insert(data.end(), {0, 0, 0, 0});
+            }
+            data.insert(data.end(), text.begin(), text.end());
+            png_chunks::write_chunk(sink, ascii ? "tEXt" : "iTXt", data.data(), data.size());
+        }
+
+        std::vector<unsigned char> build_xmp_chunk(const std::string& packet) {
+            std::vector<unsigned char> data(xmp_keyword.begin(), xmp_keyword.end());
+            data.insert(data.end(), {0, 0, 0, 0, 0});
+            data.insert(data.end(), packet.begin(), packet.end());
+            return data;
+        }
+
+    }
+
+    png_processor_class::png_processor_class(const std::string& path,
+                                             file_handler::operation_type type,
+                                             file_handler::shared_options opts,
+                                             file_properties::file_type_probe probe,
+                                             file_handler::buffer_binding buffers)
+            : file_handler_class(path, type, std::move(opts), std::move(probe), buffers) {}
+
+    png_processor_class::~png_processor_class() = default;
+
+    file_handler::operation_result png_processor_class::check_prerequisites() {
+        // The header was read once when the file type was probed
+        if (file_header.empty()) {
+            return {false, "Failed to read file header", {}, {}};
+        }
+        if (!png_chunks::has_signature(file_header.data(), file_header.size())) {
+            return {false, "File is not a valid PNG", {}, {}};
+        }
+        return {true, "PNG file is valid", {}, {}};
+    }
+
+    file_handler::operation_result png_processor_class::read_metadata() {
+        file_handler::operation_result result;
+        result.success = true;
+        result.message = "Metadata successfully read";
+
+        try {
+            auto in = open_input();
+            std::size_t text_count = 0;
+            std::size_t exif_count = 0;
+            std::size_t xmp_count = 0;
+
+            png_chunks::walk(*in, [&](const png_chunks::chunk& c) {
+                if (!png_chunks::is_metadata(c)) {
+                    return;
+                }
+                const auto data = read_chunk(*in, c);
+
+                if (c.type == "tIME") {
+                    result.metadata.set(time_key, format_time(data));
+                } else if (c.type == "eXIf") {
+                    Exiv2::ExifData exif_data;
+                    Exiv2::ExifParser::decode(exif_data, data.data(), data.size());
+                    for (const auto& exif : exif_data) {
+                        result.metadata.set("EXIF.", exif.key(), exif.toString());
+                        exif_count++;
+                    }
+                } else {
+                    text_chunk text;
+                    if (!decode_text(c, data, text)) {
+                        result.warnings.push_back("Malformed " + c.type + " chunk at offset " + std::to_string(c.offset));
+                    } else if (c.type == "iTXt" && text.keyword == xmp_keyword) {
+                        Exiv2::XmpData xmp_data;
+                        Exiv2::XmpParser::decode(xmp_data, text.text);
+                        for (const auto& xmp : xmp_data) {
+                            result.metadata.set("XMP.", xmp.key(), xmp.toString());
+                            xmp_count++;
+                        }
+                    } else {
+                        result.metadata.set("Text.", text.keyword, text.text);
+                        text_count++;
+                    }
+                }
+            });
+
+            result.metadata.set("Total.Text", std::to_string(text_count));
+            result.metadata.set("Total.EXIF", std::to_string(exif_count));
+            result.metadata.set("Total.XMP", std::to_string(xmp_count));
+
+        } catch (const Exiv2::Error& e) {
+            result.success = false;
+            result.message = "Failed to read metadata: " + std::string(e.what());
+        } catch (const std::exception& e) {
+            result.success = false;
+            result.message = "Exception: " + std::string(e.what());
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief Copy the PNG without its metadata chunks and atomically replace the file or output buffer
+     */
+    file_handler::operation_result png_processor_class::clean_metadata() {
+        if (has_selection()) {
+            return clean_selected_metadata();
+        }
+
+        file_handler::operation_result result;
+        result.success = true;
+        result.message = "Metadata successfully cleaned";
+
+        try {
+            auto in = open_input();
+
+            // A file without metadata is left untouched when it would be replaced by an identical copy
+            if (!in_memory() && get_output_path() == std::filesystem::path(file_path)) {
+                bool has_metadata = false;
+                png_chunks::walk(*in, [&](const png_chunks::chunk& c) {
+                    has_metadata = has_metadata || png_chunks::is_metadata(c);
+                });
+                if (!has_metadata) {
+                    return result;
+                }
+            }
+
+            auto out = open_output();
+            png_chunks::strip(*in, *out);
+            in.reset();
+            out->commit();
+
+        } catch (const std::exception& e) {
+            result.success = false;
+            result.message = "Failed to clean metadata: " + std::string(e.what());
+            std::cerr << "Standard exception: " << e.what() << std::endl;
+        }
+
+        return result;
+    }
+
+    png_chunks::chunk_action png_processor_class::edit_selected(const file_io::byte_source& source,
+                                                                const png_chunks::chunk& c,
+                                                                std::vector<unsigned char>& data,
+                                                                std::vector<std::string>& warnings) const {
+        if (!png_chunks::is_metadata(c)) {
+            return png_chunks::chunk_action::KEEP;
+        }
+        const auto content = read_chunk(source, c);
+
+        if (c.type == "tIME") {
+            return is_selected(time_key) ? png_chunks::chunk_action::REMOVE : png_chunks::chunk_action::KEEP;
+        }
+
+        if (c.type == "eXIf") {
+            Exiv2::ExifData exif_data;
+            const Exiv2::ByteOrder byte_order = Exiv2::ExifParser::decode(exif_data, content.data(), content.size());
+
+            std::set<tiff_ifd::tag_ref> tags;
+            bool supported = true;
+            std::size_t selected = 0;
+            for (const auto& exif : exif_data) {
+                if (is_selected("EXIF." + exif.key())) {
+                    tags.emplace(exif.groupName(), exif.tag());
+                    supported = supported && tiff_ifd::is_supported_group(exif.groupName());
+                    selected++;
+                }
+            }
+            if (selected == 0) {
+                return png_chunks::chunk_action::KEEP;
+            }
+            if (selected == static_cast<std::size_t>(exif_data.count())) {
+                return png_chunks::chunk_action::REMOVE;
+            }
+
+            if (supported) {
+                // Same removal as for JPEG, the chunk keeps its size and only needs a new CRC
+                data = content;
+                tiff_ifd::remove_entries(data.data(), data.size(), tags);
+            } else {
+                for (auto it = exif_data.begin(); it != exif_data.end();) {
+                    it = is_selected("EXIF." + it->key()) ? exif_data.erase(it) : std::next(it);
+                }
+                Exiv2::Blob blob;
+                Exiv2::ExifParser::encode(blob, byte_order, exif_data);
+                data.assign(blob.begin(), blob.end());
+            }
+            return png_chunks::chunk_action::REPLACE;
+        }
+
+        text_chunk text;
+        if (!decode_text(c, content, text)) {
+            warnings.push_back("Malformed " + c.type + " chunk at offset " + std::to_string(c.offset) + " was kept");
+            return png_chunks::chunk_action::KEEP;
+        }
+        if (c.type != "iTXt" || text.keyword != xmp_keyword) {
+            return is_selected("Text." + text.keyword) ? png_chunks::chunk_action::REMOVE
+                                                       : png_chunks::chunk_action::KEEP;
+        }
+
+        Exiv2::XmpData xmp_data;
+        Exiv2::XmpParser::decode(xmp_data, text.text);
+        const long total = xmp_data.count();
+        for (auto it = xmp_data.begin(); it != xmp_data.end();) {
+            it = is_selected("XMP." + it->key()) ? xmp_data.erase(it) : std::next(it);
+        }
+        if (xmp_data.count() == total) {
+            return png_chunks::chunk_action::KEEP;
+        }
+        if (xmp_data.empty()) {
+            return png_chunks::chunk_action::REMOVE;
+        }
+        std::string packet;
+        if (Exiv2::XmpParser::encode(packet, xmp_data) != 0) {
+            throw std::runtime_error("Failed to encode XMP packet");
+        }
+        data = build_xmp_chunk(packet);
+        return png_chunks::chunk_action::REPLACE;
+    }
+
+    /**
+     * @brief Remove only the selected keys
+     *
+     * Text and tIME chunks are dropped whole. eXIf and XMP chunks that keep
+     * some entries are rewritten, only their CRC is computed again.
+     */
+    file_handler::operation_result png_processor_class::clean_selected_metadata() {
+        file_handler::operation_result result;
+        result.success = true;
+        result.message = "Selected metadata successfully removed";
+
+        try {
+            auto in = open_input();
+
+            // Decide on every chunk first, so an untouched file is not rewritten
+            std::map<std::uint64_t, std::pair<png_chunks::chunk_action, std::vector<unsigned char>>> edits;
+            png_chunks::walk(*in, [&](const png_chunks::chunk& c) {
+                std::vector<unsigned char> data;
+                const auto action = edit_selected(*in, c, data, result.warnings);
+                if (action != png_chunks::chunk_action::KEEP) {
+                    edits.emplace(c.offset, std::make_pair(action, std::move(data)));
+                }
+            });
+            if (edits.empty() && !in_memory() && get_output_path() == std::filesystem::path(file_path)) {
+                return result;
+            }
+
+            auto out = open_output();
+            png_chunks::rewrite(*in, *out, [&](const png_chunks::chunk& c, std::vector<unsigned char>& data) {
+                const auto it = edits.find(c.offset);
+                if (it == edits.end()) {
+                    return png_chunks::chunk_action::KEEP;
+                }
+                data = std::move(it->second.second);
+                return it->second.first;
+            });
+            in.reset();
+            out->commit();
+
+        } catch (const Exiv2::Error& e) {
+            result.success = false;
+            result.message = "Failed to remove selected metadata: " + std::string(e.what());
+            std::cerr << "Exiv2 error: " << e.what() << std::endl;
+        } catch (const std::exception& e) {
+            result.success = false;
+            result.message = "Failed to remove selected metadata: " + std::string(e.what());
+            std::cerr << "Standard exception: " << e.what() << std::endl;
+        }
+
+        return result;
+    }
+
+    /**
+     * @brief Replace all metadata chunks with the values from the options
+     *
+     * "Text.<keyword>" keys and the common fields become text chunks, "EXIF."
+     * keys an eXIf chunk and "XMP." keys an XMP packet.
+     */
+    file_handler::operation_result png_processor_class::overwrite_metadata() {
+        file_handler::operation_result result;
+        result.success = true;
+        result.message = "Metadata successfully overwritten";
+
+        try {
+            std::vector<std::pair<std::string, std::string>> texts;
+            Exiv2::ExifData exif_data;
+            Exiv2::XmpData xmp_data;
+
+            for (const auto& [key, value] : options.overwrite_metadata) {
+                if (key.empty() || value.empty()) {
+                    continue;
+                }
+
+                if (key.compare(0, 5, "Text.") == 0) {
+                    texts.emplace_back(key.substr(5), value);
+                } else if (key.compare(0, 5, "EXIF.") == 0) {
+                    exif_data[key.substr(5)] = value;
+                } else if (key.compare(0, 4, "XMP.") == 0) {
+                    xmp_data[key.substr(4)] = value;
+                } else if (key == "Title" || key == "Author" || key == "Description" || key == "Copyright" ||
+                           key == "Software" || key == "Comment") {
+                    // Predefined PNG keywords
+                    texts.emplace_back(key, value);
+                } else if (key == "DateCreated") {
+                    texts.emplace_back("Creation Time", value);
+                } else {
+                    result.warnings.push_back("Unsupported metadata key for PNG: " + key);
+                }
+            }
+
+            std::vector<unsigned char> exif_chunk;
+            if (!exif_data.empty()) {
+                Exiv2::Blob blob;
+                Exiv2::ExifParser::encode(blob, Exiv2::bigEndian, exif_data);
+                exif_chunk.assign(blob.begin(), blob.end());
+            }
+            std::vector<unsigned char> xmp_chunk;
+            if (!xmp_data.empty()) {
+                std::string packet;
+                if (Exiv2::XmpParser::encode(packet, xmp_data) != 0) {
+                    throw std::runtime_error("Failed to encode XMP packet");
+                }
+                xmp_chunk = build_xmp_chunk(packet);
+            }
+
+            auto in = open_input();
+            auto out = open_output();
+            png_chunks::strip(*in, *out, png_chunks::is_metadata, [&](file_io::byte_sink& sink) {
+                for (const auto& [keyword, text] : texts) {
+                    if (!valid_keyword(keyword)) {
+                        result.warnings.push_back("Invalid PNG text keyword: " + keyword);
+                        continue;
+                    }
+                    write_text(sink, keyword, text);
+                }
+                if (!exif_chunk.empty()) {
+                    png_chunks::write_chunk(sink, "eXIf", exif_chunk.data(), exif_chunk.size());
+                }
+                if (!xmp_chunk.empty()) {
+                    png_chunks::write_chunk(sink, "iTXt", xmp_chunk.data(), xmp_chunk.size());
+                }
+            });
+            in.reset();
+            out->commit();
+
+        } catch (const Exiv2::Error& e) {
+            result.success = false;
+            result.message = "Failed to overwrite metadata: " + std::string(e.what());
+            std::cerr << "Exiv2 error: " << e.what() << std::endl;
+        } catch (const std::exception& e) {
+            result.success = false;
+            result.message = "Failed to overwrite metadata: " + std::string(e.what());
+            std::cerr << "Standard exception: " << e.what() << std::endl;
+        }
+
+        return result;
+    }
+
+    file_handler::operation_result png_processor_class::export_metadata() {
+        // First read the metadata
+        auto result = read_metadata();
+        if (!result.success) {
+            return result;
+        }
+
+        try {
+            // Create output directory if needed
+            if (!options.output_directory.empty() && !std::filesystem::exists(options.output_directory)) {
+                std::filesystem::create_directories(options.output_directory);
+            }
+
+            // Create output file path
+            std::filesystem::path output_path;
+            if (options.output_directory.empty()) {
+                output_path = std::filesystem::path(file_path).parent_path() /
+                             (std::filesystem::path(file_path).stem().string() + "_metadata.json");
+            } else {
+                output_path = options.output_directory /
+                             (std::filesystem::path(file_path).stem().string() + "_metadata.json");
+            }
+
+            // Write to output file
+            std::ofstream out(output_path);
+            if (!out) {
+                result.success = false;
+                result.message = "Failed to create output file: " + output_path.string();
+                return result;
+            }
+
+            // Write in JSON format
+            out << "{\n";
+            bool first = true;
+            for (const auto& [key, value] : result.metadata) {
+                if (!first) out << ",\n";
+                // Escape JSON special characters in the value
+                std::string escaped_value(value);
+                size_t pos = 0;
+                while ((pos = escaped_value.find("\"", pos)) != std::string::npos) {
+                    escaped_value.replace(pos, 1, "\\\"");
+                    pos += 2;
+                }
+                out << "  \"" << key << "\": \"" << escaped_value << "\"";
+                first = false;
+            }
+            out << "\n}";
+
+            out.close();
+
+            result.message = "Metadata successfully exported to: " + output_path.string();
+
+        } catch (const std::exception& e) {
+            result.success = false;
+            result.message = "Failed to export metadata: " + std::string(e.what());
+        }
+
+        return result;
+    }
+
+    file_handler::operation_result png_processor_class::restore_metadata() {
+        file_handler::operation_result result;
+        result.success = false;
+        result.message = "Restore operation not implemented for PNG";
+
+        return result;
+    }
+
+}
@@ -0,0 +1,34 @@
+/**
+ * @file pptx_processor.cpp
+ * @brief Implementation of PPTX processor
+ */
+#include <utility>
+#include "./processors/pptx_processor.h"
+
+namespace pptx_processor {
+
+    pptx_processor_class::pptx_processor_class(const std::string& path,
+                                              file_handler::operation_type type,
+                                              file_handler::shared_options opts,
+                                              file_properties::file_type_probe probe,
+                                              file_handler::buffer_binding buffers)
+            : ooxml_processor_class(path, type, std::move(opts), std::move(probe), buffers) {}
+
+    pptx_processor_class::~pptx_processor_class() = default;
+
+    const char* pptx_processor_class::format_name() const {
+        return "PPTX";
+    }
+
+    std::vector<std::string> pptx_processor_class::main_content_types() const {
+        return {
+            "application/vnd.openxmlformats-officedocument.presentationml.presentation.main+xml",
+            "application/vnd.openxmlformats-officedocument.presentationml.slideshow.main+xml",
+            "application/vnd.openxmlformats-officedocument.presentationml.template.main+xml",
+            "application/vnd.ms-powerpoint.presentation.macroEnabled.main+xml",
+            "application/vnd.ms-powerpoint.slideshow.macroEnabled.main+xml",
+            "application/vnd.ms-powerpoint.template.macroEnabled.main+xml"
+        };
+    }
+
+} // namespace pptx_processor
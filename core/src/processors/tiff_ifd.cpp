@@ -0,0 +1,223 @@
+/**
+ * @file tiff_ifd.cpp
+ * @brief Implementation of in-place TIFF IFD entry removal
+ */
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include "./processors/tiff_ifd.h"
+
+namespace tiff_ifd {
+
+    namespace {
+
+        constexpr std::uint16_t exif_ifd_tag = 0x8769;
+        constexpr std::uint16_t gps_ifd_tag = 0x8825;
+        constexpr std::uint16_t iop_ifd_tag = 0xA005;
+        constexpr std::uint16_t thumbnail_offset_tag = 0x0201;
+        constexpr std::uint16_t thumbnail_length_tag = 0x0202;
+        constexpr std::size_t entry_size = 12;
+
+        /**
+         * @brief Size of one value of a TIFF field type, 0 for unknown types
+         */
+        std::size_t type_size(std::uint16_t type) {
+            switch (type) {
+                case 1: case 2: case 6: case 7:
+                    return 1;
+                case 3: case 8:
+                    return 2;
+                case 4: case 9: case 11: case 13:
+                    return 4;
+                case 5: case 10: case 12:
+                    return 8;
+                default:
+                    return 0;
+            }
+        }
+
+        /**
+         * @brief Group of the sub-IFD a pointer tag leads to, empty if the tag is not a pointer
+         */
+        std::string sub_group(const std::string& group, std::uint16_t tag) {
+            if (group == "Image" && tag == exif_ifd_tag) {
+                return "Photo";
+            }
+            if (group == "Image" && tag == gps_ifd_tag) {
+                return "GPSInfo";
+            }
+            if (group == "Photo" && tag == iop_ifd_tag) {
+                return "Iop";
+            }
+            return {};
+        }
+
+        class tiff_editor {
+        public:
+            tiff_editor(unsigned char* data, std::size_t size, const std::set<tag_ref>& tags)
+                : data(data), size(size), tags(tags) {}
+
+            std::size_t run() {
+                check(0, 8);
+                if (data[0] == 'I' && data[1] == 'I') {
+                    little_endian = true;
+                } else if (data[0] == 'M' && data[1] == 'M') {
+                    little_endian = false;
+                } else {
+                    throw std::runtime_error("Invalid TIFF byte order mark");
+                }
+                if (get16(2) != 42) {
+                    throw std::runtime_error("Invalid TIFF magic number");
+                }
+
+                edit_ifd(get32(4), "Image", false);
+                return removed;
+            }
+
+        private:
+            void check(std::size_t offset, std::size_t length) const {
+                if (offset > size || length > size - offset) {
+                    throw std::runtime_error("TIFF data out of bounds at offset " + std::to_string(offset));
+                }
+            }
+
+            [[nodiscard]] bool in_bounds(std::size_t offset, std::size_t length) const {
+                return offset <= size && length <= size - offset;
+            }
+
+            [[nodiscard]] std::uint16_t get16(std::size_t offset) const {
+                return little_endian
+                    ? static_cast<std::uint16_t>(data[offset] | (data[offset + 1] << 8))
+                    : static_cast<std::uint16_t>((data[offset] << 8) | data[offset + 1]);
+            }
+
+            [[nodiscard]] std::uint32_t get32(std::size_t offset) const {
+                const std::uint32_t a = data[offset];
+                const std::uint32_t b = data[offset + 1];
+                const std::uint32_t c = data[offset + 2];
+                const std::uint32_t d = data[offset + 3];
+                return little_endian ? (d << 24) | (c << 16) | (b << 8) | a : (a << 24) | (b << 16) | (c << 8) | d;
+            }
+
+            void put16(std::size_t offset, std::uint16_t value) {
+                data[offset + (little_endian ? 0 : 1)] = static_cast<unsigned char>(value & 0xFF);
+                data[offset + (little_endian ? 1 : 0)] = static_cast<unsigned char>(value >> 8);
+            }
+
+            void put32(std::size_t offset, std::uint32_t value) {
+                for (int i = 0; i < 4; i++) {
+                    data[offset + (little_endian ? i : 3 - i)] = static_cast<unsigned char>((value >> (8 * i)) & 0xFF);
+                }
+            }
+
+            void zero(std::size_t offset, std::size_t length) {
+                if (in_bounds(offset, length)) {
+                    std::memset(data + offset, 0, length);
+                }
+            }
+
+            /**
+             * @brief Zero the out-of-line value of an entry, inline values go with the entry slot
+             */
+            void zero_value(std::size_t entry) {
+                const std::size_t length = type_size(get16(entry + 2)) * get32(entry + 4);
+                if (length > 4) {
+                    zero(get32(entry + 8), length);
+                }
+            }
+
+            void edit_ifd(std::uint32_t offset, const std::string& group, bool remove_all) {
+                // Offsets are shared between IFDs in broken files, never edit one twice
+                if (offset == 0 || !visited.insert(offset).second) {
+                    return;
+                }
+
+                check(offset, 2);
+                const std::size_t count = get16(offset);
+                const std::size_t entries = offset + 2;
+                check(entries, count * entry_size);
+
+                const std::size_t next_field = entries + count * entry_size;
+                const bool has_next = in_bounds(next_field, 4);
+                const std::uint32_t next = has_next ? get32(next_field) : 0;
+
+                std::vector<bool> drop(count, false);
+                std::size_t thumbnail_offset_entry = 0;
+                std::size_t thumbnail_length_entry = 0;
+                bool thumbnail_removed = false;
+
+                for (std::size_t i = 0; i < count; i++) {
+                    const std::size_t entry = entries + i * entry_size;
+                    const std::uint16_t tag = get16(entry);
+                    drop[i] = remove_all || tags.count({group, tag}) > 0;
+
+                    const std::string sub = sub_group(group, tag);
+                    if (!sub.empty()) {
+                        edit_ifd(get32(entry + 8), sub, drop[i]);
+                    }
+
+                    if (group == "Thumbnail" && (tag == thumbnail_offset_tag || tag == thumbnail_length_tag)) {
+                        (tag == thumbnail_offset_tag ? thumbnail_offset_entry : thumbnail_length_entry) = entry;
+                        thumbnail_removed = thumbnail_removed || drop[i];
+                    }
+                }
+
+                // The thumbnail is only referenced by these two entries, drop its bytes with them
+                if (thumbnail_removed && thumbnail_offset_entry != 0 && thumbnail_length_entry != 0) {
+                    const std::size_t length_type = get16(thumbnail_length_entry + 2);
+                    const std::uint32_t length = length_type == 3
+                        ? get16(thumbnail_length_entry + 8) : get32(thumbnail_length_entry + 8);
+                    zero(get32(thumbnail_offset_entry + 8), length);
+                }
+
+                // Move the kept entries up, the value data of the others is zeroed first
+                std::size_t kept = 0;
+                for (std::size_t i = 0; i < count; i++) {
+                    const std::size_t entry = entries + i * entry_size;
+                    if (drop[i]) {
+                        zero_value(entry);
+                        continue;
+                    }
+                    if (kept != i) {
+                        std::memmove(data + entries + kept * entry_size, data + entry, entry_size);
+                    }
+                    kept++;
+                }
+
+                if (kept != count) {
+                    put16(offset, static_cast<std::uint16_t>(kept));
+                    const std::size_t new_next_field = entries + kept * entry_size;
+                    if (has_next) {
+                        put32(new_next_field, next);
+                        zero(new_next_field + 4, next_field - new_next_field);
+                    } else {
+                        zero(new_next_field, next_field - new_next_field);
+                    }
+                    removed += count - kept;
+                }
+
+                // IFD0 links to the thumbnail IFD, other chains are not part of EXIF
+                if (group == "Image") {
+                    edit_ifd(next, "Thumbnail", false);
+                }
+            }
+
+            unsigned char* data;
+            std::size_t size;
+            const std::set<tag_ref>& tags;
+            bool little_endian {true};
+            std::set<std::uint32_t> visited;
+            std::size_t removed {0};
+        };
+
+    }
+
+    bool is_supported_group(const std::string& group) {
+        return group == "Image" || group == "Photo" || group == "GPSInfo" || group == "Iop" || group == "Thumbnail";
+    }
+
+    std::size_t remove_entries(unsigned char* data, std::size_t size, const std::set<tag_ref>& tags) {
+        return tiff_editor(data, size, tags).run();
+    }
+
+}
@@ -0,0 +1,32 @@
+/**
+ * @file xlsx_processor.cpp
+ * @brief Implementation of XLSX processor
+ */
+#include <utility>
+#include "./processors/xlsx_processor.h"
+
+namespace xlsx_processor {
+
+    xlsx_processor_class::xlsx_processor_class(const std::string& path,
+                                              file_handler::operation_type type,
+                                              file_handler::shared_options opts,
+                                              file_properties::file_type_probe probe,
+                                              file_handler::buffer_binding buffers)
+            : ooxml_processor_class(path, type, std::move(opts), std::move(probe), buffers) {}
+
+    xlsx_processor_class::~xlsx_processor_class() = default;
+
+    const char* xlsx_processor_class::format_name() const {
+        return "XLSX";
+    }
+
+    std::vector<std::string> xlsx_processor_class::main_content_types() const {
+        return {
+            "application/vnd.openxmlformats-officedocument.spreadsheetml.sheet.main+xml",
+            "application/vnd.openxmlformats-officedocument.spreadsheetml.template.main+xml",
+            "application/vnd.ms-excel.sheet.macroEnabled.main+xml",
+            "application/vnd.ms-excel.template.macroEnabled.main+xml"
+        };
+    }
+
+} // namespace xlsx_processor
@@ -0,0 +1,539 @@
+/**
+ * @file zip_entries.cpp
+ * @brief Implementation of entry-level ZIP archive rewriting
+ */
+#include <algorithm>
+#include <stdexcept>
+#include <zlib.h>
+#include "./processors/zip_entries.h"
+
+namespace zip_entries {
+
+    namespace {
+
+        constexpr std::uint32_t local_header_signature = 0x04034b50;
+        constexpr std::uint32_t central_header_signature = 0x02014b50;
+        constexpr std::uint32_t end_signature = 0x06054b50;
+        constexpr std::uint32_t zip64_end_signature = 0x06064b50;
+        constexpr std::uint32_t zip64_locator_signature = 0x07064b50;
+        constexpr std::uint16_t zip64_extra_id = 0x0001;
+
+        constexpr std::size_t local_header_size = 30;
+        constexpr std::size_t central_header_size = 46;
+        constexpr std::size_t end_size = 22;
+        constexpr std::size_t zip64_end_size = 56;
+        constexpr std::size_t zip64_locator_size = 20;
+        constexpr std::size_t max_comment_size = 0xFFFF;
+
+        // Sizes and offsets from this value on are moved into Zip64 fields
+        constexpr std::uint64_t max32 = 0xFFFFFFFF;
+        constexpr std::uint16_t max16 = 0xFFFF;
+
+        constexpr std::uint16_t method_stored = 0;
+        constexpr std::uint16_t method_deflated = 8;
+        constexpr std::uint16_t flag_encrypted = 0x0001;
+        constexpr std::uint16_t flag_data_descriptor = 0x0008;
+        constexpr std::uint16_t flag_utf8 = 0x0800;
+        constexpr std::uint16_t version_stored = 10;
+        constexpr std::uint16_t version_deflated = 20;
+        constexpr std::uint16_t version_zip64 = 45;
+
+        // zlib takes 32-bit lengths, feed large parts in pieces
+        constexpr std::size_t zlib_piece = 1u << 30;
+
+        std::uint16_t get16(const unsigned char* p) {
+            return static_cast<std::uint16_t>(p[0] | (p[1] << 8));
+        }
+
+        std::uint32_t get32(const unsigned char* p) {
+            return static_cast<std::uint32_t>(get16(p)) | (static_cast<std::uint32_t>(get16(p + 2)) << 16);
+        }
+
+        std::uint64_t get64(const unsigned char* p) {
+            return static_cast<std::uint64_t>(get32(p)) | (static_cast<std::uint64_t>(get32(p + 4)) << 32);
+        }
+
+        void put16(std::string& out, std::uint16_t value) {
+            out += static_cast<char>(value & 0xFF);
+            out += static_cast<char>(value >> 8);
+        }
+
+        void put32(std::string& out, std::uint32_t value) {
+            put16(out, static_cast<std::uint16_t>(value & 0xFFFF));
+            put16(out, static_cast<std::uint16_t>(value >> 16));
+        }
+
+        void put64(std::string& out, std::uint64_t value) {
+            put32(out, static_cast<std::uint32_t>(value & max32));
+            put32(out, static_cast<std::uint32_t>(value >> 32));
+        }
+
+        std::uint32_t clamp32(std::uint64_t value) {
+            return static_cast<std::uint32_t>(std::min(value, max32));
+        }
+
+        /**
+         * @brief Take the real values of saturated fields from a Zip64 extra field
+         */
+        void apply_zip64_extra(entry& e, const unsigned char* extra, std::size_t length) {
+            std::size_t at = 0;
+            while (at + 4 <= length) {
+                const std::uint16_t id = get16(extra + at);
+                const std::size_t size = get16(extra + at + 2);
+                at += 4;
+                if (at + size > length) {
+                    break;
+                }
+                if (id == zip64_extra_id) {
+                    // Only the fields saturated in the fixed record are present, in this order
+                    std::size_t field = at;
+                    const std::size_t end = at + size;
+                    for (std::uint64_t* value : {&e.size, &e.compressed_size, &e.header_offset}) {
+                        if (*value == max32) {
+                            if (field + 8 > end) {
+                                throw std::runtime_error("Truncated Zip64 field of " + e.name);
+                            }
+                            *value = get64(extra + field);
+                            field += 8;
+                        }
+                    }
+                    return;
+                }
+                at += size;
+            }
+        }
+
+        /**
+         * @brief Find the data of an entry behind its local header
+         */
+        std::uint64_t data_offset(const file_io::byte_source& source, const entry& e) {
+            unsigned char header[local_header_size];
+            source.read_exact(e.header_offset, header, sizeof(header));
+            if (get32(header) != local_header_signature) {
+                throw std::runtime_error("Invalid local header of " + e.name);
+            }
+            const std::uint64_t offset = e.header_offset + local_header_size + get16(header + 26) + get16(header + 28);
+            if (offset > source.size() || e.compressed_size > source.size() - offset) {
+                throw std::runtime_error("Truncated data of " + e.name);
+            }
+            return offset;
+        }
+
+        std::uint32_t crc_of(const std::string& content) {
+            uLong crc = crc32(0L, Z_NULL, 0);
+            for (std::size_t at = 0; at < content.size(); at += zlib_piece) {
+                const auto piece = static_cast<uInt>(std::min(zlib_piece, content.size() - at));
+                crc = crc32(crc, reinterpret_cast<const Bytef*>(content.data() + at), piece);
+            }
+            return static_cast<std::uint32_t>(crc);
+        }
+
+        /**
+         * @brief Deflate without a zlib header, as ZIP stores it
+         */
+        std::string deflate_raw(const std::string& content, int level) {
+            z_stream stream {};
+            if (deflateInit2(&stream, level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK) {
+                throw std::runtime_error("Failed to initialise zlib");
+            }
+
+            std::string out;
+            out.reserve(content.size() / 4);
+            std::vector<unsigned char> buffer(64 * 1024);
+            std::size_t consumed = 0;
+            int status = Z_OK;
+            while (status != Z_STREAM_END) {
+                if (stream.avail_in == 0 && consumed < content.size()) {
+                    const std::size_t piece = std::min(zlib_piece, content.size() - consumed);
+                    stream.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(content.data() + consumed));
+                    stream.avail_in = static_cast<uInt>(piece);
+                    consumed += piece;
+                }
+                stream.next_out = buffer.data();
+                stream.avail_out = static_cast<uInt>(buffer.size());
+                status = deflate(&stream, consumed == content.size() ? Z_FINISH : Z_NO_FLUSH);
+                if (status == Z_STREAM_ERROR) {
+                    deflateEnd(&stream);
+                    throw std::runtime_error("Failed to deflate archive entry");
+                }
+                out.append(reinterpret_cast<const char*>(buffer.data()), buffer.size() - stream.avail_out);
+            }
+
+            deflateEnd(&stream);
+            return out;
+        }
+
+        /**
+         * @brief Inflate raw deflate data, failing once the output passes the expected size
+         */
+        std::string inflate_raw(const unsigned char* data, std::uint64_t length, std::uint64_t expected) {
+            z_stream stream {};
+            if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+                throw std::runtime_error("Failed to initialise zlib");
+            }
+
+            // Deflate expands at most about 1032:1, do not trust a larger declared size up front
+            std::string out;
+            out.reserve(static_cast<std::size_t>(std::min(expected, length * 1032 + 64)));
+            std::vector<unsigned char> buffer(64 * 1024);
+            std::uint64_t consumed = 0;
+            int status = Z_OK;
+            while (status != Z_STREAM_END) {
+                if (stream.avail_in == 0 && consumed < length) {
+                    const auto piece = static_cast<std::size_t>(std::min<std::uint64_t>(zlib_piece, length - consumed));
+                    stream.next_in = const_cast<Bytef*>(data + consumed);
+                    stream.avail_in = static_cast<uInt>(piece);
+                    consumed += piece;
+                }
+                stream.next_out = buffer.data();
+                stream.avail_out = static_cast<uInt>(buffer.size());
+                status = inflate(&stream, Z_NO_FLUSH);
+                if (status != Z_OK && status != Z_STREAM_END) {
+                    inflateEnd(&stream);
+                    throw std::runtime_error("Corrupt or truncated deflate data");
+                }
+                out.append(reinterpret_cast<const char*>(buffer.data()), buffer.size() - stream.avail_out);
+                if (out.size() > expected) {
+                    inflateEnd(&stream);
+                    throw std::runtime_error("Deflate data is larger than its entry");
+                }
+            }
+
+            inflateEnd(&stream);
+            return out;
+        }
+
+        /**
+         * @brief Replaced or added entry with its compressed data
+         */
+        struct compressed_entry {
+            entry header;
+            const std::string* content {nullptr};
+            std::string data;       // empty when the content is stored as is
+        };
+
+        void compress(compressed_entry& job, int level) {
+            job.header.crc = crc_of(*job.content);
+            job.header.size = job.content->size();
+            if (level != 0 && !job.content->empty()) {
+                job.data = deflate_raw(*job.content, level);
+            }
+            // Content that does not shrink is stored
+            if (job.data.empty() || job.data.size() >= job.content->size()) {
+                job.data.clear();
+                job.header.method = method_stored;
+                job.header.compressed_size = job.header.size;
+                job.header.version_needed = std::max(job.header.version_needed, version_stored);
+            } else {
+                job.header.method = method_deflated;
+                job.header.compressed_size = job.data.size();
+                job.header.version_needed = std::max(job.header.version_needed, version_deflated);
+            }
+            // Encryption, data descriptor and method-specific bits of the old entry do not describe the new data
+            job.header.flags = static_cast<std::uint16_t>(job.header.flags & flag_utf8);
+        }
+
+        void write_local_header(file_io::byte_sink& sink, const entry& e) {
+            const bool zip64 = e.size >= max32 || e.compressed_size >= max32;
+            std::string header;
+            put32(header, local_header_signature);
+            put16(header, zip64 ? std::max(e.version_needed, version_zip64) : e.version_needed);
+            put16(header, e.flags);
+            put16(header, e.method);
+            put16(header, e.time);
+            put16(header, e.date);
+            put32(header, e.crc);
+            put32(header, zip64 ? static_cast<std::uint32_t>(max32) : static_cast<std::uint32_t>(e.compressed_size));
+            put32(header, zip64 ? static_cast<std::uint32_t>(max32) : static_cast<std::uint32_t>(e.size));
+            put16(header, static_cast<std::uint16_t>(e.name.size()));
+            put16(header, zip64 ? 20 : 0);
+            header += e.name;
+            if (zip64) {
+                put16(header, zip64_extra_id);
+                put16(header, 16);
+                put64(header, e.size);
+                put64(header, e.compressed_size);
+            }
+            sink.write(header.data(), header.size());
+        }
+
+        void append_central_header(std::string& directory, const entry& e) {
+            std::string extra;
+            for (const std::uint64_t value : {e.size, e.compressed_size, e.header_offset}) {
+                if (value >= max32) {
+                    put64(extra, value);
+                }
+            }
+            if (!extra.empty()) {
+                const std::string fields = std::move(extra);
+                extra.clear();
+                put16(extra, zip64_extra_id);
+                put16(extra, static_cast<std::uint16_t>(fields.size()));
+                extra += fields;
+            }
+
+            put32(directory, central_header_signature);
+            put16(directory, e.version_made_by);
+            put16(directory, extra.empty() ? e.version_needed : std::max(e.version_needed, version_zip64));
+            put16(directory, e.flags);
+            put16(directory, e.method);
+            put16(directory, e.time);
+            put16(directory, e.date);
+            put32(directory, e.crc);
+            put32(directory, clamp32(e.compressed_size));
+            put32(directory, clamp32(e.size));
+            put16(directory, static_cast<std::uint16_t>(e.name.size()));
+            put16(directory, static_cast<std::uint16_t>(extra.size()));
+            put16(directory, 0);                    // comment length
+            put16(directory, 0);                    // disk number
+            put16(directory, 0);                    // internal attributes
+            put32(directory, e.external_attributes);
+            put32(directory, clamp32(e.header_offset));
+            directory += e.name;
+            directory += extra;
+        }
+
+        void append_end_records(std::string& out, std::uint64_t count, std::uint64_t directory_offset,
+                                std::uint64_t directory_size) {
+            if (count >= max16 || directory_offset >= max32 || directory_size >= max32) {
+                const std::uint64_t zip64_end_offset = directory_offset + directory_size;
+                put32(out, zip64_end_signature);
+                put64(out, zip64_end_size - 12);
+                put16(out, version_zip64);
+                put16(out, version_zip64);
+                put32(out, 0);                      // this disk
+                put32(out, 0);                      // directory disk
+                put64(out, count);
+                put64(out, count);
+                put64(out, directory_size);
+                put64(out, directory_offset);
+
+                put32(out, zip64_locator_signature);
+                put32(out, 0);
+                put64(out, zip64_end_offset);
+                put32(out, 1);                      // total disks
+            }
+
+            put32(out, end_signature);
+            put16(out, 0);
+            put16(out, 0);
+            put16(out, static_cast<std::uint16_t>(std::min<std::uint64_t>(count, max16)));
+            put16(out, static_cast<std::uint16_t>(std::min<std::uint64_t>(count, max16)));
+            put32(out, clamp32(directory_size));
+            put32(out, clamp32(directory_offset));
+            put16(out, 0);                          // comment length
+        }
+
+    }
+
+    std::vector<entry> read_directory(const file_io::byte_source& source) {
+        const std::uint64_t size = source.size();
+        if (size < end_size) {
+            throw std::runtime_error("Archive is too small");
+        }
+
+        // The end record sits before a comment of at most 64 KB, search it backwards
+        const std::size_t tail_size = static_cast<std::size_t>(std::min<std::uint64_t>(size, end_size + max_comment_size));
+        std::vector<unsigned char> tail(tail_size);
+        source.read_exact(size - tail_size, tail.data(), tail_size);
+
+        std::size_t end_at = tail_size - end_size + 1;
+        do {
+            end_at--;
+            if (get32(&tail[end_at]) == end_signature) {
+                break;
+            }
+        } while (end_at > 0);
+        if (get32(&tail[end_at]) != end_signature) {
+            throw std::runtime_error("Missing end of central directory record");
+        }
+
+        const unsigned char* end = &tail[end_at];
+        if (get16(end + 4) != 0 || get16(end + 6) != 0) {
+            throw std::runtime_error("Split archives are not supported");
+        }
+        std::uint64_t count = get16(end + 10);
+        std::uint64_t directory_size = get32(end + 12);
+        std::uint64_t directory_offset = get32(end + 16);
+        const std::uint64_t end_offset = size - tail_size + end_at;
+
+        // Saturated fields are found in the Zip64 end record the locator points at
+        if ((count == max16 || directory_size == max32 || directory_offset == max32) &&
+            end_offset >= zip64_locator_size) {
+            unsigned char locator[zip64_locator_size];
+            source.read_exact(end_offset - zip64_locator_size, locator, sizeof(locator));
+            if (get32(locator) == zip64_locator_signature) {
+                unsigned char record[zip64_end_size];
+                source.read_exact(get64(locator + 8), record, sizeof(record));
+                if (get32(record) != zip64_end_signature) {
+                    throw std::runtime_error("Invalid Zip64 end of central directory record");
+                }
+                count = get64(record + 32);
+                directory_size = get64(record + 40);
+                directory_offset = get64(record + 48);
+            }
+        }
+
+        if (directory_offset > end_offset || directory_size > end_offset - directory_offset ||
+            count > directory_size / central_header_size) {
+            throw std::runtime_error("Invalid central directory location");
+        }
+
+        std::vector<unsigned char> records(static_cast<std::size_t>(directory_size));
+        source.read_exact(directory_offset, records.data(), records.size());
+
+        std::vector<entry> entries;
+        entries.reserve(static_cast<std::size_t>(count));
+        std::size_t at = 0;
+        for (std::uint64_t i = 0; i < count; i++) {
+            if (at + central_header_size > records.size() || get32(&records[at]) != central_header_signature) {
+                throw std::runtime_error("Invalid central directory record " + std::to_string(i));
+            }
+            const unsigned char* record = &records[at];
+            const std::size_t name_length = get16(record + 28);
+            const std::size_t extra_length = get16(record + 30);
+            const std::size_t comment_length = get16(record + 32);
+            if (at + central_header_size + name_length + extra_length + comment_length > records.size()) {
+                throw std::runtime_error("Truncated central directory record " + std::to_string(i));
+            }
+
+            entry e;
+            e.version_made_by = get16(record + 4);
+            e.version_needed = get16(record + 6);
+            e.flags = get16(record + 8);
+            e.method = get16(record + 10);
+            e.time = get16(record + 12);
+            e.date = get16(record + 14);
+            e.crc = get32(record + 16);
+            e.compressed_size = get32(record + 20);
+            e.size = get32(record + 24);
+            e.external_attributes = get32(record + 38);
+            e.header_offset = get32(record + 42);
+            e.name.assign(reinterpret_cast<const char*>(record + central_header_size), name_length);
+            apply_zip64_extra(e, record + central_header_size + name_length, extra_length);
+
+            entries.push_back(std::move(e));
+            at += central_header_size + name_length + extra_length + comment_length;
+        }
+
+        return entries;
+    }
+
+    bool can_read(const entry& e) {
+        return (e.flags & flag_encrypted) == 0 && (e.method == method_stored || e.method == method_deflated);
+    }
+
+    std::string read_entry(const file_io::byte_source& source, const entry& e) {
+        if (!can_read(e)) {
+            throw std::runtime_error("Unsupported method or encryption of " + e.name);
+        }
+        const std::uint64_t offset = data_offset(source, e);
+
+        // A mapped source is read in place, anything else is copied once
+        const unsigned char* data = source.get_data();
+        std::vector<unsigned char> copy;
+        if (data != nullptr) {
+            data += offset;
+        } else {
+            copy.resize(static_cast<std::size_t>(e.compressed_size));
+            source.read_exact(offset, copy.data(), copy.size());
+            data = copy.data();
+        }
+
+        std::string content;
+        if (e.method == method_stored) {
+            content.assign(reinterpret_cast<const char*>(data), static_cast<std::size_t>(e.compressed_size));
+        } else {
+            try {
+                content = inflate_raw(data, e.compressed_size, e.size);
+            } catch (const std::runtime_error& error) {
+                throw std::runtime_error(std::string(error.what()) + " in " + e.name);
+            }
+        }
+        if (content.size() != e.size || crc_of(content) != e.crc) {
+            throw std::runtime_error("Size or CRC mismatch of " + e.name);
+        }
+        return content;
+    }
+
+    void rewrite(const file_io::byte_source& source, const std::vector<entry>& directory,
+                 const std::map<std::string, std::string>& replacements, const std::set<std::string>& removals,
+                 file_io::byte_sink& sink, const write_options& options) {
+
+        // Plan the output in directory order, added entries last
+        std::vector<compressed_entry> jobs;
+        std::vector<const entry*> kept;                 // nullptr marks the next job
+        std::set<std::string> seen;
+        for (const auto& e : directory) {
+            if (removals.count(e.name) > 0 || !seen.insert(e.name).second) {
+                continue;
+            }
+            if (const auto replacement = replacements.find(e.name); replacement != replacements.end()) {
+                compressed_entry job;
+                job.header = e;
+                job.content = &replacement->second;
+                jobs.push_back(std::move(job));
+                kept.push_back(nullptr);
+            } else {
+                kept.push_back(&e);
+            }
+        }
+        for (const auto& [name, content] : replacements) {
+            if (seen.count(name) == 0 && removals.count(name) == 0) {
+                compressed_entry job;
+                job.header.name = name;
+                job.header.flags = flag_utf8;
+                job.content = &content;
+                jobs.push_back(std::move(job));
+                kept.push_back(nullptr);
+            }
+        }
+
+        // Compression is independent per entry, only the writing below has to be in order
+        const int level = options.compression_level;
+        if (options.workers && jobs.size() > 1) {
+            options.workers->parallel_for(jobs.size(), [&](std::size_t i) { compress(jobs[i], level); });
+        } else {
+            for (auto& job : jobs) {
+                compress(job, level);
+            }
+        }
+
+        std::vector<entry> written;
+        written.reserve(kept.size());
+        std::uint64_t offset = 0;
+        std::size_t next_job = 0;
+        for (const entry* e : kept) {
+            entry header;
+            if (e) {
+                header = *e;
+                // Sizes and CRC go into the local header, a trailing data descriptor is not copied
+                header.flags = static_cast<std::uint16_t>(header.flags & ~flag_data_descriptor);
+            } else {
+                header = jobs[next_job].header;
+            }
+            header.header_offset = offset;
+            write_local_header(sink, header);
+
+            if (e) {
+                sink.copy_from(source, data_offset(source, *e), e->compressed_size);
+            } else {
+                const auto& job = jobs[next_job++];
+                const std::string& data = job.data.empty() ? *job.content : job.data;
+                sink.write(data.data(), data.size());
+            }
+
+            offset += local_header_size + header.name.size() +
+                      (header.size >= max32 || header.compressed_size >= max32 ? 20 : 0) + header.compressed_size;
+            written.push_back(std::move(header));
+        }
+
+        std::string records;
+        for (const auto& e : written) {
+            append_central_header(records, e);
+        }
+        append_end_records(records, written.size(), offset, records.size());
+        sink.write(records.data(), records.size());
+    }
+
+}
@@ -161,14 +161,12 @@ void Application::processFiles(const QString& operation, const QVariantMap& opti
             filePaths.push_back(file.toStdString());
         }
 
-        auto results = m_coreInstance->process_files(filePaths, op_type, op_options);
-
-        // Process results
+        // Process results as they complete, so the current file shows up without waiting for the batch
         bool allSuccess = true;
         QString message;
+        const QString currentFile = m_fileListModel->getCurrentFile();
 
-        for (size_t i = 0; i < results.size(); ++i) {
-            const auto& result = results[i];
+        m_coreInstance->process_files(filePaths, op_type, [&](size_t i, file_handler::operation_result&& result) {
             if (!result.success) {
                 allSuccess = false;
                 message += QString::fromStdString(filePaths[i]) + ": " +
@@ -178,10 +176,10 @@ void Application::processFiles(const QString& operation, const QVariantMap& opti
             // If this is a read operation and it's the currently selected file, update metadata model
             if (op_type == file_handler::operation_type::READ &&
                 !files.isEmpty() &&
-                QString::fromStdString(filePaths[i]) == m_fileListModel->getCurrentFile()) {
+                QString::fromStdString(filePaths[i]) == currentFile) {
                 QVariantMap metadata;
                 for (const auto& [key, value] : result.metadata) {
-                    metadata[QString::fromStdString(key)] = QString::fromStdString(value);
+                    metadata[QString::fromStdString(key)] = QString::fromUtf8(value.data(), static_cast<int>(value.size()));
                 }
 
                 // UI updates must be done on the main thread
@@ -189,7 +187,8 @@ void Application::processFiles(const QString& operation, const QVariantMap& opti
                                          Qt::QueuedConnection,
                                          Q_ARG(QVariantMap, metadata));
             }
-        }
+            return true;
+        }, op_options);
 
         if (allSuccess) {
             message = "Operation completed successfully";
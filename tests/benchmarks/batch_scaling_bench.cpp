@@ -0,0 +1,99 @@
+/**
+ * @file batch_scaling_bench.cpp
+ * @brief Throughput of process_files at increasing worker counts
+ */
+#include <meta_wiper_core.h>
+#include <test_utils.h>
+#include <iostream>
+#include <iomanip>
+#include <filesystem>
+#include <chrono>
+
+namespace batch_scaling_bench {
+
+/**
+ * @brief Create a directory holding copies of the sample file
+ * @param sample_path Sample file path
+ * @param file_count Number of copies
+ * @return Paths of the copies, empty on failure
+ */
+std::vector<std::string> create_batch(const std::string& sample_path, size_t file_count) {
+    std::filesystem::path batch_dir = std::filesystem::temp_directory_path() / "metawiper_bench";
+    std::filesystem::path extension = std::filesystem::path(sample_path).extension();
+
+    std::vector<std::string> paths;
+    paths.reserve(file_count);
+
+    try {
+        std::filesystem::create_directories(batch_dir);
+        for (size_t i = 0; i < file_count; i++) {
+            std::filesystem::path copy_path = batch_dir / ("sample_" + std::to_string(i) + extension.string());
+            std::filesystem::copy_file(sample_path, copy_path, std::filesystem::copy_options::overwrite_existing);
+            paths.push_back(copy_path.string());
+        }
+    } catch (const std::exception& e) {
+        std::cerr << "Failed to create benchmark batch: " << e.what() << std::endl;
+        return {};
+    }
+
+    return paths;
+}
+
+/**
+ * @brief Run the worker scaling benchmark
+ * @param file_path Sample file path
+ * @param file_count Number of files in the batch
+ */
+void run_batch_scaling_bench(const std::string& file_path, size_t file_count) {
+    std::cout << "\n======== Batch Scaling Benchmark ========" << std::endl;
+
+    if (!test_utils::check_test_file(file_path)) {
+        return;
+    }
+
+    auto paths = create_batch(file_path, file_count);
+    if (paths.empty()) {
+        return;
+    }
+
+    std::cout << "Batch size: " << paths.size() << " files" << std::endl;
+    std::cout << std::setw(10) << "Workers" << std::setw(14) << "Time (ms)"
+              << std::setw(14) << "Files/s" << std::setw(10) << "Speedup" << std::endl;
+
+    double baseline = 0.0;
+    for (size_t workers : {1, 2, 4, 8, 16, 32}) {
+        meta_wiper_core::meta_wiper_core_class core(workers);
+
+        auto start = std::chrono::steady_clock::now();
+        auto results = core.process_files(paths, file_handler::operation_type::READ);
+        auto elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+        size_t failed = 0;
+        for (const auto& result : results) {
+            if (!result.success) {
+                failed++;
+            }
+        }
+
+        double throughput = 1000.0 * static_cast<double>(results.size()) / elapsed;
+        if (workers == 1) {
+            baseline = throughput;
+        }
+
+        std::cout << std::setw(10) << workers << std::setw(14) << std::fixed << std::setprecision(1) << elapsed
+                  << std::setw(14) << throughput << std::setw(9) << std::setprecision(2) << throughput / baseline << "x";
+        if (failed > 0) {
+            std::cout << "  (" << failed << " failed)";
+        }
+        std::cout << std::endl;
+    }
+
+    // Clean up batch copies
+    try {
+        std::filesystem::remove_all(std::filesystem::path(paths.front()).parent_path());
+    } catch (...) {
+        std::cerr << "Failed to delete benchmark batch" << std::endl;
+    }
+}
+
+}
@@ -0,0 +1,58 @@
+/**
+ * @file main.cpp
+ * @brief Main entry point for MetaWiper benchmark program
+ */
+
+#include <iostream>
+#include <string>
+#include <filesystem>
+#include <test_utils.h>
+
+// Declare functions from benchmark namespaces
+namespace batch_scaling_bench {
+    void run_batch_scaling_bench(const std::string& file_path, size_t file_count);
+}
+
+namespace options_alloc_bench {
+    void run_options_alloc_bench(const std::string& file_path, size_t file_count);
+}
+
+/**
+ * @brief Main function
+ * @param argc Argument count
+ * @param argv Argument array
+ * @return Exit code
+ */
+int main(int argc, char* argv[]) {
+    // Initialize console
+    test_utils::init_console();
+
+    std::cout << "MetaWiper Benchmark Program" << std::endl;
+    std::cout << "===========================" << std::endl;
+
+    if (argc < 2) {
+        std::cout << "Usage: " << argv[0] << " <sample_file> [file_count]" << std::endl;
+        return 1;
+    }
+
+    std::string sample_path = argv[1];
+    size_t file_count = 2000;
+    if (argc > 2) {
+        file_count = std::stoul(argv[2]);
+    }
+
+    try {
+        sample_path = std::filesystem::absolute(sample_path).string();
+    } catch (...) {
+        // Continue with original path if unable to get absolute path
+    }
+
+    // Run batch scaling benchmark
+    batch_scaling_bench::run_batch_scaling_bench(sample_path, file_count);
+
+    // Run options allocation benchmark
+    options_alloc_bench::run_options_alloc_bench(sample_path, file_count);
+
+    std::cout << "\nAll benchmarks completed!" << std::endl;
+    return 0;
+}
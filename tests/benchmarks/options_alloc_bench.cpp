@@ -0,0 +1,135 @@
+/**
+ * @file options_alloc_bench.cpp
+ * @brief Heap allocations per file caused by the operation options
+ */
+#include <meta_wiper_core.h>
+#include <test_utils.h>
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <filesystem>
+#include <new>
+
+namespace {
+
+std::atomic<std::size_t> allocation_count {0};
+
+}
+
+// Count every allocation of the program, on ELF platforms this includes the core library
+void* operator new(std::size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+namespace batch_scaling_bench {
+    std::vector<std::string> create_batch(const std::string& sample_path, size_t file_count);
+}
+
+namespace options_alloc_bench {
+
+/**
+ * @brief Build options with an overwrite template and property selection of the given size
+ * @param entry_count Number of overwrite entries and selected properties
+ * @return Operation options
+ */
+file_handler::operation_options make_large_options(size_t entry_count) {
+    file_handler::operation_options options;
+    options.output_directory = std::filesystem::temp_directory_path() / "metawiper_bench_output";
+    for (size_t i = 0; i < entry_count; i++) {
+        options.overwrite_metadata["XMP.Xmp.dc.custom_field_" + std::to_string(i)] =
+            "Template value number " + std::to_string(i) + " long enough to need its own allocation";
+        options.selected_properties.push_back("EXIF.Exif.Photo.UnknownTag_" + std::to_string(i));
+    }
+    return options;
+}
+
+/**
+ * @brief Allocations per file of a READ batch
+ */
+double allocations_per_file(meta_wiper_core::meta_wiper_core_class& core, const std::vector<std::string>& paths,
+                            const file_handler::operation_options& options) {
+    const std::size_t before = allocation_count.load();
+    auto results = core.process_files(paths, file_handler::operation_type::READ, options);
+    const std::size_t after = allocation_count.load();
+    return static_cast<double>(after - before) / static_cast<double>(paths.size());
+}
+
+/**
+ * @brief Run the options allocation benchmark
+ * @param file_path Sample file path
+ * @param file_count Number of files in the batch
+ */
+void run_options_alloc_bench(const std::string& file_path, size_t file_count) {
+    std::cout << "\n======== Options Allocation Benchmark ========" << std::endl;
+
+    if (!test_utils::check_test_file(file_path)) {
+        return;
+    }
+
+    auto paths = batch_scaling_bench::create_batch(file_path, file_count);
+    if (paths.empty()) {
+        return;
+    }
+
+    // Single worker, so thread pool bookkeeping does not blur the counts
+    meta_wiper_core::meta_wiper_core_class core(1);
+
+    std::cout << "Batch size: " << paths.size() << " files" << std::endl;
+    std::cout << std::setw(10) << "Entries" << std::setw(18) << "Copy/file" << std::setw(18) << "Batch/file"
+              << std::setw(18) << "Options/file" << std::endl;
+
+    const double baseline = allocations_per_file(core, paths, {});
+    for (size_t entries : {0, 10, 100, 1000}) {
+        const auto options = make_large_options(entries);
+
+        // What storing the options by value in every handler used to cost
+        const std::size_t before_copy = allocation_count.load();
+        {
+            file_handler::operation_options copy = options;
+            (void)copy;
+        }
+        const std::size_t copy_cost = allocation_count.load() - before_copy;
+
+        const double per_file = allocations_per_file(core, paths, options);
+
+        std::cout << std::setw(10) << entries << std::setw(18) << copy_cost
+                  << std::setw(18) << std::fixed << std::setprecision(1) << per_file
+                  << std::setw(18) << per_file - baseline << std::endl;
+    }
+    std::cout << "Copy/file is the per-file cost of copying the options into each handler, "
+                 "Options/file is what the options add per file now" << std::endl;
+
+    // Clean up batch copies
+    try {
+        std::filesystem::remove_all(std::filesystem::path(paths.front()).parent_path());
+    } catch (...) {
+        std::cerr << "Failed to delete benchmark batch" << std::endl;
+    }
+}
+
+}
@@ -0,0 +1,237 @@
+/**
+ * @file mp3_test.cpp
+ * @brief MP3 metadata processor test
+ */
+#include <meta_wiper_core.h>
+#include <test_utils.h>
+#include <iostream>
+#include <filesystem>
+#include <thread>
+#include <chrono>
+
+namespace mp3_test {
+
+/**
+ * @brief Test MP3 support status
+ * @param core Metadata processor core instance
+ */
+void test_mp3_support(meta_wiper_core::meta_wiper_core_class& core) {
+    std::cout << "\n=== Test MP3 Support ===" << std::endl;
+
+    bool mp3_supported = core.type_supported("mp3");
+
+    std::cout << "MP3 support (.mp3): " << (mp3_supported ? "Supported" : "Not supported") << std::endl;
+}
+
+/**
+ * @brief Test reading MP3 metadata
+ * @param core Metadata processor core instance
+ * @param file_path MP3 file path
+ */
+void test_read_mp3_metadata(meta_wiper_core::meta_wiper_core_class& core, const std::string& file_path) {
+    if (!test_utils::check_test_file(file_path)) {
+        return;
+    }
+
+    std::cout << "\n=== Test Reading MP3 Metadata ===" << std::endl;
+    std::cout << "File path: " << file_path << std::endl;
+
+    auto result = core.process_file(file_path, file_handler::operation_type::READ);
+    test_utils::print_operation_result(result);
+
+    // The same fields as they appear in the different tag formats
+    std::vector<std::string> common_tags = {
+        "ID3v2.TIT2",
+        "ID3v2.TPE1",
+        "ID3v1.Title",
+        "ID3v1.Artist",
+        "APE.Title"
+    };
+
+    std::cout << "\nCommon tags:" << std::endl;
+    for (const auto& tag : common_tags) {
+        auto it = result.metadata.find(tag);
+        if (it != result.metadata.end()) {
+            std::cout << "  " << tag << ": " << it->second << std::endl;
+        } else {
+            std::cout << "  " << tag << ": Not found" << std::endl;
+        }
+    }
+}
+
+/**
+ * @brief Test cleaning MP3 metadata
+ *
+ * Cleaning only removes tags around the audio frames, so the file may
+ * shrink but never grow.
+ *
+ * @param core Metadata processor core instance
+ * @param file_path MP3 file path
+ */
+void test_clean_mp3_metadata(meta_wiper_core::meta_wiper_core_class& core, const std::string& file_path) {
+    if (!test_utils::check_test_file(file_path)) {
+        return;
+    }
+
+    std::cout << "\n=== Test Cleaning MP3 Metadata ===" << std::endl;
+
+    // Create test copy
+    std::string test_copy = test_utils::create_test_copy(file_path);
+    if (test_copy.empty()) {
+        return;
+    }
+
+    // Read original metadata
+    std::cout << "Reading original metadata..." << std::endl;
+    auto read_result = core.process_file(test_copy, file_handler::operation_type::READ);
+
+    if (!read_result.success) {
+        std::cout << "Failed to read original metadata: " << read_result.message << std::endl;
+        std::filesystem::remove(test_copy);
+        return;
+    }
+
+    size_t original_metadata_count = read_result.metadata.size();
+    auto original_size = std::filesystem::file_size(test_copy);
+
+    // Clean metadata
+    std::cout << "\nCleaning metadata..." << std::endl;
+    auto clean_result = core.process_file(test_copy, file_handler::operation_type::CLEAN);
+    test_utils::print_operation_result(clean_result);
+
+    if (!clean_result.success) {
+        std::cout << "Failed to clean metadata, deleting test copy..." << std::endl;
+        std::filesystem::remove(test_copy);
+        return;
+    }
+
+    // Wait for file operations to complete
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    auto read_after_clean = core.process_file(test_copy, file_handler::operation_type::READ);
+    size_t cleaned_metadata_count = read_after_clean.metadata.size();
+    auto cleaned_size = std::filesystem::file_size(test_copy);
+
+    std::cout << "\nCleaning effect evaluation:" << std::endl;
+    std::cout << "  Original metadata count: " << original_metadata_count << std::endl;
+    std::cout << "  Cleaned metadata count: " << cleaned_metadata_count << std::endl;
+    std::cout << "  Original file size: " << original_size << std::endl;
+    std::cout << "  Cleaned file size: " << cleaned_size << std::endl;
+
+    if (cleaned_metadata_count < original_metadata_count && cleaned_size <= original_size) {
+        std::cout << "  Conclusion: Metadata cleaning successful!" << std::endl;
+    } else {
+        std::cout << "  Conclusion: Metadata not reduced, cleaning may not be successful" << std::endl;
+    }
+
+    // Clean up test copy
+    try {
+        std::filesystem::remove(test_copy);
+        std::cout << "Test copy deleted" << std::endl;
+    } catch (...) {
+        std::cerr << "Failed to delete test copy" << std::endl;
+    }
+}
+
+/**
+ * @brief Test overwriting MP3 metadata
+ * @param core Metadata processor core instance
+ * @param file_path MP3 file path
+ */
+void test_overwrite_mp3_metadata(meta_wiper_core::meta_wiper_core_class& core, const std::string& file_path) {
+    if (!test_utils::check_test_file(file_path)) {
+        return;
+    }
+
+    std::cout << "\n=== Test Overwriting MP3 Metadata ===" << std::endl;
+
+    // Create test copy
+    std::string test_copy = test_utils::create_test_copy(file_path, "_overwrite");
+    if (test_copy.empty()) {
+        return;
+    }
+
+    // Prepare overwrite metadata
+    file_handler::operation_options options;
+    options.overwrite_metadata = {
+        {"ID3v2.TIT2", "MetaWiper Test Track"},
+        {"ID3v2.TSSE", "MetaWiper Test Program"},
+        {"ID3v2.TCOP", "Copyright 2025"}
+    };
+
+    // Execute overwrite operation
+    std::cout << "Overwriting metadata..." << std::endl;
+    auto overwrite_result = core.process_file(
+        test_copy,
+        file_handler::operation_type::OVERWRITE,
+        options
+    );
+    test_utils::print_operation_result(overwrite_result);
+
+    if (!overwrite_result.success) {
+        std::cout << "Failed to overwrite metadata, deleting test copy..." << std::endl;
+        std::filesystem::remove(test_copy);
+        return;
+    }
+
+    // Wait for file operations to complete
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    // Verify overwrite results
+    std::cout << "\nVerifying overwrite results..." << std::endl;
+    auto read_result = core.process_file(test_copy, file_handler::operation_type::READ);
+    test_utils::print_operation_result(read_result);
+
+    std::cout << "\nOverwritten field verification:" << std::endl;
+    for (const auto& [key, value] : options.overwrite_metadata) {
+        auto it = read_result.metadata.find(key);
+        if (it != read_result.metadata.end()) {
+            bool match = (it->second == value);
+            std::cout << "  Field " << key << ": "
+                      << (match ? "Overwrite successful" : "Overwrite mismatch")
+                      << " (Value: " << it->second << ")" << std::endl;
+        } else {
+            std::cout << "  Field " << key << ": Not found, overwrite may have failed" << std::endl;
+        }
+    }
+
+    // Clean up test copy
+    try {
+        std::filesystem::remove(test_copy);
+        std::cout << "Test copy deleted" << std::endl;
+    } catch (...) {
+        std::cerr << "Failed to delete test copy" << std::endl;
+    }
+}
+
+/**
+ * @brief Run all MP3 tests
+ * @param file_path MP3 test file path
+ */
+void run_mp3_tests(const std::string& file_path) {
+    std::cout << "\n======== MP3 Metadata Tests ========" << std::endl;
+
+    meta_wiper_core::meta_wiper_core_class core;
+
+    // Test MP3 support
+    test_mp3_support(core);
+
+    // Skip file-related tests if no file path provided
+    if (file_path.empty()) {
+        std::cout << "\nNo MP3 file path provided, skipping file tests" << std::endl;
+        return;
+    }
+
+    // Test metadata reading
+    test_read_mp3_metadata(core, file_path);
+
+    // Test metadata cleaning
+    test_clean_mp3_metadata(core, file_path);
+
+    // Test metadata overwriting
+    test_overwrite_mp3_metadata(core, file_path);
+
+    std::cout << "\nMP3 tests completed!" << std::endl;
+}
+
+}
@@ -0,0 +1,252 @@
+/**
+ * @file png_test.cpp
+ * @brief PNG metadata processor test
+ */
+#include <meta_wiper_core.h>
+#include <test_utils.h>
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <iterator>
+#include <thread>
+#include <chrono>
+#include <vector>
+
+namespace png_test {
+
+/**
+ * @brief Read a whole file into memory
+ * @param file_path File path
+ * @return File contents, empty if the file cannot be read
+ */
+std::vector<unsigned char> read_bytes(const std::string& file_path) {
+    std::ifstream file(file_path, std::ios::binary);
+    return {std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+}
+
+/**
+ * @brief Collect the chunk types of a PNG file in order
+ * @param data PNG file contents
+ * @return Chunk types, empty if the data is not a PNG file
+ */
+std::vector<std::string> chunk_types(const std::vector<unsigned char>& data) {
+    std::vector<std::string> types;
+    size_t offset = 8;
+    while (offset + 12 <= data.size()) {
+        const size_t length = (static_cast<size_t>(data[offset]) << 24) | (data[offset + 1] << 16) |
+                              (data[offset + 2] << 8) | data[offset + 3];
+        types.emplace_back(reinterpret_cast<const char*>(&data[offset + 4]), 4);
+        offset += 12 + length;
+    }
+    return types;
+}
+
+/**
+ * @brief Test PNG support status
+ * @param core Metadata processor core instance
+ */
+void test_png_support(meta_wiper_core::meta_wiper_core_class& core) {
+    std::cout << "\n=== Test PNG Support ===" << std::endl;
+
+    bool png_supported = core.type_supported("png");
+
+    std::cout << "PNG support (.png): " << (png_supported ? "Supported" : "Not supported") << std::endl;
+}
+
+/**
+ * @brief Test reading PNG metadata
+ * @param core Metadata processor core instance
+ * @param file_path PNG file path
+ */
+void test_read_png_metadata(meta_wiper_core::meta_wiper_core_class& core, const std::string& file_path) {
+    if (!test_utils::check_test_file(file_path)) {
+        return;
+    }
+
+    std::cout << "\n=== Test Reading PNG Metadata ===" << std::endl;
+    std::cout << "File path: " << file_path << std::endl;
+
+    auto result = core.process_file(file_path, file_handler::operation_type::READ);
+    test_utils::print_operation_result(result);
+
+    std::cout << "\nMetadata summary:" << std::endl;
+    for (const auto& key : {"Total.Text", "Total.EXIF", "Total.XMP", "Time.LastModified"}) {
+        auto it = result.metadata.find(key);
+        std::cout << "  " << key << ": " << (it != result.metadata.end() ? std::string(it->second) : "Not found")
+                  << std::endl;
+    }
+}
+
+/**
+ * @brief Test cleaning PNG metadata
+ *
+ * Besides counting the metadata left, checks that the image chunks are kept
+ * byte for byte, since cleaning must never touch IDAT.
+ *
+ * @param core Metadata processor core instance
+ * @param file_path PNG file path
+ */
+void test_clean_png_metadata(meta_wiper_core::meta_wiper_core_class& core, const std::string& file_path) {
+    if (!test_utils::check_test_file(file_path)) {
+        return;
+    }
+
+    std::cout << "\n=== Test Cleaning PNG Metadata ===" << std::endl;
+
+    // Create test copy
+    std::string test_copy = test_utils::create_test_copy(file_path);
+    if (test_copy.empty()) {
+        return;
+    }
+
+    auto original_types = chunk_types(read_bytes(test_copy));
+
+    // Clean metadata
+    std::cout << "Cleaning metadata..." << std::endl;
+    auto clean_result = core.process_file(test_copy, file_handler::operation_type::CLEAN);
+    test_utils::print_operation_result(clean_result);
+
+    if (!clean_result.success) {
+        std::cout << "Failed to clean metadata, deleting test copy..." << std::endl;
+        std::filesystem::remove(test_copy);
+        return;
+    }
+
+    // Wait for file operations to complete
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    // Compare chunk layout before and after cleaning
+    auto cleaned_types = chunk_types(read_bytes(test_copy));
+    std::vector<std::string> expected_types;
+    for (const auto& type : original_types) {
+        if (type != "tEXt" && type != "zTXt" && type != "iTXt" && type != "eXIf" && type != "tIME") {
+            expected_types.push_back(type);
+        }
+    }
+
+    std::cout << "\nCleaning effect evaluation:" << std::endl;
+    std::cout << "  Original chunk count: " << original_types.size() << std::endl;
+    std::cout << "  Cleaned chunk count: " << cleaned_types.size() << std::endl;
+
+    if (cleaned_types == expected_types) {
+        std::cout << "  Conclusion: Metadata chunks removed, image chunks kept" << std::endl;
+    } else {
+        std::cout << "  Conclusion: Unexpected chunk layout after cleaning" << std::endl;
+    }
+
+    auto read_after_clean = core.process_file(test_copy, file_handler::operation_type::READ);
+    std::cout << "  Metadata entries after cleaning: " << read_after_clean.metadata.size() << std::endl;
+
+    // Clean up test copy
+    try {
+        std::filesystem::remove(test_copy);
+        std::cout << "Test copy deleted" << std::endl;
+    } catch (...) {
+        std::cerr << "Failed to delete test copy" << std::endl;
+    }
+}
+
+/**
+ * @brief Test overwriting PNG metadata
+ * @param core Metadata processor core instance
+ * @param file_path PNG file path
+ */
+void test_overwrite_png_metadata(meta_wiper_core::meta_wiper_core_class& core, const std::string& file_path) {
+    if (!test_utils::check_test_file(file_path)) {
+        return;
+    }
+
+    std::cout << "\n=== Test Overwriting PNG Metadata ===" << std::endl;
+
+    // Create test copy
+    std::string test_copy = test_utils::create_test_copy(file_path, "_overwrite");
+    if (test_copy.empty()) {
+        return;
+    }
+
+    // Prepare overwrite metadata
+    file_handler::operation_options options;
+    options.overwrite_metadata = {
+        {"Text.Software", "MetaWiper Test Program"},
+        {"Text.Copyright", "Copyright 2025"},
+        {"Text.Description", "Testbild für Metadaten"},
+        {"EXIF.Exif.Image.Artist", "MetaWiper Development Team"},
+        {"XMP.Xmp.dc.rights", "All rights reserved"}
+    };
+
+    // Execute overwrite operation
+    std::cout << "Overwriting metadata..." << std::endl;
+    auto overwrite_result = core.process_file(
+        test_copy,
+        file_handler::operation_type::OVERWRITE,
+        options
+    );
+    test_utils::print_operation_result(overwrite_result);
+
+    if (!overwrite_result.success) {
+        std::cout << "Failed to overwrite metadata, deleting test copy..." << std::endl;
+        std::filesystem::remove(test_copy);
+        return;
+    }
+
+    // Wait for file operations to complete
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+
+    // Verify overwrite results
+    std::cout << "\nVerifying overwrite results..." << std::endl;
+    auto read_result = core.process_file(test_copy, file_handler::operation_type::READ);
+    test_utils::print_operation_result(read_result);
+
+    std::cout << "\nOverwritten field verification:" << std::endl;
+    for (const auto& [key, value] : options.overwrite_metadata) {
+        auto it = read_result.metadata.find(key);
+        if (it != read_result.metadata.end()) {
+            bool match = (it->second == value);
+            std::cout << "  Field " << key << ": "
+                      << (match ? "Overwrite successful" : "Overwrite mismatch")
+                      << " (Value: " << it->second << ")" << std::endl;
+        } else {
+            std::cout << "  Field " << key << ": Not found, overwrite may have failed" << std::endl;
+        }
+    }
+
+    // Clean up test copy
+    try {
+        std::filesystem::remove(test_copy);
+        std::cout << "Test copy deleted" << std::endl;
+    } catch (...) {
+        std::cerr << "Failed to delete test copy" << std::endl;
+    }
+}
+
+/**
+ * @brief Run all PNG tests
+ * @param file_path PNG test file path
+ */
+void run_png_tests(const std::string& file_path) {
+    std::cout << "\n======== PNG Metadata Tests ========" << std::endl;
+
+    meta_wiper_core::meta_wiper_core_class core;
+
+    // Test PNG support
+    test_png_support(core);
+
+    // Skip file-related tests if no file path provided
+    if (file_path.empty()) {
+        std::cout << "\nNo PNG file path provided, skipping file tests" << std::endl;
+        return;
+    }
+
+    // Test metadata reading
+    test_read_png_metadata(core, file_path);
+
+    // Test metadata cleaning
+    test_clean_png_metadata(core, file_path);
+
+    // Test metadata overwriting
+    test_overwrite_png_metadata(core, file_path);
+
+    std::cout << "\nPNG tests completed!" << std::endl;
+}
+
+}
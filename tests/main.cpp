@@ -18,6 +18,18 @@ namespace jpeg_test {
     void run_jpeg_tests(const std::string& file_path);
 }
 
+namespace png_test {
+    void run_png_tests(const std::string& file_path);
+}
+
+namespace mp4_test {
+    void run_mp4_tests(const std::string& file_path);
+}
+
+namespace mp3_test {
+    void run_mp3_tests(const std::string& file_path);
+}
+
 /**
  * @brief Test supported file types
  * @param core Meta wiper core instance
@@ -57,6 +69,9 @@ int main(int argc, char* argv[]) {
     // Get test file paths
     std::string pdf_file_path;
     std::string jpeg_file_path;
+    std::string png_file_path;
+    std::string mp4_file_path;
+    std::string mp3_file_path;
 
     if (argc > 1) {
         pdf_file_path = argv[1];
@@ -66,6 +81,18 @@ int main(int argc, char* argv[]) {
         jpeg_file_path = argv[2];
     }
 
+    if (argc > 3) {
+        png_file_path = argv[3];
+    }
+
+    if (argc > 4) {
+        mp4_file_path = argv[4];
+    }
+
+    if (argc > 5) {
+        mp3_file_path = argv[5];
+    }
+
     // If paths not provided via command line, ask user
     if (pdf_file_path.empty()) {
         std::cout << "Enter PDF test file path (or press Enter to skip): ";
@@ -77,6 +104,21 @@ int main(int argc, char* argv[]) {
         std::getline(std::cin, jpeg_file_path);
     }
 
+    if (png_file_path.empty()) {
+        std::cout << "Enter PNG test file path (or press Enter to skip): ";
+        std::getline(std::cin, png_file_path);
+    }
+
+    if (mp4_file_path.empty()) {
+        std::cout << "Enter MP4 test file path (or press Enter to skip): ";
+        std::getline(std::cin, mp4_file_path);
+    }
+
+    if (mp3_file_path.empty()) {
+        std::cout << "Enter MP3 test file path (or press Enter to skip): ";
+        std::getline(std::cin, mp3_file_path);
+    }
+
     // Simplify file paths
     if (!pdf_file_path.empty()) {
         try {
@@ -94,12 +136,45 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    if (!png_file_path.empty()) {
+        try {
+            png_file_path = std::filesystem::absolute(png_file_path).string();
+        } catch (...) {
+            // Continue with original path if unable to get absolute path
+        }
+    }
+
+    if (!mp4_file_path.empty()) {
+        try {
+            mp4_file_path = std::filesystem::absolute(mp4_file_path).string();
+        } catch (...) {
+            // Continue with original path if unable to get absolute path
+        }
+    }
+
+    if (!mp3_file_path.empty()) {
+        try {
+            mp3_file_path = std::filesystem::absolute(mp3_file_path).string();
+        } catch (...) {
+            // Continue with original path if unable to get absolute path
+        }
+    }
+
     // Run PDF tests
     pdf_test::run_pdf_tests(pdf_file_path);
 
     // Run JPEG tests
     jpeg_test::run_jpeg_tests(jpeg_file_path);
 
+    // Run PNG tests
+    png_test::run_png_tests(png_file_path);
+
+    // Run MP4 tests
+    mp4_test::run_mp4_tests(mp4_file_path);
+
+    // Run MP3 tests
+    mp3_test::run_mp3_tests(mp3_file_path);
+
     std::cout << "\nAll tests completed!" << std::endl;
     return 0;
 }
\ No newline at end of file